@@ -11,6 +11,11 @@
 #include <fstream>
 #include <chrono>
 #include <array>
+#include <vector>
+
+#if defined(__SSE2__)
+# include <emmintrin.h>
+#endif
 
 #include "Exception.hpp"
 #include "Controller.hpp"
@@ -40,6 +45,7 @@ public:
     bool                pointInFustrum( const glm::vec3& p );
     bool                sphereInFustrum( const glm::vec3& p, float radius );
     bool                aabInFustrum( const glm::vec3& p, const glm::vec3& size );
+    void                aabsInFustrum( const float* x, const float* y, const float* z, const glm::vec3& size, size_t count, std::vector<uint32_t>& visible ) const;
     
     /* Setters */
     void                setFov( float fov );
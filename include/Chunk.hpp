@@ -14,9 +14,14 @@
 #include <algorithm>
 
 #include "Exception.hpp"
+#include "GLState.hpp"
 #include "Shader.hpp"
 #include "Camera.hpp"
 #include "utils.hpp"
+#include "Pool.hpp"
+#include "MemoryGovernor.hpp"
+#include "ComputeMesher.hpp"
+#include "UploadRing.hpp"
 
 /* we could optimize that */
 typedef struct  point_s {
@@ -27,41 +32,115 @@ typedef struct  point_s {
     int         light; // for now we have infos about which faces receiving light (4bits of info for 6 faces, 24bits used)
 }               point_t;
 
+/*  a visible face of a point, read by the face vertex shader (see face.vert.glsl):
+    position: x, y, z (8 bits each), face (3 bits, +x -x +y -y +z -z), flipped quad (1 bit), underwater (1 bit)
+    attributes: bloc id (8 bits), corners ao (8 bits), light (4 bits)
+*/
+typedef struct  face_s {
+    uint32_t    position;
+    uint32_t    attributes;
+}               face_t;
+
 typedef struct  mesh_s {
     GLuint               vao;
     GLuint               vbo;
     std::vector<point_t> voxels;
+    GLuint               faceVao;       /* the faces of the points, built on their first draw (0 until then) */
+    GLuint               faceVbo;
+    GLuint               faceTexture;   /* the buffer texture over the faces */
+    GLsizei              faces;
+    GLsizei              faceFirst[7];  /* the faces grouped by direction, the faces of f are [faceFirst[f], faceFirst[f + 1]) */
 }               mesh_t;
 
 class Chunk {
 
 public:
     Chunk( const glm::vec3& position, const glm::ivec3& chunkSize, const uint8_t* texture, const uint margin );
+    Chunk( const glm::vec3& position, const glm::ivec3& chunkSize, uint8_t uniformId, const uint margin );
+    Chunk( const glm::vec3& position, const glm::ivec3& chunkSize, const std::vector<uint8_t>& data, const uint margin );
     ~Chunk( void );
 
-    void                buildMesh( void );
-    void                rebuildMesh( void );
+    static void*        operator new( size_t size );
+    static void         operator delete( void* ptr, size_t size );
+
+    void                buildMesh( const std::array<Chunk*, 6>& neighbouringChunks );
+    void                rebuildMesh( const std::array<Chunk*, 6>& neighbouringChunks );
 
     void                computeWater( const std::array<Chunk*, 6>& neighbouringChunks );
     void                computeLight( const std::array<Chunk*, 6>& neighbouringChunks, const uint8_t* aboveLightMask );
-    void                render( Shader shader, Camera& camera, GLuint textureAtlas, uint renderDistance, int underwater );
+    const bool          isInView( Camera& camera, uint renderDistance );
+    const uint          renderOpaque( Camera& camera, bool faces );
+    const uint          renderTransparent( Camera& camera, bool faces );
+    void                serialize( std::vector<uint8_t>& data ) const;
+    static const bool   isSerializedValid( const std::vector<uint8_t>& data, const glm::ivec3& chunkSize, const uint margin );
+    void                addMemoryUsage( memoryUsage_t& usage ) const;
     /* getters */
     const glm::vec3&    getPosition( void ) const { return position; };
-    const uint8_t*      getTexture( void ) const { return texture; };
-    const uint8_t*      getLightMask( void ) const { return lightMask; };
-    const uint8_t*      getLightMap( void ) const { return lightMap; };
+    const uint8_t*      getLightMask( void ) const;
+    /* padded index accessors (i = (x+m) + (z+m) * paddedSize.x + (y+m) * y_step) */
+    const uint8_t       getVoxel( int i ) const;
+    const uint8_t       getLight( int i ) const;
     const int           getSidesWaterUpdate( void ) const { return sidesWaterUpdate; };
     const int           getSidesLightUpdate( void ) const { return sidesLightUpdate; };
+    const int           getLodLevel( void ) const { return lodLevel; };
+    const uint          getPointsCount( void ) const { return mesh_opaque.voxels.size() + mesh_transparent.voxels.size(); };
+    const uint          getDrawCalls( void ) const { return (mesh_opaque.voxels.size() > 0) + (mesh_transparent.voxels.size() > 0); };
+    /* the faces of the face renderer (0 until first drawn with it) */
+    const uint          getFacesCount( void ) const { return mesh_opaque.faces + mesh_transparent.faces; };
+    /* the faces and draw commands of the chunk are on the GPU, built by the compute mesher (see ComputeMesher) */
+    const bool          isComputeMeshed( void ) const { return computeMeshed; };
+    /* the mesh was built by the other meshing path than the one selected (the chunk is remeshed, see Terrain::updateChunkLods) */
+    const bool          isMeshPathChanged( void ) const { return meshed && !uniform && lodLevel == 0 && computeMeshed != (computeMesher != nullptr && computeMeshing); };
+    /* meshed by the other path, its compute mesh did not fit the arena, or the seams with its neighbours changed */
+    const bool          isRemeshNeeded( void ) const { return isMeshPathChanged() || seamsChanged || (computeMeshed && computeMesher->isFailed(instance)); };
+    /* the border faces toward the neighbour are drawn as skirts, their meshes are not at the same level (see openSeams) */
+    const bool          isSeamOpen( const Chunk* neighbour ) const { return neighbour != nullptr && !uniform && !neighbour->uniform && neighbour->lodLevel != lodLevel; };
+    /* a neighbour switched level, the seams are opened or closed by the next remesh */
+    void                setSeamsChanged( void ) { seamsChanged = true; };
+    /* the two sides are connected by transparent voxels (sides in the neighbours order: +x, -x, +y, -y, +z, -z) */
+    const bool          isConnected( int from, int to ) const { return ((connectivity[from] >> to) & 0x1) != 0; };
+    /* the layers [x, y) only made of opaque blocs, an occluder box inside the chunk (empty until meshed) */
+    const glm::ivec2&   getOccluderLayers( void ) const { return occluderLayers; };
+    /* the world bounds of the meshes (empty, min > max, when there is nothing to draw) */
+    const glm::vec3&    getGeometryMin( void ) const { return geometryMin; };
+    const glm::vec3&    getGeometryMax( void ) const { return geometryMax; };
+    void                setLodLevel( int level );
     /* state checks */
     const bool          isMeshed( void ) const { return meshed; };
     const bool          isLighted( void ) const { return lighted; };
     const bool          isUnderground( void ) const { return underground; };
     const bool          isOutOfRange( void ) const { return outOfRange; };
+    void                setOutOfRange( bool t ) { outOfRange = t; };
+    const uint64_t      getRenderFrame( void ) const { return renderFrame; };
+    void                setRenderFrame( uint64_t frame ) { renderFrame = frame; };
+    const bool          isUniform( void ) const { return uniform; };
+    const bool          isModified( void ) const { return modified; };
+    void                setModified( bool t ) { modified = t; };
+    /* generated from the coarse lattice, the chunk is not saved (see Terrain::saveChunk) */
+    const bool          isApproximate( void ) const { return approximate; };
+    void                setApproximate( bool t ) { approximate = t; };
     const bool          isBorder( int i );
     const bool          isMaskZero( const uint8_t* mask );
+    const bool          isMaskFull( const uint8_t* mask );
 
+    static uint         materializedCount; /* uniform chunks that had to allocate their buffers */
+    static uint         computeMeshedCount; /* chunks drawn from the compute mesher */
+    /* the mesher drawing the compute meshes, and whether the next full resolution meshes are built with it */
+    static void         setComputeMesher( ComputeMesher* mesher, bool enabled ) { computeMesher = mesher; computeMeshing = enabled; };
+    /* the ring the meshes are uploaded through, set before the first mesh */
+    static void         setUploadRing( UploadRing* ring ) { uploadRing = ring; };
+    static const int    lodLevels = 3;     /* full resolution, 2x and 4x downsampled meshes */
 
 private:
+    /* the per chunk vertex attribute (the offset and scale of its cells), one vec4 per chunk */
+    static GLuint                   instanceBuffer;
+    static size_t                   instanceCapacity;
+    static std::vector<glm::vec4>   instances;
+    static std::vector<int>         freeInstances;
+    static ComputeMesher*           computeMesher;
+    static bool                     computeMeshing;
+    static UploadRing*              uploadRing;
+
     /* using heap allocated pointer to type is slightly faster, but messier (~80ms win on 800 chunks, so 0.1ms/chunk) */
     mesh_t              mesh_opaque;
     mesh_t              mesh_transparent;
@@ -69,22 +148,68 @@ private:
     glm::vec3           position;
     glm::ivec3          chunkSize;  /* the chunk size */
     glm::ivec3          paddedSize; /* the chunk padded size (bigger because we have adjacent bloc informations) */
-    uint8_t*            texture;    /* the texture outputed by the chunk generation shader */
+    uint8_t*            blocs;      /* the bloc ids of the chunk (chunkSize, no margin) */
+    uint8_t*            light;      /* the light values of the chunk (chunkSize, no margin) */
+    uint8_t*            shellBlocs; /* the one voxel ring around the chunk, as generated or last seen (see getShellIndex) */
+    uint8_t*            shellLight;
     uint8_t*            lightMask;  /* the light mask used for the lighting pass */
-    uint8_t*            lightMap;
+    uint8_t*            texture;    /* the padded bloc ids gathered with the neighbours (only valid between gatherHalo and releaseHalo) */
+    uint8_t*            lightMap;   /* the padded light values gathered with the neighbours */
     uint                margin;     /* the texture margin */
     bool                meshed;
     bool                lighted;
     bool                underground;
     bool                outOfRange;
     bool                firstLightPass;
+    bool                uniform;        /* the chunk is made of a single bloc type and owns no voxel buffers */
+    uint8_t             uniformId;      /* the bloc id of a uniform chunk */
+    uint8_t             uniformLight;   /* the light value of a uniform chunk */
+    uint8_t             uniformMask;    /* the light-mask value of a uniform chunk */
+    bool                modified;       /* the state changed since it was generated, loaded or saved */
+    bool                approximate;    /* generated from the coarse lattice instead of the full resolution fields */
+    int                 lodLevel;       /* the meshes group the voxels by cells of (1 << lodLevel) voxels per side */
+    bool                seamsChanged;   /* a neighbour switched level since the last mesh */
+    std::array<uint8_t, 6>  connectivity;   /* per side, the sides reached through the transparent voxels (all of them until meshed) */
+    glm::ivec2          occluderLayers; /* the longest run of opaque layers */
+    glm::vec3           geometryMin;
+    glm::vec3           geometryMax;
+    uint64_t            renderFrame;    /* the terrain render list stamp (see Terrain::updateRenderList) */
+    int                 instance;       /* the slot of the chunk in the instance buffer (-1 until its first mesh) */
+    bool                computeMeshed;  /* the meshes are in the slot of the instance in the compute mesher */
     int                 y_step;
     int                 sidesWaterUpdate;
     int                 sidesLightUpdate;
 
     void                setupMesh( mesh_t* mesh, int mode );
+    void                updateInstance( void );
+    void                setupFaces( mesh_t* mesh );
+    void                setupFaceArray( mesh_t* mesh );
+    void                releaseFaces( mesh_t* mesh );
+    const uint          renderFaces( mesh_t* mesh, const glm::vec3& eye );
+    const uint8_t       getFacingDirections( const glm::vec3& eye ) const;
+    void                buildLodMesh( const std::array<Chunk*, 6>& neighbouringChunks );
+    void                buildComputeMesh( const std::array<Chunk*, 6>& neighbouringChunks );
+    const uint          renderComputeMesh( bool transparent, const glm::vec3& eye );
+    void                computeConnectivity( void );
+    void                computeOccluderLayers( void );
+    void                computeGeometryBounds( void );
+    void                getLodCell( const std::array<Chunk*, 6>& neighbouringChunks, int x, int y, int z, uint8_t& bloc, uint8_t& cellLight ) const;
+    void                openSeams( const std::array<Chunk*, 6>& neighbouringChunks, uint8_t* grid, uint8_t* gridLight, const glm::ivec3& n, int offset, int zStep, int yStep ) const;
 
     void                createModelTransform( const glm::vec3& position );
+    void                materialize( void );
+    const int           getShellSize( void ) const;
+    const int           getShellIndex( int x, int y, int z ) const;
+    template <typename F>
+    void                forEachShellVoxel( const F& f ) const;
+    const uint8_t       voxelAt( int x, int y, int z ) const;
+    const uint8_t       lightAt( int x, int y, int z ) const;
+    void                splitPadded( const uint8_t* padded, uint8_t* volume, uint8_t* shell ) const;
+    void                gatherHalo( const std::array<Chunk*, 6>& neighbouringChunks );
+    void                scatterHalo( void );
+    void                releaseHalo( void );
+    template <typename F>
+    const bool          isNeighbourBorderMatching( const std::array<Chunk*, 6>& neighbouringChunks, int minY, const F& predicate ) const;
     const bool          isVoxelTransparent( int i ) const;
     const bool          isVoxelCulled( int i ) const;
     const bool          isVoxelCulledTransparent( int i ) const;
@@ -103,8 +228,11 @@ private:
     
     Rendering optimisations :
     * view fustrum chunk occlusion (don't render chunks outside the camera fustrum)
+    * cave culling (don't render chunks the camera can't see through transparent voxels, see Terrain::computeVisibleChunks)
+    * occlusion culling (don't render chunks hidden behind the opaque layers of nearer chunks, see OcclusionBuffer)
     * don't render empty chunks
+    * level of detail (distant chunks are meshed from 2x or 4x downsampled voxels)
+    * uniform chunks (only air, or only one solid bloc) skip buffers, lighting and meshing
 */
 
-// TODO : implement occlusion culling (don't render chunks that are occluded entirely by other chunks)
 // TODO : implement multi-threading for chunk generation and meshing (we'll see when it becomes a bottleneck)
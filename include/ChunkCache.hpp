@@ -0,0 +1,57 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <iostream>
+#include <vector>
+#include <list>
+#include <unordered_map>
+
+#include "Region.hpp"
+
+typedef struct  cacheEntry_s {
+    glm::vec3               position;   /* chunk position (in chunk space) */
+    std::vector<uint8_t>    payload;    /* the packed serialized chunk */
+    bool                    modified;   /* not saved in the region files yet */
+}               cacheEntry_t;
+
+typedef struct  cacheStats_s {
+    uint64_t    hits;
+    uint64_t    misses;
+    uint64_t    inserted;
+    uint64_t    dropped;    /* entries dropped to stay under the limits */
+    uint64_t    written;    /* dropped entries written to the region files */
+}               cacheStats_t;
+
+/*  LRU cache of the evicted chunks, kept compressed in memory. A chunk coming back into range is taken
+    out of the cache instead of being generated (or read from the region files) and relighted again.
+    The modified chunks dropped from the cache are written to the region files.
+*/
+class ChunkCache {
+
+public:
+    ChunkCache( RegionStore* regionStore, size_t maxBytes = 64 << 20, size_t maxEntries = 8192 );
+    ~ChunkCache( void );
+
+    void                    insert( const glm::vec3& chunkPosition, const std::vector<uint8_t>& data, bool modified );
+    const bool              take( const glm::vec3& chunkPosition, std::vector<uint8_t>& data, bool& modified );
+    void                    setLimits( size_t maxBytes, size_t maxEntries );
+    /* getters */
+    const cacheStats_t&     getStats( void ) const { return stats; };
+    const size_t            getBytes( void ) const { return bytes; };
+    const size_t            getEntries( void ) const { return entries.size(); };
+    const size_t            getMaxBytes( void ) const { return maxBytes; };
+    const size_t            getMaxEntries( void ) const { return maxEntries; };
+
+private:
+    std::list<cacheEntry_t>                                         entries;    /* the most recently evicted first */
+    std::unordered_map<uint64_t, std::list<cacheEntry_t>::iterator> index;
+    RegionStore*            regionStore;
+    size_t                  bytes;      /* size of the payloads */
+    size_t                  maxBytes;
+    size_t                  maxEntries;
+    cacheStats_t            stats;
+
+    void                    drop( std::list<cacheEntry_t>::iterator it );
+    void                    shrink( void );
+};
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <atomic>
+#include <thread>
+#include <chrono>
+
+#include "SpscQueue.hpp"
+#include "ComputeGenerator.hpp"
+#include "FragmentGenerator.hpp"
+
+typedef std::chrono::duration<double,std::milli> tMilliseconds;
+typedef std::chrono::steady_clock::time_point tTimePoint;
+
+/* a chunk to generate, with the fields of its column (see ComputeGenerator::add) */
+typedef struct  streamRequest_s {
+    glm::vec3           key;        /* the chunk position, in chunks */
+    std::vector<float>  columnFields;
+}               streamRequest_t;
+
+/* a generated chunk, its padded voxels as read back from the generator */
+typedef struct  streamResult_s {
+    glm::vec3               key;
+    std::vector<uint8_t>    voxels;
+}               streamResult_t;
+
+typedef struct  streamerStats_s {
+    uint64_t    requested;
+    uint64_t    received;
+    uint64_t    batches;    /* dispatched by the streaming thread */
+    bool        compute;    /* the thread generates with the compute generator */
+    double      batchMs;    /* streaming thread time from the batch upload to its read back */
+    double      waitMs;     /* part of it spent waiting for the batch fences */
+}               streamerStats_t;
+
+/*  Chunk generation on a streaming thread. The thread owns a hidden window whose context shares the objects
+    of the rendering one, and its own generator: the compute one with GL 4.3, the fragment shader one
+    otherwise (the GL 4.1 contexts of macOS). The requests of the render thread are batched,
+    dispatched, and the batch fence is waited for on the streaming thread, so the read back never stalls
+    the render thread. The requests and the generated chunks go through lock-free queues, the render thread
+    only copies the column fields in and takes the voxels out.
+*/
+class ChunkStreamer {
+
+public:
+    /* the hidden window is created here (on the main thread, as GLFW requires), the thread starts with it */
+    ChunkStreamer( GLFWwindow* window, const glm::ivec3& chunkSize, uint margin, int seed, const std::unordered_map<std::string, std::string>& pragmas );
+    ~ChunkStreamer( void );
+
+    /* render thread: queue the chunk, false when the queue is full */
+    const bool              request( const glm::vec3& key, const std::vector<float>& columnFields );
+    /* render thread: take a generated chunk, false when none is ready */
+    const bool              receive( streamResult_t& result );
+    /* false when the hidden window could not be created or the thread stopped on an error */
+    const bool              isRunning( void ) const { return running.load(); };
+    const streamerStats_t   getStats( void ) const;
+
+    static const size_t     queueSize = 256;
+
+private:
+    GLFWwindow*             context;        /* the hidden window of the streaming thread */
+    glm::ivec3              chunkSize;
+    uint                    margin;
+    int                     seed;
+    std::unordered_map<std::string, std::string>    pragmas;
+    SpscQueue<streamRequest_t>  requests;
+    SpscQueue<streamResult_t>   results;
+    std::atomic<bool>       running;
+    std::thread             thread;
+    uint64_t                requested;      /* render thread counters */
+    uint64_t                received;
+    std::atomic<uint64_t>   batches;        /* streaming thread counters */
+    std::atomic<uint64_t>   batchUs;
+    std::atomic<uint64_t>   waitUs;
+
+    void                    run( void );
+    template <typename T>
+    void                    loop( void );
+    template <typename T>
+    void                    generate( T& generator, const std::vector<glm::vec3>& batch );
+
+};
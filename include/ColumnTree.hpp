@@ -0,0 +1,76 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <iostream>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <cmath>
+#include <algorithm>
+
+#include "Camera.hpp"
+#include "Chunk.hpp"
+
+/* a node covers (1 << level) * (1 << level) columns from the column (x, z) * (1 << level) */
+typedef struct  columnNodeKey_s {
+    int         x;
+    int         z;
+    int         level;
+    bool operator==( const columnNodeKey_s& other ) const {
+        return (x == other.x && z == other.z && level == other.level);
+    }
+}               columnNodeKey_t;
+
+struct ColumnNodeKeyHash {
+    uint64_t operator()( const columnNodeKey_t& k ) const {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(k.x)) | (static_cast<uint64_t>(static_cast<uint32_t>(k.z) & 0xFFFFFF) << 32) | (static_cast<uint64_t>(k.level) << 56));
+    }
+};
+
+typedef struct  columnNode_s {
+    glm::vec3           min;    /* the bounds of the geometry below the node (min > max when there is none) */
+    glm::vec3           max;
+    std::vector<Chunk*> chunks; /* the chunks of a column by height (leaves only) */
+}               columnNode_t;
+
+typedef struct  columnTreeStats_s {
+    uint64_t    frames;
+    uint64_t    nodes;      /* nodes visited */
+    uint64_t    chunks;     /* chunks tested in the visited columns */
+    uint64_t    refreshed;  /* nodes whose bounds were computed again */
+}               columnTreeStats_t;
+
+/*  Quadtree over the chunk columns, for the culling. The bounds of a node are those of the meshes below
+    it, so the empty chunks, columns and areas are never visited. The changes mark their column, and the
+    bounds of the marked columns and of their ancestors are computed again before the next culling.
+*/
+class ColumnTree {
+
+public:
+    ColumnTree( const glm::ivec3& chunkSize, int height, int levels = 6 );
+    ~ColumnTree( void );
+
+    /* the chunk at the chunk position (nullptr when it is removed), or its meshes changed */
+    void                        setChunk( const glm::vec3& chunkPosition, Chunk* chunk );
+    void                        markChunk( const glm::vec3& chunkPosition );
+    /* append the chunks in the fustrum and in the render distance */
+    void                        cull( Camera& camera, float renderDistance, std::vector<Chunk*>& visible );
+    /* getters */
+    const columnTreeStats_t&    getStats( void ) const { return stats; };
+    const size_t                getNodesCount( void ) const { return nodes.size(); };
+
+private:
+    glm::ivec3                                                          chunkSize;
+    int                                                                 height;     /* chunks per column */
+    int                                                                 levels;     /* the roots level */
+    std::unordered_map<columnNodeKey_t, columnNode_t, ColumnNodeKeyHash> nodes;
+    std::unordered_set<columnNodeKey_t, ColumnNodeKeyHash>              roots;
+    std::unordered_set<columnNodeKey_t, ColumnNodeKeyHash>              dirty;      /* the marked columns */
+    columnTreeStats_t                                                   stats;
+
+    void                        refresh( void );
+    void                        computeBounds( const columnNodeKey_t& key );
+    void                        visit( const columnNodeKey_t& key, Camera& camera, float renderDistance, std::vector<Chunk*>& visible );
+    const bool                  isInRange( const glm::vec3& min, const glm::vec3& max, const glm::vec2& camera, float distance ) const;
+};
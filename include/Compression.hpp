@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+/*  Byte-oriented LZ77 compression of the chunk volumes (the runs of a bloc are matches at offset 1).
+    The stream is a list of tokens:
+    * 0x00..0x7F : (t + 1) literal bytes follow
+    * 0x80..0xFF : match of (t & 0x7F) + 4 bytes, followed by the 16 bits offset of the match
+*/
+void        compress( const uint8_t* src, size_t size, std::vector<uint8_t>& dst );
+const bool  decompress( const uint8_t* src, size_t size, uint8_t* dst, size_t dstSize );
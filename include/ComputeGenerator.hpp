@@ -0,0 +1,61 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "GLState.hpp"
+#include "Shader.hpp"
+
+typedef struct  computeGeneratorStats_s {
+    uint64_t    batches;
+    uint64_t    chunks;
+}               computeGeneratorStats_t;
+
+/*  Chunk generation with a compute shader (GL 4.3), the batched alternative to the generation fragment
+    shader. The chunks of a batch are dispatched at once, an invocation per four voxels of a 3d grid, into
+    a shared storage buffer (a padded chunk per slot, laid out as the fragment generation). The voxels
+    are read back for the chunks.
+*/
+class ComputeGenerator {
+
+public:
+    ComputeGenerator( const glm::ivec3& chunkSize, uint margin, const std::unordered_map<std::string, std::string>& pragmas );
+    ~ComputeGenerator( void );
+
+    /* the context has compute shaders (it can be created with a version below 4.3, the loader tells) */
+    static const bool       isSupported( void );
+
+    /* add a chunk to the batch with its column fields (RGBA, padded size x by z), return its slot */
+    const int               add( const glm::vec3& position, const std::vector<float>& columnFields );
+    /* generate the chunks of the batch, their voxels are then read with getVoxels until the next clear */
+    void                    dispatch( int seed );
+    /* dispatch alone, the voxels are read back by read (which waits for the dispatch unless its fence was waited for) */
+    void                    submit( int seed );
+    void                    read( void );
+    void                    clear( void ) { positions.clear(); };
+    /* getters */
+    const uint8_t*          getVoxels( int slot ) const { return voxels.data() + slot * slotSize; };
+    const size_t            getSlotSize( void ) const { return slotSize; };
+    const size_t            getSize( void ) const { return positions.size(); };
+    const bool              isFull( void ) const { return positions.size() == capacity; };
+    const computeGeneratorStats_t& getStats( void ) const { return stats; };
+
+    static const size_t     capacity = 16; /* chunks per batch (MAX_CHUNKS in generateChunk.comp.glsl) */
+
+private:
+    Shader*                 shader;
+    glm::ivec3              paddedSize;
+    uint                    margin;
+    size_t                  slotSize;       /* the bytes of a padded chunk */
+    GLuint                  buffer;         /* the storage buffer of the batch voxels */
+    GLuint                  columns;        /* 2d array texture, the column fields of a chunk per layer */
+    std::vector<glm::vec3>  positions;
+    std::vector<uint8_t>    voxels;         /* the voxels of the batch, read back */
+    computeGeneratorStats_t stats;
+
+};
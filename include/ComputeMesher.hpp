@@ -0,0 +1,101 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "GLState.hpp"
+#include "Shader.hpp"
+#include "UploadRing.hpp"
+
+typedef struct  computeMesherStats_s {
+    uint64_t    meshes;     /* chunks meshed by the compute shader */
+    uint64_t    failures;   /* meshes which did not fit the arena (they are redone once it was relocated) */
+    uint64_t    relocations;
+    uint64_t    grows;      /* relocations to a larger arena */
+    uint64_t    reclaimed;  /* faces of the released and outgrown ranges freed by the relocations */
+    uint64_t    draws;      /* indirect draws submitted */
+}               computeMesherStats_t;
+
+/* the command of an indirect draw (see glDrawArraysIndirect), six vertices per face */
+typedef struct  drawCommand_s {
+    GLuint      count;
+    GLuint      instanceCount;
+    GLuint      first;
+    GLuint      baseInstance;
+}               drawCommand_t;
+
+/*  Chunk meshing with a compute shader (GL 4.3). The padded volume of a chunk (bloc ids and light) is meshed
+    in three passes: the visible faces are counted per bucket (the six directions of the opaque faces, then
+    of the water), the slot of the chunk gets a range of the face arena, and the faces are written into it
+    with the draw commands of the buckets. The faces and the commands never leave the GPU, the chunks draw
+    them with indirect draws (see draw).
+    A range belongs to a slot (the chunk instance slot) and is reused in place while the new mesh fits. A
+    mesh outgrowing its range gets a new one at the arena top, and a released slot gives its range up. When
+    the arena is almost full the live ranges are packed into a new arena (see relocate), which reclaims the
+    others. The meshes that did not fit get empty commands, their slots are read back a few frames later
+    (see update) and the chunks remesh them (see isFailed).
+*/
+class ComputeMesher {
+
+public:
+    ComputeMesher( const glm::ivec3& chunkSize, uint margin, UploadRing* uploadRing );
+    ~ComputeMesher( void );
+
+    /* mesh the padded volumes of the chunk into its slot (the bloc ids and the light values, padded size bytes each) */
+    void                    mesh( int slot, const uint8_t* texture, const uint8_t* lightMap );
+    /* the slot is no longer compute meshed, its range is reclaimed by the next relocation */
+    void                    release( int slot );
+    /* draw the buckets of the slot facing the camera (directions bits +x, -x, +y, -y, +z, -z), the faces of the water or opaque ones */
+    void                    draw( int slot, bool transparent, uint8_t directions );
+    /* bind the commands, before the draws */
+    void                    bind( void );
+    /* once per frame: read the arena state back, relocate the arena when it is almost full */
+    void                    update( void );
+    /* the last mesh of the slot did not fit the arena, it has to be meshed again */
+    const bool              isFailed( int slot ) const { return slot >= 0 && static_cast<size_t>(slot) < failedSlots.size() && failedSlots[slot] != 0; };
+    /* getters */
+    const GLuint            getFacesTexture( void ) const { return facesTexture; };
+    const size_t            getArenaSize( void ) const { return arenaSize; };
+    const size_t            getArenaUsed( void ) const { return arenaTop; };
+    const size_t            getBytes( void ) const;
+    const computeMesherStats_t& getStats( void ) const { return stats; };
+
+    static const int        buckets = 12; /* the six directions of the opaque faces, then of the water */
+    static const int        failureLog = 256; /* the last failed slots kept in the state (FAILURE_LOG in meshChunk.comp.glsl) */
+
+private:
+    Shader*                 shader;
+    UploadRing*             uploadRing;     /* the volumes are uploaded through it */
+    glm::ivec3              chunkSize;
+    glm::ivec3              paddedSize;
+    uint                    margin;
+    size_t                  volumeSize;     /* the bytes of a padded volume */
+    GLuint                  volume;         /* the bloc ids then the light values of the chunk being meshed */
+    GLuint                  state;          /* the arena top and overflow flag, the counts and cursors of the mesh */
+    GLuint                  slots;          /* per slot: the first face and the capacity of its range */
+    GLuint                  commands;       /* per slot: the draw commands of its buckets */
+    GLuint                  faces;          /* the face arena */
+    GLuint                  facesTexture;   /* the buffer texture over the arena */
+    GLuint                  statusCopy;     /* the arena state read back */
+    GLsync                  statusFence;
+    GLuint                  failuresRead;   /* the failures counted by the last read back */
+    std::vector<uint8_t>    failedSlots;    /* per slot, its last mesh failed */
+    size_t                  slotCapacity;
+    size_t                  arenaSize;      /* in faces */
+    size_t                  maxArenaSize;   /* the texels of a buffer texture */
+    size_t                  arenaTop;       /* as last read back */
+    size_t                  relocatedTop;   /* the live faces packed by the last relocation */
+    bool                    pending;        /* meshes since the last read back */
+    computeMesherStats_t    stats;
+
+    void                    reserveSlots( size_t count );
+    void                    relocate( void );
+    void                    setArena( GLuint buffer, size_t size );
+    static void             resizeBuffer( GLuint& buffer, size_t used, size_t size, bool zeroed );
+
+};
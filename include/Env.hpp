@@ -10,6 +10,7 @@
 #include <regex>
 
 #include "Exception.hpp"
+#include "GLState.hpp"
 #include "Controller.hpp"
 #include "Terrain.hpp"
 #include "Cubemap.hpp"
@@ -26,7 +27,7 @@ typedef struct  s_window {
 class Env {
 
 public:
-    Env( void );
+    Env( uint32_t seed );
     ~Env( void );
 
     const t_window&                     getWindow( void ) const { return (window); };
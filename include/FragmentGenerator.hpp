@@ -0,0 +1,63 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <array>
+#include <cmath>
+
+#include "GLState.hpp"
+#include "Shader.hpp"
+#include "WorldGen.hpp"
+
+/*  Batched chunk generation with the generation fragment shader, for the contexts without compute shaders
+    (GL 4.1). It has the interface of ComputeGenerator: the chunks of a batch are rendered with a quad each
+    into the layers of a 2d array texture (a padded chunk per layer, laid out as the generation framebuffer
+    of Terrain), and the voxels of all the layers are read back at once.
+*/
+class FragmentGenerator {
+
+public:
+    FragmentGenerator( const glm::ivec3& chunkSize, uint margin, const std::unordered_map<std::string, std::string>& pragmas );
+    ~FragmentGenerator( void );
+
+    /* add a chunk to the batch with its column fields (RGBA, padded size x by z), return its slot */
+    const int               add( const glm::vec3& position, const std::vector<float>& columnFields );
+    /* render the chunks of the batch, their voxels are then read with getVoxels until the next clear */
+    void                    dispatch( int seed );
+    /* render alone, the voxels are read back by read (which waits for the rendering unless its fence was waited for) */
+    void                    submit( int seed );
+    void                    read( void );
+    void                    clear( void ) { positions.clear(); };
+    /* getters */
+    const uint8_t*          getVoxels( int slot ) const { return voxels.data() + slot * slotSize; };
+    const size_t            getSlotSize( void ) const { return slotSize; };
+    const size_t            getSize( void ) const { return positions.size(); };
+    const bool              isFull( void ) const { return positions.size() == capacity; };
+
+    /* turn the bytes read back from the generation framebuffer into bloc ids, in place */
+    static void             decode( uint8_t* voxels, size_t size );
+
+    static const size_t     capacity = 16; /* chunks per batch, as the compute generator */
+
+private:
+    Shader*                 shader;
+    glm::ivec3              paddedSize;
+    uint                    margin;
+    size_t                  slotSize;       /* the bytes of a padded chunk */
+    size_t                  columnSize;     /* the floats of the column fields of a chunk */
+    GLuint                  vao;            /* the quad covering the viewport */
+    GLuint                  vbo;
+    GLuint                  ebo;
+    GLuint                  fbo;
+    GLuint                  layers;         /* 2d array texture, the voxels of a chunk per layer */
+    GLuint                  column;         /* the column fields of the chunk rendered */
+    std::vector<glm::vec3>  positions;
+    std::vector<float>      columns;        /* the column fields of the batch, uploaded before each chunk */
+    std::vector<uint8_t>    voxels;         /* the voxels of the batch, read back */
+
+};
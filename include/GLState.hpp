@@ -0,0 +1,66 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <iostream>
+#include <array>
+
+typedef struct  glStateStats_s {
+    uint64_t    frames;
+    uint64_t    issued;     /* state calls sent to GL */
+    uint64_t    elided;     /* state calls skipped, the state was already set */
+}               glStateStats_t;
+
+/*  Cache of the GL binding state (program, vertex array, textures, framebuffer, viewport and a few
+    capabilities) of the context current on the thread (one cache per thread). A call is only sent to GL when it changes the state, and the
+    state is read from the cache instead of glGet. Every change of that state must go through it, and the
+    objects bound must be deleted through it (their names are reused by GL).
+*/
+class GLState {
+
+public:
+    static void                 useProgram( GLuint program );
+    static void                 bindVertexArray( GLuint vao );
+    static void                 activeTexture( GLenum unit );
+    static void                 bindTexture( GLenum target, GLuint texture );
+    static void                 bindFramebuffer( GLuint fbo );
+    static void                 viewport( GLint x, GLint y, GLsizei width, GLsizei height );
+    static void                 enable( GLenum capability );
+    static void                 disable( GLenum capability );
+    static void                 deleteVertexArrays( GLsizei n, const GLuint* vaos );
+    static void                 deleteTextures( GLsizei n, const GLuint* textures );
+    static void                 deleteFramebuffers( GLsizei n, const GLuint* fbos );
+    /* the state is unknown (changed outside of the cache), the next calls are all sent */
+    static void                 invalidate( void );
+    static void                 endFrame( void );
+    /* getters */
+    static const glm::ivec4&    getViewport( void );
+    static const glStateStats_t& getStats( void ) { return state().stats; };
+
+    static const int            textureUnits = 16;
+    static const int            textureTargets = 5; /* 2D, 3D, cube map, 2D array and buffer, the others are not cached */
+    static const int            capabilities = 5;   /* depth test, cull face, blend, scissor test and sRGB framebuffer */
+
+private:
+    GLState( void );
+
+    static const GLuint         unknown = 0xFFFFFFFF;
+
+    GLuint                                                  program;
+    GLuint                                                  vao;
+    GLenum                                                  unit;
+    std::array<std::array<GLuint, textureTargets>, textureUnits>    textures;
+    GLuint                                                  fbo;
+    glm::ivec4                                              view;
+    bool                                                    viewKnown;
+    std::array<int, capabilities>                           enabled;    /* -1 when unknown */
+    glStateStats_t                                          stats;
+
+    void                        reset( void );
+    static GLState&             state( void );
+    static const bool           isChanged( GLuint& current, GLuint value );
+    static const int            getTargetIndex( GLenum target );
+    static const int            getCapabilityIndex( GLenum capability );
+    static void                 setCapability( GLenum capability, bool enable );
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#include "GLState.hpp"
+#include "Shader.hpp"
+#include "Camera.hpp"
+
+/* a level of the clipmap: size * size samples, spaced by step blocs */
+typedef struct  horizonLevel_s {
+    GLuint      texture;    /* RG32F, the terrain top and the bloc seen from above of the samples */
+    GLuint      fbo;
+    float       step;
+    glm::ivec2  origin;     /* the first sample of the level (in samples), a sample g is at texel g % size */
+    bool        filled;     /* the samples of the level were evaluated since its creation */
+}               horizonLevel_t;
+
+typedef struct  horizonStats_s {
+    uint64_t    samples;    /* samples evaluated */
+    uint64_t    moves;      /* level origins moved */
+    uint64_t    deferred;   /* level moves postponed to stay under the samples budget */
+}               horizonStats_t;
+
+/*  Far terrain rendered as a heightfield clipmap beyond the chunks. Each level is a grid of samples of
+    the terrain top (and of the bloc seen from above) centered on the camera, twice as coarse as the
+    previous one. The samples are evaluated by the generation shader, and when the camera moves a level
+    only evaluates the rows and columns entering it (the texture is addressed modulo the level size).
+*/
+class Horizon {
+
+public:
+    Horizon( uint levels = 3, int size = 64, float step = 8.0f, uint samplesBudget = 4096 );
+    ~Horizon( void );
+
+    /* the generation shader must be in use, with its horizon pass enabled */
+    void                    update( const glm::vec3& cameraPosition, Shader& generationShader, GLuint quadVao );
+    void                    render( Camera& camera, GLuint textureAtlas, float innerDistance );
+    /* getters */
+    const horizonStats_t&   getStats( void ) const { return stats; };
+    const size_t            getLevelsCount( void ) const { return levels.size(); };
+    const int               getSize( void ) const { return size; };
+    const float             getStep( uint level ) const { return levels[level].step; };
+    const float             getExtent( void ) const { return levels.back().step * (size / 2 - 1); };
+
+private:
+    std::vector<horizonLevel_t> levels;
+    int                         size;
+    uint                        samplesBudget;  /* samples evaluated per update at most (a level always moves at once) */
+    GLuint                      vao;
+    GLuint                      vbo;
+    GLuint                      ebo;
+    GLsizei                     indicesCount;
+    Shader*                     shader;
+    horizonStats_t              stats;
+
+    void                        setupLevel( horizonLevel_t& level );
+    void                        setupGrid( void );
+    const glm::ivec2            getTargetOrigin( const horizonLevel_t& level, const glm::vec3& cameraPosition ) const;
+    void                        renderSamples( horizonLevel_t& level, const glm::ivec2& from, const glm::ivec2& to, Shader& generationShader, GLuint quadVao );
+};
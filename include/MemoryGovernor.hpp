@@ -0,0 +1,53 @@
+#pragma once
+
+#include <iostream>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+
+/* the memory used by the terrain, in bytes */
+typedef struct  memoryUsage_s {
+    size_t      voxels;     /* bloc volumes */
+    size_t      light;      /* light maps and light masks */
+    size_t      cpuMeshes;  /* meshes kept on the CPU side */
+    size_t      gpuBuffers; /* vertex buffers */
+    size_t      cache;      /* evicted chunks kept compressed */
+}               memoryUsage_t;
+
+typedef struct  governorStats_s {
+    uint64_t    evicted;    /* chunks evicted to stay under the budget */
+    uint        shrinks;    /* render distance decreases */
+    uint        grows;      /* render distance increases */
+}               governorStats_t;
+
+/*  Keeps the terrain memory under a byte budget. The chunks outside of the render distance are evicted
+    first (farthest first), the render distance is reduced while the resident chunks alone exceed the
+    budget, and given back once they fall well under it. The chunk cache gets what is left.
+*/
+class MemoryGovernor {
+
+public:
+    MemoryGovernor( size_t budget, uint renderDistance, uint minRenderDistance, uint step );
+    ~MemoryGovernor( void );
+
+    void                    update( const memoryUsage_t& usage );
+    const size_t            getExcess( const memoryUsage_t& usage ) const;
+    const size_t            getCacheBudget( const memoryUsage_t& usage, size_t cacheMaxBytes ) const;
+    static const size_t     getResident( const memoryUsage_t& usage ) { return usage.voxels + usage.light + usage.cpuMeshes + usage.gpuBuffers; };
+    void                    setBudget( size_t budget ) { this->budget = budget; };
+    void                    addEvicted( uint n ) { stats.evicted += n; };
+    /* getters */
+    const size_t            getBudget( void ) const { return budget; };
+    const uint              getRenderDistance( void ) const { return renderDistance; };
+    const uint              getMaxRenderDistance( void ) const { return maxRenderDistance; };
+    const governorStats_t&  getStats( void ) const { return stats; };
+
+private:
+    size_t                  budget;
+    uint                    renderDistance;     /* the effective render distance (in blocs) */
+    uint                    maxRenderDistance;  /* the configured render distance */
+    uint                    minRenderDistance;
+    uint                    step;
+    uint                    updatesSinceChange;
+    governorStats_t         stats;
+};
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <iostream>
+#include <vector>
+#include <array>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cmath>
+#include <algorithm>
+
+#if defined(__SSE2__)
+# include <emmintrin.h>
+#endif
+
+/* an occluder triangle in buffer space, the depth is the plane d = a*x + b*y + c clamped to [dmin, dmax] */
+typedef struct  occluderTriangle_s {
+    glm::vec2   v[3];
+    glm::vec3   plane;
+    glm::vec2   depthRange;
+    glm::ivec4  bounds;     /* the pixels covered at most [x0, x1) [y0, y1) */
+}               occluderTriangle_t;
+
+typedef struct  occlusionStats_s {
+    uint64_t    frames;
+    uint64_t    occluders;
+    uint64_t    triangles;
+    uint64_t    tested;     /* boxes tested against the hierarchical depth */
+    uint64_t    culled;     /* boxes found occluded */
+    uint64_t    culledPoints;
+    double      rasterizeMs;
+}               occlusionStats_t;
+
+/*  Low resolution depth buffer rasterized on the CPU. The occluders are boxes fully inside solid voxels,
+    their front faces are rasterized (nearest depth kept), then a hierarchical depth keeps the farthest
+    depth of each tile. A box is occluded when its nearest depth is behind the tiles (and pixels) it covers.
+    The rows are split in bands rasterized in parallel by workers started with the buffer (the first band
+    is left to the calling thread): a pixel only depends on the occluders, so the result does not depend on
+    the threads count. The depth is the normalized device depth in [0, 1].
+*/
+class OcclusionBuffer {
+
+public:
+    OcclusionBuffer( int width = 256, int height = 128, uint threads = 1 );
+    ~OcclusionBuffer( void );
+
+    void                clear( const glm::mat4& viewProjection );
+    void                addOccluder( const glm::vec3& min, const glm::vec3& max );
+    void                rasterize( void );
+    const bool          isVisible( const glm::vec3& min, const glm::vec3& max ) const;
+    /* getters */
+    const int           getWidth( void ) const { return width; };
+    const int           getHeight( void ) const { return height; };
+    const float         getDepth( int x, int y ) const { return depth[x + y * width]; };
+    const float         getTileDepth( int x, int y ) const { return tiles[x / tileSize + y / tileSize * tilesX]; };
+    const size_t        getTrianglesCount( void ) const { return triangles.size(); };
+
+    static const int    tileSize = 8;
+
+private:
+    int                             width;      /* a multiple of the tile size */
+    int                             height;
+    int                             tilesX;
+    int                             tilesY;
+    int                             bandHeight; /* a multiple of the tile size */
+    std::vector<std::thread>        workers;    /* the worker i rasterizes the band i + 1 */
+    std::mutex                      mutex;
+    std::condition_variable         wake;
+    std::condition_variable         done;
+    uint64_t                        generation; /* the rasterize calls, a worker wakes up when it changes */
+    int                             pending;    /* the workers still rasterizing their band */
+    bool                            stopping;
+    glm::mat4                       viewProjection;
+    std::vector<float>              depth;
+    std::vector<float>              tiles;      /* the farthest depth of each tile */
+    std::vector<occluderTriangle_t> triangles;
+
+    void                addTriangle( const glm::vec4& a, const glm::vec4& b, const glm::vec4& c );
+    void                setupTriangle( const glm::vec3& a, const glm::vec3& b, const glm::vec3& c );
+    void                work( int band );
+    void                rasterizeBand( int y0, int y1 );
+    void                rasterizeTriangle( const occluderTriangle_t& triangle, int y0, int y1 );
+    const glm::vec3     toBuffer( const glm::vec4& clip ) const;
+
+};
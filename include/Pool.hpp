@@ -0,0 +1,61 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <map>
+#include <tuple>
+#include <new>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+#include <sys/mman.h>
+#ifdef __APPLE__
+# include <mach/vm_statistics.h>
+#endif
+
+#include "Exception.hpp"
+
+typedef struct  poolStats_s {
+    uint64_t    allocations;
+    uint64_t    releases;
+    size_t      used;       /* blocks in use */
+    size_t      capacity;   /* blocks in the slabs */
+    size_t      slabs;
+    size_t      hugeSlabs;  /* slabs backed by huge pages */
+}               poolStats_t;
+
+/*  Fixed-size blocks allocator. The blocks are carved from large slabs mapped with mmap (with huge
+    pages when the system allows it), and the released blocks are kept in a free list. Slabs are only
+    unmapped when the pool is destroyed.
+*/
+class Pool {
+
+public:
+    Pool( size_t blockSize, size_t slabSize = 2 << 20 );
+    /* the slabs are unmapped by their only owner, the pools are neither copied nor assigned */
+    Pool( const Pool& src ) = delete;
+    ~Pool( void );
+    Pool&               operator=( const Pool& rhs ) = delete;
+
+    void*               allocate( void );
+    void                release( void* block );
+    /* the pool shared by all the blocks of this size */
+    static Pool&        forSize( size_t blockSize );
+    static const std::map<size_t, Pool>&    getPools( void ) { return pools(); };
+    /* getters */
+    const poolStats_t&  getStats( void ) const { return stats; };
+    const size_t        getBlockSize( void ) const { return blockSize; };
+    const size_t        getSlabSize( void ) const { return slabSize; };
+    const float         getFragmentation( void ) const { return (stats.capacity > 0 ? 1.0f - static_cast<float>(stats.used) / stats.capacity : 0.0f); };
+
+private:
+    size_t              blockSize;  /* rounded up to a cache line */
+    size_t              slabSize;
+    std::vector<void*>  slabList;
+    void*               freeList;   /* each free block starts with the address of the next one */
+    poolStats_t         stats;
+
+    void                addSlab( void );
+    static std::map<size_t, Pool>&  pools( void );
+};
@@ -11,6 +11,7 @@
 #include <vector>
 
 #include "Exception.hpp"
+#include "GLState.hpp"
 #include "Shader.hpp"
 
 typedef struct  sQuadVertex {
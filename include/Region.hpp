@@ -0,0 +1,102 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cmath>
+#include <chrono>
+#include <cerrno>
+#include <cstdio>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "Exception.hpp"
+#include "Compression.hpp"
+
+/*  Region file: a header with the generation of its chunks (see WorldGen::getGeneration) and the offset table
+    of its 32x8x32 chunks, followed by the chunk payloads. A payload is the size of the serialized chunk (32 bits)
+    and the compressed serialized chunk. Payloads are always appended, a rewritten chunk leaves its previous
+    payload behind until the region is compacted when opened. A region of another generation is emptied when
+    opened, its chunks are generated again.
+*/
+typedef struct  regionEntry_s {
+    uint32_t    offset; /* 0 if the chunk is not stored */
+    uint32_t    size;
+}               regionEntry_t;
+
+typedef struct  regionStats_s {
+    uint        loaded;
+    uint        saved;
+    uint        misses;
+    uint64_t    rawBytes;       /* serialized size of the saved chunks */
+    uint64_t    storedBytes;    /* compressed size of the saved chunks */
+    uint        failed;         /* saves not written (the chunks stay modified) */
+    uint        outdated;       /* regions of another generation, emptied */
+    double      saveMs;
+}               regionStats_t;
+
+class Region {
+
+public:
+    Region( const std::string& path, uint32_t generation );
+    ~Region( void );
+
+    const bool          load( const glm::ivec3& local, std::vector<uint8_t>& data );
+    const bool          save( const glm::ivec3& local, const std::vector<uint8_t>& data );
+    const bool          isOutdated( void ) const { return outdated; };
+
+    static const glm::ivec3 size;
+    uint64_t            lastUse;
+
+private:
+    std::string         path;
+    int                 fd;
+    uint8_t*            mapped;     /* read-only mapping of the file */
+    size_t              mappedSize;
+    size_t              fileSize;
+    bool                outdated;   /* it was of another generation when opened */
+    std::vector<regionEntry_t>  entries;
+
+    const int           getEntryIndex( const glm::ivec3& local ) const;
+    void                map( void );
+    const bool          writeHeader( uint32_t generation );
+    void                compact( uint32_t generation );
+};
+
+/* the region files of a world, a limited number of them stays open */
+class RegionStore {
+
+public:
+    RegionStore( const std::string& directory, uint32_t generation, size_t maxOpenRegions = 16 );
+    ~RegionStore( void );
+
+    const bool              load( const glm::vec3& chunkPosition, std::vector<uint8_t>& data );
+    /* false when the chunk could not be written */
+    const bool              save( const glm::vec3& chunkPosition, const std::vector<uint8_t>& data );
+    const bool              savePayload( const glm::vec3& chunkPosition, const std::vector<uint8_t>& payload );
+    /* payload: the size of the data (32 bits) followed by the compressed data */
+    static void             pack( const std::vector<uint8_t>& data, std::vector<uint8_t>& payload );
+    static const bool       unpack( const uint8_t* payload, size_t size, std::vector<uint8_t>& data );
+    /* getters */
+    const regionStats_t&    getStats( void ) const { return stats; };
+    const size_t            getOpenRegions( void ) const { return regions.size(); };
+    const bool              isEnabled( void ) const { return enabled; };
+
+private:
+    std::string                             directory;
+    uint32_t                                generation;
+    std::unordered_map<uint64_t, Region*>   regions;
+    size_t                                  maxOpenRegions;
+    uint64_t                                useCounter;
+    bool                                    enabled;
+    regionStats_t                           stats;
+
+    Region*                 getRegion( const glm::vec3& chunkPosition, glm::ivec3& local, bool create );
+};
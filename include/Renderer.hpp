@@ -16,6 +16,7 @@
 #include <thread>
 
 #include "Exception.hpp"
+#include "GLState.hpp"
 #include "Env.hpp"
 #include "Shader.hpp"
 #include "Camera.hpp"
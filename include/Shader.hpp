@@ -12,15 +12,32 @@
 #include <unordered_map>
 
 #include "Exception.hpp"
+#include "GLState.hpp"
+
+/* a uniform location resolved once (see Shader::getUniform), set without the name lookup */
+template <typename T>
+struct  Uniform {
+    GLint   location;
+    void    set( const T& value ) const;
+};
+
+template <> void    Uniform<int>::set( const int& value ) const;
+template <> void    Uniform<float>::set( const float& value ) const;
+template <> void    Uniform<glm::vec3>::set( const glm::vec3& value ) const;
+template <> void    Uniform<glm::vec4>::set( const glm::vec4& value ) const;
+template <> void    Uniform<glm::mat4>::set( const glm::mat4& value ) const;
 
 class Shader {
 
 public:
     Shader( const std::string& vertexShader, const std::string& fragmentShader );
     Shader( const std::string& vertexShader, const std::string& geometryShader, const std::string& fragmentShader );
+    Shader( const std::string& vertexShader, const std::string& fragmentShader, const std::unordered_map<std::string, std::string>& pragmas );
+    Shader( const std::string& computeShader, const std::unordered_map<std::string, std::string>& pragmas );
     ~Shader( void );
 
-    std::string         getFromFile( const std::string& filename );
+    static std::string  getFromFile( const std::string& filename );
+    void                insertPragmas( std::string& source, const std::unordered_map<std::string, std::string>& pragmas );
     GLuint              create( const char* shaderSource, GLenum shaderType );
     GLuint              createProgram( const std::forward_list<GLuint>& shaders );
     void                isCompilationSuccess( GLint handle, GLint success, int shaderType );
@@ -28,6 +45,9 @@ public:
     void                use( void ) const;
 
     unsigned int        getUniformLocation( const std::string& name );
+    template <typename T>
+    Uniform<T>          getUniform( const std::string& name ) { return (Uniform<T>){ static_cast<GLint>(getUniformLocation(name)) }; };
+    void                bindUniformBlock( const std::string& name, GLuint binding );
 
     void                setIntUniformValue( const std::string& name, const int i );
     void                setFloatUniformValue( const std::string& name, const float f );
@@ -37,6 +57,8 @@ public:
     void                setVec2UniformValue( const std::string& name, const glm::vec2& v );
     void                setVec3UniformValue( const std::string& name, const glm::vec3& v );
     void                setVec4UniformValue( const std::string& name, const glm::vec4& v );
+    void                setIvec2UniformValue( const std::string& name, const glm::ivec2& v );
+    void                setIvec3UniformValue( const std::string& name, const glm::ivec3& v );
 
     GLuint  id;
 
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+
+/*  Lock-free ring queue between a single producer thread and a single consumer thread. The producer only
+    moves the tail and the consumer the head, each one reads the index of the other with an acquire so that
+    an element is fully written (or fully read) before its slot changes hands. The capacity is rounded up
+    to a power of two.
+*/
+template <typename T>
+class SpscQueue {
+
+public:
+    SpscQueue( size_t capacity ) : slots(roundCapacity(capacity)), mask(roundCapacity(capacity) - 1), head(0), tail(0) {};
+
+    /* producer side: false when the queue is full (the value is left untouched) */
+    const bool      push( T&& value ) {
+        const size_t t = this->tail.load(std::memory_order_relaxed);
+        if (t - this->head.load(std::memory_order_acquire) == this->slots.size())
+            return false;
+        this->slots[t & this->mask] = std::move(value);
+        this->tail.store(t + 1, std::memory_order_release);
+        return true;
+    };
+    /* consumer side: false when the queue is empty */
+    const bool      pop( T& value ) {
+        const size_t h = this->head.load(std::memory_order_relaxed);
+        if (h == this->tail.load(std::memory_order_acquire))
+            return false;
+        value = std::move(this->slots[h & this->mask]);
+        this->head.store(h + 1, std::memory_order_release);
+        return true;
+    };
+    /* the elements in the queue, already outdated when read from the other thread */
+    const size_t    size( void ) const { return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire); };
+
+private:
+    std::vector<T>              slots;
+    size_t                      mask;
+    alignas(64) std::atomic<size_t> head;   /* on their own cache lines, each is written by one thread */
+    alignas(64) std::atomic<size_t> tail;
+
+    static size_t   roundCapacity( size_t capacity ) {
+        size_t rounded = 1;
+        while (rounded < capacity)
+            rounded <<= 1;
+        return rounded;
+    };
+
+};
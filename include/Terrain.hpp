@@ -11,6 +11,7 @@
 #include <vector>
 #include <cmath>
 #include <algorithm>
+#include <iterator>
 #include <array>
 #include <forward_list>
 #include <unordered_map>
@@ -18,10 +19,21 @@
 #include <queue>
 
 #include "Exception.hpp"
+#include "GLState.hpp"
 #include "Shader.hpp"
 #include "Camera.hpp"
 #include "utils.hpp"
 #include "Chunk.hpp"
+#include "WorldGen.hpp"
+#include "Region.hpp"
+#include "ChunkCache.hpp"
+#include "MemoryGovernor.hpp"
+#include "Horizon.hpp"
+#include "OcclusionBuffer.hpp"
+#include "ColumnTree.hpp"
+#include "ComputeGenerator.hpp"
+#include "ComputeMesher.hpp"
+#include "ChunkStreamer.hpp"
 
 typedef struct  vertex_s {
     glm::vec3   Position;
@@ -47,9 +59,10 @@ typedef struct  chunkSort_s {
     float   comp;
 }               chunkSort_t;
 
+/* the render list order, from front to back */
 struct {
     bool operator()(chunkSort_t a, chunkSort_t b) const {   
-        return a.comp > b.comp;
+        return a.comp < b.comp;
     }
 } chunkRenderingCompareSort;
 
@@ -72,12 +85,134 @@ struct KeyHash {
     }
 };
 
+/* the resident chunks bounds in structure of arrays, for the batched fustrum culling (see Camera::aabsInFustrum) */
+typedef struct  chunkBounds_s {
+    std::vector<float>  x;  /* the bounds centers */
+    std::vector<float>  y;
+    std::vector<float>  z;
+    std::vector<Chunk*> chunks;
+    std::unordered_map<ckey_t, uint32_t, KeyHash> indices;
+}               chunkBounds_t;
+
+typedef struct  renderStats_s {
+    uint64_t    frames;
+    double      sortMs;
+    uint64_t    fullSorts;          /* sorts of the whole list, when many chunks entered the view */
+    uint64_t    moves;              /* entries moved by the insertion sorts */
+    uint64_t    queries;            /* frames whose gpu queries were read */
+    uint64_t    opaqueSamples;      /* samples passing the depth test */
+    uint64_t    transparentSamples;
+    uint64_t    pixels;
+    double      opaqueGpuMs;
+    uint64_t    faceQueries;        /* the frames drawn with the face renderer, and their opaque pass time */
+    double      faceGpuMs;
+    uint64_t    faceFrames;         /* the frames drawn with the face renderer, their faces and those submitted (facing the camera) */
+    uint64_t    faces;
+    uint64_t    submittedFaces;
+    double      submitMs;           /* cpu time of the two passes draw calls */
+    uint64_t    draws;
+}               renderStats_t;
+
+/* the frame uniform block of the chunks shader (std140, see default.vert.glsl) */
+typedef struct  frameUniforms_s {
+    glm::mat4   viewProjection;
+    glm::vec4   cameraPosition;
+    int         cameraUnderwater;
+    int         padding[3];
+}               frameUniforms_t;
+
+/* the uniforms of the chunks shader, resolved once per program */
+typedef struct  chunkUniforms_s {
+    GLuint          program;
+    Uniform<int>    atlas;
+    Uniform<int>    waterOffset;
+    Uniform<int>    faces;
+}               chunkUniforms_t;
+
+typedef struct  fustrumStats_s {
+    uint64_t    frames[2];  /* flat culling over the bounds, hierarchical culling over the column tree */
+    uint64_t    visible[2];
+    double      cullMs[2];
+    uint64_t    tested;     /* chunks tested by the flat culling */
+}               fustrumStats_t;
+
 struct  setChunkRenderCompare {
     bool operator()(const glm::vec4& a, const glm::vec4& b) const {
         return (a.w < b.w);
     }
 };
 
+/* coarse lattice used to interpolate the smooth terrain fields during generation */
+typedef struct  lattice_s {
+    GLuint      fbo;
+    GLuint      fields[2];  /* the RGBA32F targets holding the smooth fields of the lattice nodes */
+    int         mode;       /* 0: full resolution, 1: 4x4x4 lattice, 2: 4x8x4 lattice */
+    glm::ivec3  step;
+    glm::ivec3  size;       /* number of lattice nodes */
+}               lattice_t;
+
+/* comparison of the lattice generation against the full resolution generation */
+typedef struct  latticeReport_s {
+    uint    chunks;
+    uint    voxels;
+    uint    flips;      /* voxels switching between air and solid */
+    uint    materials;  /* solid voxels with a different bloc */
+    double  fullMs;
+    double  latticeMs;
+}               latticeReport_t;
+
+/* comparison of the CPU kernel against the generation shader, on a sample of voxels */
+typedef struct  worldGenReport_s {
+    uint    chunks;
+    uint    voxels;
+    uint    mismatches;
+    double  cpuMs;
+}               worldGenReport_t;
+
+/* counters of the generated chunks taking the uniform fast path */
+typedef struct  chunkStats_s {
+    uint    generated;
+    uint    uniformAir;
+    uint    uniformSolid;
+    uint    columns;        /* columns fields evaluated */
+    uint    columnSkipped;  /* chunks decided from their column bounds, without generation */
+    uint    loaded;         /* chunks loaded from the region files */
+    uint    cached;         /* chunks taken back from the chunk cache */
+    double  generateMs;     /* time spent creating the generated chunks */
+    double  loadMs;         /* time spent creating the loaded chunks (misses included) */
+    uint    dropped;        /* streamed chunks out of range when received */
+}               chunkStats_t;
+
+/* the 2d fields shared by the chunks of a column */
+typedef struct  column_s {
+    std::vector<float>  fields; /* per (x,z) of the padded chunk: terrain top, tree mask, biome cell, unused */
+    float               minTop; /* bounds of the terrain top over the generated voxels */
+    float               maxTop;
+}               column_t;
+
+/* the chunks and points drawn in the last frame per lod level */
+typedef struct  lodStats_s {
+    uint        chunks[Chunk::lodLevels];
+    uint64_t    points[Chunk::lodLevels];
+    uint64_t    switches;   /* chunks remeshed at another level */
+}               lodStats_t;
+
+/* a chunk reached by the visibility search, from the side it was entered by, in the directions taken from the camera chunk */
+typedef struct  visibilityNode_s {
+    ckey_t      key;
+    int         from;       /* -1 for the camera chunk */
+    uint8_t     directions; /* bits of the sides crossed since the camera chunk */
+}               visibilityNode_t;
+
+/* the draws of the chunks in view, and the ones skipped by the cave culling, accumulated over the frames */
+typedef struct  cullingStats_s {
+    uint64_t    frames;
+    uint64_t    drawCalls;
+    uint64_t    points;
+    uint64_t    culledDrawCalls;
+    uint64_t    culledPoints;
+}               cullingStats_t;
+
 enum class updateType { water, light };
 
 typedef struct  update_s {
@@ -89,12 +224,12 @@ typedef struct  update_s {
 class Terrain {
 
 public:
-    Terrain( uint renderDistance = 160, uint maxHeight = 256 );
+    Terrain( uint renderDistance = 160, uint maxHeight = 256, uint32_t seed = 42, size_t memoryBudget = 512 << 20 );
     ~Terrain( void );
 
     void                        updateChunks( const glm::vec3& cameraPosition );
-    void                        renderChunks( Shader shader, Camera& camera );
-    void                        deleteOutOfRangeChunks( void );
+    void                        renderChunks( Shader& shader, Camera& camera );
+    void                        deleteOutOfRangeChunks( const glm::vec3& cameraPosition );
 
     void                        addChunksToGenerationList( const glm::vec3& cameraPosition );
     void                        generateChunkTextures( void );
@@ -104,25 +239,131 @@ public:
     const glm::vec3             getChunkPosition( const glm::vec3& position ) const;
     const std::array<Chunk*, 6> getNeighbouringChunks( const glm::vec3& position ) const;
 
+    void                        setGenerationLattice( int mode );
+    void                        setLodMode( int mode );
+    void                        setCaveCulling( bool enabled ) { caveCulling = enabled; };
+    void                        setOcclusionCulling( bool enabled ) { occlusionCulling = enabled; };
+    void                        setHierarchicalCulling( bool enabled ) { hierarchicalCulling = enabled; };
+    void                        setFrontToBack( bool enabled ) { frontToBack = enabled; };
+    void                        setFaceRendering( bool enabled ) { faceRendering = enabled; };
+    void                        setDebugStats( bool enabled ) { debugStats = enabled; };
+    void                        setComputeMeshing( bool enabled );
+    void                        setChunkCacheLimits( size_t maxBytes, size_t maxEntries );
+    void                        setMemoryBudget( size_t budget ) { governor->setBudget(budget); };
+    const memoryUsage_t         getMemoryUsage( void ) const;
+    const int                   getGenerationLattice( void ) const { return lattice.mode; };
+    const int                   getLodMode( void ) const { return lodMode; };
+    /* the compute meshes are only drawn by the face renderer */
+    const bool                  isFaceRendering( void ) const { return faceRendering || Chunk::computeMeshedCount > 0; };
+
+    static const GLuint         frameUniformBinding = 0; /* the binding point of the frame uniform block */
+
 private:
     std::unordered_map<ckey_t, Chunk*, KeyHash> chunks;
     std::unordered_set<ckey_t, KeyHash>         chunksToLoadSet; // need to to easy check if chunk is present in queue
     std::queue<ckey_t>                          chunksToLoadQueue; // queue to have ordered chunk lookup
     std::queue<update_t>                        chunksToUpdateQueue;
+    std::unordered_map<ckey_t, column_t, KeyHash> columns;
 
     float                       maxAllocatedTimePerFrame;
     glm::ivec3                  chunkSize;
-    uint                        renderDistance; /* in blocs */
+    uint                        renderDistance; /* in blocs, the governor may use less */
     uint                        maxHeight;
     Shader*                     chunkGenerationShader;
     mesh_quad_t                 chunkGenerationRenderingQuad;
     framebuffer_t               chunkGenerationFbo;
-    GLuint                      noiseSampler;
     GLuint                      textureAtlas;
     uint8_t*                    dataBuffer;
     uint                        dataMargin;
+    chunkStats_t                stats;
+    lattice_t                   lattice;
+    latticeReport_t             latticeReport;
+    framebuffer_t               columnFbo;
+    ckey_t                      boundColumn; /* the column whose fields are in the column texture */
+    uint                        latticeReportInterval; /* one chunk out of n is also generated at full resolution */
+    uint8_t*                    referenceBuffer;
+    WorldGen*                   worldGen;
+    worldGenReport_t            worldGenReport;
+    uint                        worldGenReportInterval; /* one chunk out of n is sampled with the CPU kernel */
+    RegionStore*                regionStore;
+    ChunkCache*                 chunkCache;
+    size_t                      cacheMaxBytes;      /* the configured chunk cache limits */
+    size_t                      cacheMaxEntries;
+    MemoryGovernor*             governor;
+    Horizon*                    horizon;
+    std::vector<uint8_t>        serializedBuffer;
+    int                         lodMode;        /* the coarsest lod level used, 0 meshes all the chunks at full resolution */
+    float                       lodDistance;    /* distance (in blocs) from which the chunks use the first lod level, doubled for each next one */
+    float                       lodHysteresis;  /* distance past a threshold before a chunk changes level */
+    lodStats_t                  lodStats;
+    bool                        caveCulling;
+    std::unordered_set<ckey_t, KeyHash> visibleChunks;
+    cullingStats_t              cullingStats[2];    /* camera under the open sky, camera in caves (out of the sky light) */
+    OcclusionBuffer*            occlusionBuffer;
+    bool                        occlusionCulling;
+    float                       occluderDistance;   /* distance (in blocs) of the farthest occluders */
+    uint                        maxOccluders;       /* occluder boxes rasterized per frame, the nearest first */
+    occlusionStats_t            occlusionStats;
+    chunkBounds_t               bounds;
+    std::vector<uint32_t>       visibleBounds;  /* the chunks in view found by the flat culling (indices in bounds) */
+    ColumnTree*                 columnTree;
+    bool                        hierarchicalCulling;
+    std::vector<Chunk*>         chunksInView;   /* the chunks in the fustrum and in range this frame */
+    std::vector<chunkSort_t>    renderList;     /* the chunks in view from front to back, kept between the frames */
+    std::vector<Chunk*>         drawList;       /* the chunks of the render list not culled by the caves or the terrain */
+    std::unordered_set<Chunk*>  evictedChunks;  /* deleted since the render list update */
+    uint64_t                    renderFrame;
+    bool                        frontToBack;    /* the opaque pass order (back to front only to compare the overdraw) */
+    GLuint                      renderQueries[2][3]; /* per frame parity: opaque samples, transparent samples, opaque time */
+    bool                        renderQueryFaces[2];    /* per frame parity: the frame was drawn with the face renderer */
+    bool                        faceRendering;  /* the faces pulled by the vertex shader, instead of the points expanded by the geometry shader */
+    renderStats_t               renderStats;
+    GLuint                      frameUniformBuffer;
+    bool                        debugStats;     /* print the stats every statsInterval milliseconds */
+    double                      statsInterval;
+    tTimePoint                  lastStatsPrint;
+    chunkUniforms_t             chunkUniforms;
+    fustrumStats_t              fustrumStats;
+    ChunkStreamer*              streamer;           /* nullptr without a shared context, the chunks are then generated on this thread */
+    std::unordered_set<ckey_t, KeyHash> streamingSet;   /* requested to the streamer, not received yet */
+    ComputeGenerator*           computeGenerator;   /* nullptr without compute shaders or with the streamer, the fragment shader generates the other chunks */
+    std::vector<ckey_t>         generationBatch;    /* the chunks added to the compute generator batch */
+    ComputeMesher*              computeMesher;      /* nullptr without compute shaders */
+    UploadRing*                 uploadRing;         /* the mesh uploads (see Chunk::setUploadRing) */
+    bool                        computeMeshing;     /* the full resolution chunks are meshed by the compute mesher */
 
     void                        setupChunkGenerationRenderingQuad( void );
     void                        setupChunkGenerationFbo( void );
+    void                        setupLatticeFbo( void );
+    void                        setupColumnFbo( void );
+    const column_t&             getColumn( const glm::vec3& chunkPosition );
+    void                        renderColumnGeneration( const glm::vec3& position, column_t& column );
+    void                        bindColumn( const glm::vec3& chunkPosition );
+    const bool                  isChunkAboveColumn( const column_t& column, const glm::vec3& position ) const;
+    void                        deleteUnusedColumns( void );
+    Chunk*                      loadChunk( const glm::vec3& chunkPosition );
+    void                        saveChunk( const glm::vec3& chunkPosition, Chunk* chunk );
+    void                        cacheChunk( const glm::vec3& chunkPosition, Chunk* chunk );
+    void                        evictChunk( const ckey_t& key );
+    void                        addChunkBounds( const ckey_t& key, Chunk* chunk );
+    void                        removeChunkBounds( const ckey_t& key );
+    void                        cullChunks( Camera& camera );
+    void                        updateRenderList( Camera& camera );
+    void                        readRenderQueries( void );
+    void                        governMemory( const glm::vec3& cameraPosition );
+    const int                   getLodLevel( float distance, int current ) const;
+    void                        updateChunkLods( const glm::vec3& cameraPosition );
+    const bool                  computeVisibleChunks( Camera& camera );
+    void                        buildOcclusionBuffer( Camera& camera );
+    void                        compareLatticeGeneration( const glm::vec3& position );
+    void                        compareCpuGeneration( const glm::vec3& position, const uint8_t* data );
     void                        renderChunkGeneration( const glm::vec3& position );
+    void                        generateBatch( void );
+    void                        receiveStreamedChunks( const glm::vec3& cameraPosition, const tTimePoint& frameStart );
+    void                        stopStreaming( void );
+    Chunk*                      createGeneratedChunk( const glm::vec3& position, const uint8_t* data );
+    void                        insertChunk( const ckey_t& key, Chunk* chunk );
+    void                        updateHorizon( const glm::vec3& cameraPosition );
+    void                        printStats( void ) const;
+    const int                   getUniformBloc( const uint8_t* data ) const;
 };
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <iostream>
+#include <vector>
+#include <deque>
+#include <chrono>
+#include <cstring>
+
+typedef std::chrono::duration<double,std::milli> tMilliseconds;
+typedef std::chrono::steady_clock::time_point tTimePoint;
+
+typedef struct  uploadRingStats_s {
+    uint64_t    frames;
+    uint64_t    uploads;
+    uint64_t    bytes;
+    uint64_t    lastFrameBytes;
+    uint64_t    staged;     /* uploads sent by the driver (no persistent mapping, or larger than the ring) */
+    uint64_t    stalls;     /* waits for a fence before writing into the ring */
+    double      stallMs;
+}               uploadRingStats_t;
+
+/*  Upload ring of the mesh data. With GL_ARB_buffer_storage the ring is a buffer mapped once, persistent and
+    coherent: the data is written straight into the mapped memory (see map) and copied on the GPU into its
+    buffer (see copy), without the driver copy and allocation of glBufferData. The bytes written in a frame
+    are fenced at the end of the frame, and a range of the ring is only written again once its fence is
+    signaled. Without the extension, upload and store hand the data straight to glBufferSubData and
+    glBufferData, and map returns a staging buffer for the data that has to be gathered first.
+*/
+class UploadRing {
+
+public:
+    UploadRing( size_t size = 8 << 20 );
+    ~UploadRing( void );
+
+    /* the memory to write the next upload into, valid until copy */
+    uint8_t*                map( size_t size );
+    /* copy the mapped bytes into the buffer, at the offset */
+    void                    copy( GLuint buffer, GLintptr offset );
+    /* allocate the buffer (glBufferData) with the mapped bytes, valid until store */
+    void                    store( GLuint buffer, GLenum usage );
+    /* map, write and copy, or send the data straight to the driver without persistent mapping */
+    void                    upload( GLuint buffer, GLintptr offset, const void* data, size_t size );
+    /* map, write and store, or allocate the buffer straight with the data without persistent mapping */
+    void                    store( GLuint buffer, const void* data, size_t size, GLenum usage );
+    /* once per frame: fence the bytes written since the last one */
+    void                    endFrame( void );
+    /* getters */
+    const bool              isPersistent( void ) const { return mapped != nullptr; };
+    const size_t            getSize( void ) const { return size; };
+    const uploadRingStats_t& getStats( void ) const { return stats; };
+
+private:
+    /* the bytes written in a frame, free once its fence is signaled */
+    typedef struct  segment_s {
+        GLsync  fence;
+        size_t  begin;
+        size_t  end;
+    }               segment_t;
+
+    GLuint                  buffer;
+    size_t                  size;
+    uint8_t*                mapped;         /* nullptr without persistent mapping */
+    std::vector<uint8_t>    staging;
+    std::deque<segment_t>   segments;       /* the fenced segments not signaled yet, oldest first */
+    size_t                  head;           /* where the next upload is written */
+    size_t                  frameBegin;     /* the first byte written in this frame */
+    size_t                  current;        /* the mapped upload: its offset in the ring and its size */
+    size_t                  currentSize;
+    bool                    currentStaged;
+    uint64_t                frameBytes;
+    uploadRingStats_t       stats;
+
+    void                    closeSegment( void );
+    void                    count( size_t size, bool staged );
+    void                    waitSegments( size_t begin, size_t end );
+
+};
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#include "Exception.hpp"
+
+/* the bloc ids written by the generation (same values as the defines of the generation shader) */
+enum class eBloc : uint8_t {
+    air = 0, dirt, grass, stone, bedrock, coal, iron, gold, lapis, redstone, diamond, gravel, sand, oakWood, oakLeaves, water
+};
+
+/* a 3d fbm noise field, the parameters of fbm3d() */
+typedef struct  field_s {
+    glm::vec3   offset;
+    float       amplitude;
+    float       frequency;
+    int         octaves;
+    float       lacunarity;
+    float       gain;
+    bool        ridged;     /* abs(v * 2 - 1) instead of v */
+}               field_t;
+
+/* a material rule: `from` becomes `to` below maxHeight, where the field is below the threshold */
+typedef struct  rule_s {
+    std::string name;
+    eBloc       from;
+    eBloc       to;
+    field_t     field;
+    float       threshold;
+    float       falloff;        /* threshold + (1 - y / falloffHeight) * falloff, ignored if 0 */
+    float       falloffHeight;
+    float       maxHeight;
+}               rule_t;
+
+/* consecutive rules applying to the same bloc, the first matching one wins */
+typedef struct  planGroup_s {
+    eBloc               from;
+    std::vector<int>    rules;
+}               planGroup_t;
+
+typedef struct  worldGenStats_s {
+    uint64_t    voxels;
+    uint64_t    fields;     /* rule fields evaluated by the plan */
+}               worldGenStats_t;
+
+/*  The layered material rules (ores, underground pockets) are described as a table. It is compiled
+    into an evaluation plan where a rule field is only evaluated when the bloc it applies to is present
+    (and below its max height). The plan is emitted as the GLSL function materialRules() inserted in the
+    generation shader, and evaluated by the CPU kernel map().
+*/
+class WorldGen {
+
+public:
+    WorldGen( const std::vector<rule_t>& rules, uint32_t seed );
+    ~WorldGen( void );
+
+    static const std::vector<rule_t>    defaultRules( void );
+
+    /* CPU kernel, same results as the generation shader (at full resolution) */
+    const uint8_t           map( const glm::vec3& p );
+    /* getters */
+    const std::string&      getGlslSource( void ) const { return glsl; };
+    const worldGenStats_t&  getStats( void ) const { return stats; };
+    const size_t            getRulesCount( void ) const { return rules.size(); };
+    const size_t            getFieldsCount( void ) const { return fields.size(); };
+    const uint32_t          getSeed( void ) const { return seed; };
+    /* identifies the generated world apart from the seed: the kernel version and the rules (stored with the saved chunks) */
+    const uint32_t          getGeneration( void ) const;
+
+    static const uint32_t   version = 1;    /* bumped when the kernel or the generation shader change the voxels */
+    /* the levels of the generation, also defined in the generated GLSL (WATER_LEVEL and BEDROCK_CEILING) */
+    static const int        waterLevel = 85;    /* the caves and the lows of the landscape open at this height are filled with water */
+    static const int        bedrockCeiling = 4; /* the highest bedrock voxels (the bedrock noise is at most 4.5) */
+
+private:
+    std::vector<rule_t>         rules;
+    std::vector<field_t>        fields;     /* the distinct fields used by the rules */
+    std::vector<int>            ruleField;  /* the field index of each rule */
+    std::vector<planGroup_t>    plan;
+    std::string                 glsl;
+    uint32_t                    seed;
+    worldGenStats_t             stats;
+
+    void                    compile( void );
+    void                    emitGlsl( void );
+    const float             hashValue( int x, int y, int z ) const;
+    const float             noise( const glm::vec3& x ) const;
+    const float             fbm3d( glm::vec3 st, float amplitude, float frequency, int octaves, float lacunarity, float gain ) const;
+    const float             evaluate( const field_t& field, const glm::vec3& p ) const;
+    const bool              isRuleMatching( int rule, const glm::vec3& p );
+    const int               caves( const glm::vec3& p ) const;
+};
@@ -9,6 +9,7 @@
 #include <vector>
 
 #include "Exception.hpp"
+#include "GLState.hpp"
 
 void        createCube( std::vector<GLfloat>& vertices, std::vector<unsigned int>& indices );
 glm::vec4   hex2vec( int64_t hex );
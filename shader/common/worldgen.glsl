@@ -0,0 +1,258 @@
+/*  The terrain generation: noise, fields and the bloc of a voxel (map). It is inserted in the generation
+    shaders (fragment and compute), which define columnTop and set paddedOrigin before calling map.
+*/
+uniform int seed;          /* the world seed, all the noise values derive from it */
+/* coarse lattice generation: the smooth fields are evaluated on a lattice, then interpolated per voxel */
+uniform int coarseLattice;  /* 1: the smooth fields are interpolated from the lattice */
+uniform ivec3 latticeStep;
+uniform ivec3 latticeSize;
+uniform sampler2D latticeSamplerA;
+uniform sampler2D latticeSamplerB;
+/* column cache: the 2d fields of the chunk column are evaluated once and shared by its chunks */
+uniform int useColumn;      /* 1: the voxels above the column terrain top skip the noise evaluation */
+
+vec3    paddedOrigin;       /* the world position of the first voxel of the padded chunk */
+float   columnTop( ivec2 c ); /* the terrain top of a column of the padded chunk */
+
+#define PI 3.14159265359
+
+float   random(vec2 p) {
+    return fract(sin(mod(dot(p, vec2(12.9898,78.233)), 3.14))*43758.5453);
+}
+
+/*  The noise is computed from an integer hash of the lattice points and the world seed. WorldGen (CPU)
+    implements the same functions: the operations contributing to a noise value are `precise` so the
+    compiler does not fuse or reorder them, and no division is used, the results are bit-identical.
+*/
+uint    hash( uint x ) {
+    x ^= x >> 16u;
+    x *= 0x7feb352du;
+    x ^= x >> 15u;
+    x *= 0x846ca68bu;
+    x ^= x >> 16u;
+    return x;
+}
+
+/* value in [0..1) of a lattice point, 24 bits so the conversion to float is exact */
+float   hashValue( ivec3 c ) {
+    uint h = hash(uint(c.x) ^ hash(uint(c.y) ^ hash(uint(c.z) ^ uint(seed))));
+    return ldexp(float(h >> 8u), -24);
+}
+
+vec2    random2(vec2 p) {
+    ivec2 c = ivec2(floor(p));
+    uint h = hash(uint(c.x) ^ hash(uint(c.y) ^ hash(uint(seed) ^ 0x9e3779b9u)));
+    return vec2(ldexp(float(h >> 16u), -16), ldexp(float(h & 0xffffu), -16));
+}
+
+float   lerp( float a, float b, float t ) {
+    precise float r = a + (b - a) * t;
+    return r;
+}
+
+float   ridged( float v ) {
+    precise float r = abs(v * 2.0 - 1.0);
+    return r;
+}
+
+/* value noise, trilinear interpolation of the lattice values with a smoothstep */
+float   noise( vec3 x ) {
+    precise vec3 p = floor(x);
+    precise vec3 f = x - p;
+    precise vec3 w = f * f * (3.0 - 2.0 * f);
+    ivec3 c = ivec3(p);
+    float x00 = lerp(hashValue(c + ivec3(0,0,0)), hashValue(c + ivec3(1,0,0)), w.x);
+    float x10 = lerp(hashValue(c + ivec3(0,1,0)), hashValue(c + ivec3(1,1,0)), w.x);
+    float x01 = lerp(hashValue(c + ivec3(0,0,1)), hashValue(c + ivec3(1,0,1)), w.x);
+    float x11 = lerp(hashValue(c + ivec3(0,1,1)), hashValue(c + ivec3(1,1,1)), w.x);
+    return lerp(lerp(x00, x10, w.y), lerp(x01, x11, w.y), w.z);
+}
+
+float   fbm2d(in vec2 st, in float amplitude, in float frequency, in int octaves, in float lacunarity, in float gain) {
+    precise float value = 0.0;
+    st *= frequency;
+    for (int i = 0; i < octaves; i++) {
+        value += amplitude * noise(vec3(st, 1.0));
+        st *= lacunarity;
+        amplitude *= gain;
+    }
+    return value;
+}
+
+float   fbm3d(in vec3 st, in float amplitude, in float frequency, in int octaves, in float lacunarity, in float gain) {
+    precise float value = 0.0;
+    st *= frequency;
+    for (int i = 0; i < octaves; i++) {
+        value += amplitude * noise(st);
+        st *= lacunarity;
+        amplitude *= gain;
+    }
+    return value;
+}
+
+vec2    voronoi2d( vec2 x ) {
+    vec2 n = floor(x);
+    vec2 f = fract(x);
+	vec3 m = vec3(8.0);
+    for (int j=-1; j<=1; j++)
+    for (int i=-1; i<=1; i++) {
+        vec2 g = vec2(i, j);
+        vec2 o = random2(n + g);
+        vec2 r = g - f + o;
+        float d = dot(r, r);
+        if (d < m.x)
+            m = vec3(d, o);
+    }
+    return vec2(sqrt(m.x), m.y+m.z);
+}
+
+/* the low-frequency landscape fields (terrain and stone layers), smooth enough to be interpolated */
+void    smoothFields( vec3 p, out vec4 a, out vec4 b ) {
+    a = vec4(
+        fbm3d(p, 0.4, 0.0075, 6, 1.7, 0.5),                 /*  low-frequency landscape */
+        fbm3d(p, 0.5, 0.0215, 4, 1.4, 0.5),                 /* high-frequency landscape */
+        fbm3d(p+vec3(0,16,0), 0.40, 0.0075, 5, 1.7, 0.5),   /*  low-frequency stone */
+        fbm3d(p+vec3(0,16,0), 0.55, 0.0215, 3, 1.4, 0.5)    /* high-frequency stone */
+    );
+    b = vec4(
+        fbm3d(p+vec3(0, 5,0), 0.40, 0.0075, 5, 1.7, 0.5),   /*  low-frequency stone */
+        fbm3d(p+vec3(0, 5,0), 0.55, 0.0215, 3, 1.4, 0.5),   /* high-frequency stone */
+        0.0,
+        0.0
+    );
+}
+
+vec4    latticeNode( sampler2D s, ivec3 n ) {
+    return texelFetch(s, ivec2(n.x, n.y * latticeSize.z + n.z), 0);
+}
+
+vec4    latticeInterpolate( sampler2D s, ivec3 n, vec3 f ) {
+    return mix(
+        mix(mix(latticeNode(s, n+ivec3(0,0,0)), latticeNode(s, n+ivec3(1,0,0)), f.x),
+            mix(latticeNode(s, n+ivec3(0,1,0)), latticeNode(s, n+ivec3(1,1,0)), f.x), f.y),
+        mix(mix(latticeNode(s, n+ivec3(0,0,1)), latticeNode(s, n+ivec3(1,0,1)), f.x),
+            mix(latticeNode(s, n+ivec3(0,1,1)), latticeNode(s, n+ivec3(1,1,1)), f.x), f.y),
+        f.z
+    );
+}
+
+/* trilinear interpolation of the smooth fields, p is the position in the padded chunk */
+void    latticeFields( vec3 p, out vec4 a, out vec4 b ) {
+    vec3 g = p / vec3(latticeStep);
+    ivec3 n = ivec3(floor(g));
+    vec3 f = g - vec3(n);
+    a = latticeInterpolate(latticeSamplerA, n, f);
+    b = latticeInterpolate(latticeSamplerB, n, f);
+}
+
+/* the highest voxel of the column where the landscape is solid (same fields as the voxels pass), -1 if none */
+float   terrainTop( vec2 xz ) {
+    for (float y = 255.0; y >= 0.0; y -= 1.0) {
+        vec3 p = vec3(xz.x, y, xz.y);
+        if (fbm3d(p, 0.4, 0.0075, 6, 1.7, 0.5) * 340. > p.y && fbm3d(p, 0.5, 0.0215, 4, 1.4, 0.5) * 340. > p.y)
+            return y;
+    }
+    return -1.0;
+}
+
+/* the 2d fields of a column: terrain top, tree mask and biome cell */
+vec4    columnFields( vec2 xz ) {
+    return vec4(
+        terrainTop(xz),
+        fbm2d(xz, 0.25, 0.01, 4, 2.7, 0.2),
+        voronoi2d(xz * 0.005).y,
+        0.0
+    );
+}
+
+/* caves and water pockets carved in the landscape */
+int     caves( vec3 p ) {
+    precise vec3 q0 = vec3(p.x-5, p.y*1.1   , p.z + 21.);
+    precise vec3 q1 = vec3(p.z  , p.y*1.1+4., p.x - 42.);
+    precise float tunnels = (1.0 - ridged(fbm3d(q0, 0.45, 0.067, 5, 1.3, 0.49))) *
+                            (1.0 - ridged(fbm3d(q1, 0.45, 0.046, 5, 0.9, 0.49)));
+    int g2 = int(tunnels < 0.91);
+    int g13 = int(fbm3d(p, 0.44, 0.04, 6, 2.0, 0.3) < 0.5);
+    return g2 & g13;
+}
+
+#define AIR 0.
+#define DIRT 1/255.
+#define GRASS 2/255.
+#define STONE 3/255.
+#define BEDROCK 4/255.
+#define COAL 5/255.
+#define IRON 6/255.
+#define GOLD 7/255.
+#define LAPIS 8/255.
+#define REDSTONE 9/255.
+#define DIAMOND 10/255.
+#define GRAVEL 11/255.
+#define SAND 12/255.
+#define OAK_WOOD 13/255.
+#define OAK_LEAVES 14/255.
+#define WATER 15/255.
+
+/* the threshold of a rule decreasing with the height */
+float   falloff( float y, float threshold, float invHeight, float amount ) {
+    precise float t = threshold + (1.0 - y * invHeight) * amount;
+    return t;
+}
+
+/* the material rules are generated by WorldGen and inserted here */
+#pragma worldgen_rules
+
+float   map(vec3 p) {
+    /* TODO : implement biomes with voronoi cells */
+    float res;
+    /* ceiling level */
+    if (p.y > 255)
+        return AIR;
+    /* above the column terrain top (and the bedrock noise), only the water level can be filled */
+    if (useColumn == 1) {
+        vec3 c = p - paddedOrigin;
+        if (p.y > max(columnTop(ivec2(c.xz)), BEDROCK_CEILING))
+            return (p.y == WATER_LEVEL && caves(p) == 1 ? WATER : AIR);
+    }
+    /* bedrock level */
+    if (p.y == 0 || (p.y <= BEDROCK_CEILING && fbm3d(p, 1.0, 20.0, 2, 1.5, 0.5) * 3. > p.y))
+        return BEDROCK;
+    vec4 fa, fb;
+    if (coarseLattice == 1)
+        latticeFields(p - paddedOrigin, fa, fb);
+    else
+        smoothFields(p, fa, fb);
+    /* terrain */
+    int g0 = int(fa.x * 340. > p.y); /*  low-frequency landscape */
+    int g1 = int(fa.y * 340. > p.y); /* high-frequency landscape */
+    /* above the landscape, only the water level can be filled */
+    if ((g0 & g1) == 0)
+        return (p.y == WATER_LEVEL && caves(p) == 1 ? WATER : AIR);
+    /* caves */
+    if (caves(p) == 0)
+        return AIR;
+    /* stone (we use the same values for fbm as landscape but with a vertical offset) */
+    int g7 = int(fa.z * 340. > p.y); /*  low-frequency landscape */
+       g7 &= int(fa.w * 340. > p.y); /* high-frequency landscape */
+       g7 &= int(fb.x * 340. > p.y); /*  low-frequency landscape */
+       g7 &= int(fb.y * 340. > p.y); /* high-frequency landscape */
+    /* trees */
+    // int g14= int(fbm2d(p.xz, 0.25, 0.01, 4, 2.7, 0.2) < 0.5);
+    //    g14&= int(fbm2d(p.xz, 0.47, 0.25, 4, 2.5, 0.1) < 0.5);
+    res = (g7 == 1 ? STONE : DIRT);
+    /* resource distribution and pockets of dirt and gravel in undergrounds (the ore fields are only evaluated in stone) */
+    res = materialRules(p, res);
+    return res;
+}
+
+/* the terrain top and the bloc seen from above of a horizon sample, the seas are flat at the water level */
+vec4    horizonFields( vec2 xz ) {
+    float top = terrainTop(xz);
+    if (top < WATER_LEVEL)
+        return vec4(WATER_LEVEL, 15.0, 0.0, 0.0);
+    float bloc = floor(map(vec3(xz.x, top, xz.y)) * 255.0 + 0.5);
+    /* dirt is covered by grass, and a cave opening shows the grass around it */
+    if (bloc == 0.0 || bloc == 1.0)
+        bloc = 2.0;
+    return vec4(top, bloc, 0.0, 0.0);
+}
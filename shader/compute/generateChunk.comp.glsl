@@ -0,0 +1,46 @@
+#version 430 core
+layout (local_size_x = 4, local_size_y = 4, local_size_z = 4) in;
+
+#define MAX_CHUNKS 16 /* ComputeGenerator::capacity */
+
+/* the voxels of the batch, four per word: per chunk, the padded chunk by x, then z, then y (as the fragment generation) */
+layout (std430, binding = 0) writeonly buffer voxels {
+    uint data[];
+};
+
+uniform ivec3 paddedSize;   /* the chunk and its margin, x is a multiple of 4 */
+uniform int margin;
+uniform int chunks;         /* chunks in the batch */
+uniform vec3 chunkPositions[MAX_CHUNKS];
+uniform sampler2DArray columnsSampler; /* the 2d fields of the column of each chunk (a layer per chunk) */
+
+int     chunk;              /* the chunk of the invocation */
+
+#pragma worldgen
+
+float   columnTop( ivec2 c ) {
+    return texelFetch(columnsSampler, ivec3(c, chunk), 0).r;
+}
+
+/*  One invocation per word (four voxels along x): the x of the word, y, and z in the chunk plus the chunk
+    times the padded size. The outer margins are border (255), as in the fragment generation.
+*/
+void    main() {
+    ivec3 g = ivec3(gl_GlobalInvocationID);
+    chunk = g.z / paddedSize.z;
+    ivec3 pos = ivec3(g.x * 4, g.y, g.z % paddedSize.z);
+    if (pos.x >= paddedSize.x || pos.y >= paddedSize.y || chunk >= chunks)
+        return;
+    paddedOrigin = chunkPositions[chunk] - float(margin)*0.5;
+    ivec3 low = ivec3(margin/2-1);
+    ivec3 border = paddedSize - 1;
+    uint word = 0u;
+    for (int i = 0; i < 4; ++i) {
+        ivec3 p = pos + ivec3(i, 0, 0);
+        uint bloc = 255u;
+        if (all(greaterThanEqual(p, low)) && all(lessThan(p, border)))
+            bloc = uint(map(paddedOrigin + vec3(p)) * 255.0 + 0.5);
+        word |= bloc << (8 * i);
+    }
+    data[(((chunk * paddedSize.y + pos.y) * paddedSize.z + pos.z) * paddedSize.x + pos.x) / 4] = word;
+}
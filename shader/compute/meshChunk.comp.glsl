@@ -0,0 +1,190 @@
+#version 430 core
+layout (local_size_x = 4, local_size_y = 4, local_size_z = 4) in;
+
+#define BUCKETS 12 /* ComputeMesher::buckets: the directions of the opaque faces, then of the water */
+#define FAILURE_LOG 256 /* ComputeMesher::failureLog: the last failed slots kept */
+
+/* the padded volumes of the chunk, four voxels per word: the bloc ids then the light values (by x, then z, then y) */
+layout (std430, binding = 0) readonly buffer volume {
+    uint voxels[];
+};
+/*  the arena top, the meshes failed so far and the failure of this mesh, then per bucket: faces counted, first
+    face, faces written. The slots of the failed meshes are logged in a ring, read back to remesh them
+*/
+layout (std430, binding = 1) buffer state {
+    uint top;
+    uint failures;
+    uint failed;
+    uint counts[BUCKETS];
+    uint firsts[BUCKETS];
+    uint cursors[BUCKETS];
+    uint failedSlots[FAILURE_LOG];
+};
+/* per slot, its range of the arena (first face, capacity) */
+layout (std430, binding = 2) buffer slots {
+    uvec2 ranges[];
+};
+struct drawCommand {
+    uint count;
+    uint instanceCount;
+    uint first;
+    uint baseInstance;
+};
+/* per slot, the draw command of each bucket (see glDrawArraysIndirect) */
+layout (std430, binding = 3) writeonly buffer commands {
+    drawCommand drawCommands[];
+};
+/* the face arena, two words per face (see face_t in Chunk.hpp) */
+layout (std430, binding = 4) writeonly buffer faces {
+    uvec2 arena[];
+};
+
+uniform int pass;           /* 0: count the faces, 1: give the slot its range, 2: write the faces */
+uniform int slot;
+uniform uint arenaSize;     /* in faces */
+uniform ivec3 chunkSize;
+uniform ivec3 paddedSize;
+uniform int margin;
+
+/* the 20 neighbours of the ao, above, around and below the voxel (see Chunk::getVerticesAoValue) */
+const ivec3[20] aoNeighbours = ivec3[20](
+    ivec3(-1, 1,-1), ivec3( 0, 1,-1), ivec3( 1, 1,-1), ivec3( 1, 1, 0), ivec3( 1, 1, 1), ivec3( 0, 1, 1), ivec3(-1, 1, 1), ivec3(-1, 1, 0),
+    ivec3(-1, 0,-1), ivec3( 1, 0,-1), ivec3( 1, 0, 1), ivec3(-1, 0, 1),
+    ivec3(-1,-1,-1), ivec3( 0,-1,-1), ivec3( 1,-1,-1), ivec3( 1,-1, 0), ivec3( 1,-1, 1), ivec3( 0,-1, 1), ivec3(-1,-1, 1), ivec3(-1,-1, 0)
+);
+/* per face (+x, -x, +y, -y, +z, -z) and corner: the three neighbours of the corner and its shift in the ao byte */
+const ivec4[24] aoCorners = ivec4[24](
+    ivec4(10, 4, 3, 2), ivec4( 3, 2, 9, 0), ivec4( 9,14,15, 4), ivec4(15,16,10, 6),
+    ivec4( 8, 0, 7, 6), ivec4( 7, 6,11, 2), ivec4(11,18,19, 0), ivec4(19,12, 8, 4),
+    ivec4( 7, 0, 1, 4), ivec4( 1, 2, 3, 6), ivec4( 3, 4, 5, 2), ivec4( 5, 6, 7, 0),
+    ivec4(19,12,13, 4), ivec4(13,14,15, 0), ivec4(15,16,17, 2), ivec4(17,18,19, 6),
+    ivec4(11, 6, 5, 6), ivec4( 5, 4,10, 2), ivec4(10,16,17, 0), ivec4(17,18,11, 4),
+    ivec4( 9, 2, 1, 2), ivec4( 1, 0, 8, 0), ivec4( 8,12,13, 4), ivec4(13,14, 9, 6)
+);
+
+int     yStep;
+int     offsets[6];         /* the index offset of the neighbour of each face */
+
+uint    bloc( int i ) {
+    return (voxels[i >> 2] >> ((i & 3) * 8)) & 0xFFu;
+}
+
+uint    light( int i ) {
+    int j = i + paddedSize.x * paddedSize.z * paddedSize.y;
+    return (voxels[j >> 2] >> ((j & 3) * 8)) & 0xFFu;
+}
+
+bool    isTransparent( int i ) {
+    uint b = bloc(i);
+    return (b == 0u || b == 15u);
+}
+
+/* the faces of the voxel (a bit per direction), as Chunk::buildMesh: the faces of an opaque voxel against the
+   transparent ones, the top and bottom of the water unless it is surrounded */
+uint    visibleFaces( int i ) {
+    uint mask = 0u;
+    if (!isTransparent(i)) {
+        for (int f = 0; f < 6; ++f)
+            mask |= uint(isTransparent(i + offsets[f])) << f;
+        return mask;
+    }
+    if (bloc(i) != 15u)
+        return 0u;
+    for (int f = 0; f < 6; ++f)
+        mask |= uint(bloc(i + offsets[f]) == 0u);
+    return (mask != 0u ? 0x0Cu : 0u);
+}
+
+/*  the ao of the four corners of a face, and whether its quad is flipped. Each corner is darkened by the two
+    voxels along its edges (1.5 each) and the one of its corner (see Chunk::getVerticesAoValue)
+*/
+uint    faceAo( int p[20], int f, out bool flipped ) {
+    uint ao = 0u;
+    for (int c = 0; c < 4; ++c) {
+        ivec4 corner = aoCorners[f * 4 + c];
+        ao |= uint(min(float(p[corner.x]) * 1.5 + float(p[corner.y]) + float(p[corner.z]) * 1.5, 3.0)) << corner.w;
+    }
+    uvec4 v = uvec4(ao, ao >> 2, ao >> 4, ao >> 6) & 0x3u;
+    flipped = (v.z * v.z + v.y * v.y > v.w * v.w + v.x * v.x);
+    return ao;
+}
+
+/* one invocation: the commands and ranges of the slot are written once all the faces are counted */
+void    allocate() {
+    uint total = 0u;
+    for (int b = 0; b < BUCKETS; ++b)
+        total += counts[b];
+    uvec2 range = ranges[slot];
+    failed = 0u;
+    if (total > range.y) { /* a new range, with room for the next meshes of the slot (the outgrown one is reclaimed by the next relocation) */
+        uint capacity = (total + total / 4u + 63u) & ~63u;
+        if (top + capacity > arenaSize) {
+            failedSlots[failures % FAILURE_LOG] = uint(slot);
+            failures += 1u;
+            failed = 1u;
+        }
+        else {
+            range = uvec2(top, capacity);
+            ranges[slot] = range;
+            top += capacity;
+        }
+    }
+    uint first = range.x;
+    for (int b = 0; b < BUCKETS; ++b) {
+        uint count = (failed == 0u ? counts[b] : 0u);
+        drawCommands[slot * BUCKETS + b] = drawCommand(count * 6u, 1u, first * 6u, 0u);
+        firsts[b] = first;
+        cursors[b] = 0u;
+        counts[b] = 0u;
+        first += count;
+    }
+}
+
+/* one invocation per voxel of the chunk */
+void    main() {
+    if (pass == 1) {
+        if (gl_GlobalInvocationID == uvec3(0))
+            allocate();
+        return;
+    }
+    ivec3 c = ivec3(gl_GlobalInvocationID);
+    if (any(greaterThanEqual(c, chunkSize)))
+        return;
+    int m = margin / 2;
+    yStep = paddedSize.x * paddedSize.z;
+    offsets = int[6]( 1, -1, yStep, -yStep, paddedSize.x, -paddedSize.x );
+    int i = (c.x + m) + (c.z + m) * paddedSize.x + (c.y + m) * yStep;
+    uint mask = visibleFaces(i);
+    if (mask == 0u)
+        return;
+    bool water = (bloc(i) == 15u);
+    int bucket = (water ? 6 : 0);
+    if (pass == 0) {
+        for (int f = 0; f < 6; ++f)
+            if ((mask & (1u << f)) != 0u)
+                atomicAdd(counts[bucket + f], 1u);
+        return;
+    }
+    if (failed != 0u)
+        return;
+    int p[20];
+    for (int n = 0; n < 20; ++n)
+        p[n] = int(!isTransparent(i + aoNeighbours[n].x + aoNeighbours[n].z * paddedSize.x + aoNeighbours[n].y * yStep));
+    uint id = (bloc(i) - 1u) & 0xFFu;
+    if (bloc(i) == 1u && bloc(i + yStep) == 0u && light(i + yStep) > 1u) /* dirt to grass on top */
+        id = 1u;
+    uint position = uint(c.x) | (uint(c.y) << 8) | (uint(c.z) << 16);
+    for (int f = 0; f < 6; ++f) {
+        if ((mask & (1u << f)) == 0u)
+            continue;
+        bool flipped;
+        uint ao = faceAo(p, f, flipped);
+        uint underwater = uint(!water && bloc(i + offsets[f]) == 15u);
+        uint faceLight = light(i + offsets[f]) & 0xFu;
+        uint n = atomicAdd(cursors[bucket + f], 1u);
+        arena[firsts[bucket + f] + n] = uvec2(
+            position | (uint(f) << 24) | (uint(flipped) << 27) | (underwater << 28),
+            id | (ao << 8) | (faceLight << 16)
+        );
+    }
+}
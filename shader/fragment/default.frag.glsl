@@ -34,9 +34,14 @@ flat in int Underwater; // underwater faces
 
 /* uniforms */
 uniform sampler2D atlas;
-uniform vec3 cameraPos;
 uniform sDirectionalLight directionalLight;
-uniform int cameraUnderwater;
+
+/* the per frame state, shared by the stages (see Terrain::renderChunks) */
+layout (std140) uniform frame {
+    mat4 viewProjection;
+    vec4 cameraPosition;
+    int cameraUnderwater;
+};
 
 sMaterial material = sMaterial(
     vec3(0.4),
@@ -84,7 +89,7 @@ vec4    getBlocTexture( void ) {
 }
 
 void main() {
-    vec3 viewDir = normalize(cameraPos - FragPos);
+    vec3 viewDir = normalize(cameraPosition.xyz - FragPos);
     vec3 result = computeDirectionalLight(directionalLight, Normal, viewDir, vec4(0.0));
     
     // if (mod(FragPos.x, 32.0)*mod(FragPos.y, 32.0)*mod(FragPos.z, 32.0) <= 0.5) {	
@@ -100,9 +105,9 @@ void main() {
         FragColor = FragColor * vec4(0.5, 0.53, 1., 1);
     /* if we're underwater, add blue effect */
     if (cameraUnderwater == 1) {
-        float d = max(1-min(8./distance(cameraPos, FragPos), 1), 0.15);
+        float d = max(1-min(8./distance(cameraPosition.xyz, FragPos), 1), 0.15);
         FragColor += vec4(-d*0.03, d*0.01, d*0.1, 0); // tint
-        FragColor = mix(FragColor, vec4(0.1, 0.2, 1, 1), max(1-min(30./distance(cameraPos, FragPos), 1), 0.0)); // fog
+        FragColor = mix(FragColor, vec4(0.1, 0.2, 1, 1), max(1-min(30./distance(cameraPosition.xyz, FragPos), 1), 0.0)); // fog
     }
 }
 
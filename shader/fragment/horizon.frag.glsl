@@ -0,0 +1,31 @@
+#version 400 core
+out vec4 FragColor;
+
+in vec3 FragPos;
+in vec3 Normal;
+flat in int Bloc;
+
+uniform sampler2D atlas;
+uniform vec3 cameraPos;
+uniform float innerDistance;    /* the chunks are rendered up to this distance */
+uniform float outerDistance;    /* the extent of the coarsest level, the terrain fades out before it */
+uniform vec4 innerBounds;       /* the area covered by the finer level (min xz, max xz) */
+
+/* the top textures of the blocs (same as the offsets of the default shader, by bloc id) */
+const ivec2 topOffsets[16] = ivec2[](
+    ivec2(0, 0), ivec2(2, 0), ivec2(0, 0), ivec2(1, 0), ivec2(1, 1), ivec2(2, 2), ivec2(1, 2), ivec2(0, 2),
+    ivec2(0,10), ivec2(3, 3), ivec2(2, 3), ivec2(3, 1), ivec2(2, 1), ivec2(5, 1), ivec2(5, 3), ivec2(4,33)
+);
+const vec3 sunDirection = normalize(vec3(0.4, 1.0, 0.3));
+
+void main() {
+    float d = distance(cameraPos.xz, FragPos.xz);
+    if (d < innerDistance)
+        discard;
+    if (all(greaterThan(FragPos.xz, innerBounds.xy)) && all(lessThan(FragPos.xz, innerBounds.zw)))
+        discard;
+    /* the last mipmap level of the atlas has one texel per bloc texture, their average color */
+    vec3 color = texelFetch(atlas, topOffsets[Bloc], 4).rgb;
+    float light = 0.55 + 0.45 * max(dot(normalize(Normal), sunDirection), 0.0);
+    FragColor = vec4(color * light, 1.0 - smoothstep(outerDistance * 0.8, outerDistance, d));
+}
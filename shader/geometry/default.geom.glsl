@@ -17,7 +17,12 @@ out float Light;
 flat out int Underwater; // TMP
 flat out int Id;
 
-uniform vec3 viewPos;
+/* the per frame state, shared by the stages (see Terrain::renderChunks) */
+layout (std140) uniform frame {
+    mat4 viewProjection;
+    vec4 cameraPosition;
+    int cameraUnderwater;
+};
 
 const float[4] aoCurve = float[4]( 1.0, 0.55, 0.3, .1 ); // BEST
 // const float[4] aoCurve = float[4]( 1.0, 0.7, 0.6, 0.15 ); // best soft
@@ -80,28 +85,28 @@ void    main() {
     // Light = (float((gAo[0][1] & 0xFF000000) >> 24)/15)*0.75+0.25;
 
     // Normal = vec3( 1.0, 0.0, 0.0);
-    // if ( (gVisibleFaces[0] & 0x20) != 0 && dot(Normal, (FragPos + dx.xyz) - viewPos) < 0) /* right */
+    // if ( (gVisibleFaces[0] & 0x20) != 0 && dot(Normal, (FragPos + dx.xyz) - cameraPosition.xyz) < 0) /* right */
     //     AddQuad(center + dx, dy, dz, (gAo[0][0] & 0xFF000000) >> 24, false);
     // Normal = vec3(-1.0, 0.0, 0.0);
-    // if ( (gVisibleFaces[0] & 0x10) != 0 && dot(Normal, (FragPos - dx.xyz) - viewPos) < 0) /* left */
+    // if ( (gVisibleFaces[0] & 0x10) != 0 && dot(Normal, (FragPos - dx.xyz) - cameraPosition.xyz) < 0) /* left */
     //     AddQuad(center - dx, dz, dy, (gAo[0][0] & 0x00FF0000) >> 16, true);
     // Normal = vec3( 0.0, 1.0, 0.0);
-    // if ( (gVisibleFaces[0] & 0x02) != 0 && dot(Normal, (FragPos + dy.xyz) - viewPos) < 0) /* top */
+    // if ( (gVisibleFaces[0] & 0x02) != 0 && dot(Normal, (FragPos + dy.xyz) - cameraPosition.xyz) < 0) /* top */
     //     AddQuad(center + dy, dz, dx, (gAo[0][1] & 0x0000FF00) >> 8, false);
     // Normal = vec3( 0.0,-1.0, 0.0);
-    // if ( (gVisibleFaces[0] & 0x01) != 0 && dot(Normal, (FragPos - dy.xyz) - viewPos) < 0) /* bottom */
+    // if ( (gVisibleFaces[0] & 0x01) != 0 && dot(Normal, (FragPos - dy.xyz) - cameraPosition.xyz) < 0) /* bottom */
     //     AddQuad(center - dy, dx, dz, (gAo[0][1] & 0x000000FF), false);
     // Normal = vec3( 0.0, 0.0, 1.0);
-    // if ( (gVisibleFaces[0] & 0x08) != 0 && dot(Normal, (FragPos + dz.xyz) - viewPos) < 0) /* front */
+    // if ( (gVisibleFaces[0] & 0x08) != 0 && dot(Normal, (FragPos + dz.xyz) - cameraPosition.xyz) < 0) /* front */
     //     AddQuad(center + dz, dx, dy, (gAo[0][0] & 0x0000FF00) >> 8, true);
     // Normal = vec3( 0.0, 0.0,-1.0);
-    // if ( (gVisibleFaces[0] & 0x04) != 0 && dot(Normal, (FragPos - dz.xyz) - viewPos) < 0) /* back */
+    // if ( (gVisibleFaces[0] & 0x04) != 0 && dot(Normal, (FragPos - dz.xyz) - cameraPosition.xyz) < 0) /* back */
     //     AddQuad(center - dz, dy, dx, (gAo[0][0] & 0x000000FF), false);
 
     int flippedQuads = (gAo[0][1] & 0x00FF0000) >> 16;
     /* fixes visual issue (partially, best is to pass faces to geometry shader and compute them on CPU, instead of point) */
     Normal = vec3( 1.0, 0.0, 0.0);
-    if (dot(Normal, (FragPos + dx.xyz) - viewPos) < 0) {
+    if (dot(Normal, (FragPos + dx.xyz) - cameraPosition.xyz) < 0) {
         if ( (gVisibleFaces[0] & 0x20) != 0) { /* right */
             Light = (float((gLight[0] & 0xF00000) >> 20)/15);
             Underwater = int((gLight[0]&(0x1<<29)) != 0);
@@ -125,7 +130,7 @@ void    main() {
         }
     }
     Normal = vec3( 0.0, 1.0, 0.0);
-    if (dot(Normal, (FragPos + dy.xyz) - viewPos) < 0) {
+    if (dot(Normal, (FragPos + dy.xyz) - cameraPosition.xyz) < 0) {
         if ( (gVisibleFaces[0] & 0x02) != 0) { /* top */
             Light = (float((gLight[0] & 0x0000F0) >> 4)/15);
             Underwater = int((gLight[0]&(0x1<<25)) != 0);
@@ -149,7 +154,7 @@ void    main() {
         }
     }
     Normal = vec3( 0.0, 0.0, 1.0);
-    if (dot(Normal, (FragPos + dz.xyz) - viewPos) < 0) {
+    if (dot(Normal, (FragPos + dz.xyz) - cameraPosition.xyz) < 0) {
         if ( (gVisibleFaces[0] & 0x08) != 0) { /* front */
             Light = (float((gLight[0] & 0x00F000) >> 12)/15);
             Underwater = int((gLight[0]&(0x1<<27)) != 0);
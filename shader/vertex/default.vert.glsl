@@ -4,6 +4,7 @@ layout (location = 1) in ivec2 aAo;
 layout (location = 2) in int aId;
 layout (location = 3) in int aVisibleFaces;
 layout (location = 4) in int aLight;
+layout (location = 5) in vec4 aChunk; /* per chunk: the offset (xyz) and the scale (w) of its cells */
 
 out mat4 mvp;
 out vec3 gFragPos;
@@ -12,15 +13,26 @@ flat out int gId;
 flat out int gVisibleFaces;
 flat out int gLight;
 
-uniform mat4 _model;
-uniform mat4 _mvp;
+/* the per frame state, shared by the stages (see Terrain::renderChunks) */
+layout (std140) uniform frame {
+    mat4 viewProjection;
+    vec4 cameraPosition;
+    int cameraUnderwater;
+};
+uniform int waterOffset; /* the raise of the water in the pass */
 
 void main() {
-    gl_Position = _mvp * vec4(aPos, 1.0);
-    mvp = _mvp;
+    mat4 model = mat4(
+        vec4(aChunk.w, 0.0, 0.0, 0.0),
+        vec4(0.0, aChunk.w, 0.0, 0.0),
+        vec4(0.0, 0.0, aChunk.w, 0.0),
+        vec4(aChunk.xyz + vec3(0.0, waterOffset, 0.0), 1.0)
+    );
+    mvp = viewProjection * model;
+    gl_Position = mvp * vec4(aPos, 1.0);
     gAo = aAo;
     gId = aId;
     gVisibleFaces = aVisibleFaces;
     gLight = aLight;
-    gFragPos = vec3(_model * vec4(aPos, 1.0));
+    gFragPos = vec3(model * vec4(aPos, 1.0));
 }
\ No newline at end of file
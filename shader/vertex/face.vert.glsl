@@ -0,0 +1,78 @@
+#version 400 core
+layout (location = 5) in vec4 aChunk; /* per chunk: the offset (xyz) and the scale (w) of its cells */
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec2 TexCoords;
+out float Ao;
+out float Light;
+flat out int Underwater;
+flat out int Id;
+
+/* the per frame state, shared by the stages (see Terrain::renderChunks) */
+layout (std140) uniform frame {
+    mat4 viewProjection;
+    vec4 cameraPosition;
+    int cameraUnderwater;
+};
+
+uniform int waterOffset; /* the raise of the water in the pass */
+uniform usamplerBuffer faces; /* two words per face (see face_t in Chunk.hpp) */
+
+const float[4] aoCurve = float[4]( 1.0, 0.55, 0.3, .1 );
+/* per face (+x, -x, +y, -y, +z, -z): the normal axis, the axes the corners move along (y then x of the quad) */
+const ivec3[6] faceAxes = ivec3[6]( ivec3(0, 1, 2), ivec3(0, 2, 1), ivec3(1, 2, 0), ivec3(1, 0, 2), ivec3(2, 0, 1), ivec3(2, 1, 0) );
+const bool[6] faceFlipUv = bool[6]( false, true, false, false, true, false );
+/* the two triangles of a quad, over its corners (see AddQuad and AddQuadFlipped in default.geom.glsl)
+   3 +---+ 2
+     |   |
+   1 +---+ 0 */
+const int[6] quadCorners = int[6]( 0, 1, 2, 2, 1, 3 );
+const int[6] flippedQuadCorners = int[6]( 1, 3, 0, 0, 3, 2 );
+
+/*  Each face is six vertices, gl_VertexID selects the face and its corner. As the geometry shader, only the
+    face of an axis facing the camera is drawn, the other one is collapsed to a point out of the view.
+*/
+void main() {
+    uvec2 face = texelFetch(faces, gl_VertexID / 6).xy;
+    vec3 position = vec3(face.x & 0xFFu, (face.x >> 8) & 0xFFu, (face.x >> 16) & 0xFFu);
+    int f = int((face.x >> 24) & 0x7u);
+    bool flipped = ((face.x >> 27) & 0x1u) != 0u;
+    mat4 model = mat4(
+        vec4(aChunk.w, 0.0, 0.0, 0.0),
+        vec4(0.0, aChunk.w, 0.0, 0.0),
+        vec4(0.0, 0.0, aChunk.w, 0.0),
+        vec4(aChunk.xyz + vec3(0.0, waterOffset, 0.0), 1.0)
+    );
+    mat4 mvp = viewProjection * model;
+    ivec3 axes = faceAxes[f];
+    float side = ((f & 1) == 0 ? 1.0 : -1.0);
+
+    FragPos = vec3(model * vec4(position, 1.0));
+    bool positiveSeen = (FragPos[axes.x] + mvp[axes.x][axes.x] / 2.0 - cameraPosition[axes.x] < 0.0);
+    if (positiveSeen != (side > 0.0)) {
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+        return;
+    }
+    /* in clip space, as the geometry shader does */
+    int corner = (flipped ? flippedQuadCorners[gl_VertexID % 6] : quadCorners[gl_VertexID % 6]);
+    vec4 center = mvp * vec4(position, 1.0) + side * mvp[axes.x] / 2.0;
+    vec4 dy = (corner >= 2 ? 1.0 : -1.0) * mvp[axes.y] / 2.0;
+    vec4 dx = ((corner & 1) == 0 ? 1.0 : -1.0) * mvp[axes.z] / 2.0;
+    gl_Position = center + (dx + dy);
+
+    Normal = vec3(0.0);
+    Normal[axes.x] = side;
+    if (corner == 0)
+        TexCoords = (faceFlipUv[f] ? vec2(1, 0) : vec2(0, 1));
+    else if (corner == 1)
+        TexCoords = vec2(1, 1);
+    else if (corner == 2)
+        TexCoords = vec2(0, 0);
+    else
+        TexCoords = (faceFlipUv[f] ? vec2(0, 1) : vec2(1, 0));
+    Ao = aoCurve[(face.y >> (8u + uint(3 - corner) * 2u)) & 0x3u];
+    Light = float((face.y >> 16) & 0xFu) / 15.0;
+    Underwater = int((face.x >> 28) & 0x1u);
+    Id = int(face.y & 0xFFu);
+}
@@ -0,0 +1,31 @@
+#version 400 core
+layout (location = 0) in vec2 aGrid;
+
+out vec3 FragPos;
+out vec3 Normal;
+flat out int Bloc;
+
+uniform mat4 _vp;
+uniform sampler2D samples;  /* terrain top and bloc of the level samples, addressed modulo the level size */
+uniform ivec2 origin;       /* the first sample of the level (in samples) */
+uniform int size;
+uniform float step;
+
+vec2    fetchSample( ivec2 g ) {
+    g = clamp(g, origin, origin + size - 1);
+    return texelFetch(samples, ivec2(mod(vec2(g), float(size))), 0).rg;
+}
+
+void main() {
+    ivec2 g = origin + ivec2(aGrid);
+    vec2 s = fetchSample(g);
+    /* the voxels are centered on their position, the terrain top is half a bloc above */
+    FragPos = vec3(g.x * step, s.r + 0.5, g.y * step);
+    Normal = normalize(vec3(
+        fetchSample(g - ivec2(1, 0)).r - fetchSample(g + ivec2(1, 0)).r,
+        2.0 * step,
+        fetchSample(g - ivec2(0, 1)).r - fetchSample(g + ivec2(0, 1)).r
+    ));
+    Bloc = int(s.g);
+    gl_Position = _vp * vec4(FragPos, 1.0);
+}
@@ -187,6 +187,45 @@ bool    Camera::aabInFustrum( const glm::vec3& p, const glm::vec3& size ) {
 	return true;
 }
 
+/*  aabInFustrum over boxes of the same size, their centers (in world space, not negated) stored in structure
+    of arrays. A box is out of a plane when dot(n, -c) + d + dot(|n|, size / 2) < 0, the indices of the boxes
+    in the fustrum are appended to visible. Eight boxes per iteration with SSE.
+*/
+void    Camera::aabsInFustrum( const float* x, const float* y, const float* z, const glm::vec3& size, size_t count, std::vector<uint32_t>& visible ) const {
+    float nx[6], ny[6], nz[6], t[6];
+    for (int p = 0; p < 6; ++p) {
+        const glm::vec3& n = this->planes[p].normal;
+        nx[p] = n.x;
+        ny[p] = n.y;
+        nz[p] = n.z;
+        t[p] = this->planes[p].d + glm::dot(glm::abs(n), size * 0.5f);
+    }
+    size_t i = 0;
+#if defined(__SSE2__)
+    for (; i + 8 <= count; i += 8) {
+        const __m128 x0 = _mm_loadu_ps(x + i), x1 = _mm_loadu_ps(x + i + 4);
+        const __m128 y0 = _mm_loadu_ps(y + i), y1 = _mm_loadu_ps(y + i + 4);
+        const __m128 z0 = _mm_loadu_ps(z + i), z1 = _mm_loadu_ps(z + i + 4);
+        __m128 in0 = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        __m128 in1 = in0;
+        for (int p = 0; p < 6; ++p) {
+            const __m128 px = _mm_set1_ps(nx[p]), py = _mm_set1_ps(ny[p]), pz = _mm_set1_ps(nz[p]), pt = _mm_set1_ps(t[p]);
+            in0 = _mm_and_ps(in0, _mm_cmple_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(px, x0), _mm_mul_ps(py, y0)), _mm_mul_ps(pz, z0)), pt));
+            in1 = _mm_and_ps(in1, _mm_cmple_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(px, x1), _mm_mul_ps(py, y1)), _mm_mul_ps(pz, z1)), pt));
+        }
+        for (int mask = _mm_movemask_ps(in0) | (_mm_movemask_ps(in1) << 4); mask != 0; mask &= mask - 1)
+            visible.push_back(static_cast<uint32_t>(i + __builtin_ctz(mask)));
+    }
+#endif
+    for (; i < count; ++i) {
+        bool in = true;
+        for (int p = 0; p < 6 && in; ++p)
+            in = (nx[p] * x[i] + ny[p] * y[i] + nz[p] * z[i] <= t[p]);
+        if (in)
+            visible.push_back(static_cast<uint32_t>(i));
+    }
+}
+
 float   distancePointToPlane( const glm::vec3& point, const tPlane& plane ) {
     return glm::dot(plane.normal, point) + plane.d;
 }
\ No newline at end of file
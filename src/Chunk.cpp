@@ -1,37 +1,400 @@
 #include "Chunk.hpp"
 #include "glm/ext.hpp"
 
-Chunk::Chunk( const glm::vec3& position, const glm::ivec3& chunkSize, const uint8_t* texture, const uint margin ) : position(position), chunkSize(chunkSize), margin(margin), meshed(false), lighted(false), underground(false), outOfRange(false) {
+uint    Chunk::materializedCount = 0;
+uint    Chunk::computeMeshedCount = 0;
+GLuint                  Chunk::instanceBuffer = 0;
+size_t                  Chunk::instanceCapacity = 0;
+std::vector<glm::vec4>  Chunk::instances;
+std::vector<int>        Chunk::freeInstances;
+ComputeMesher*          Chunk::computeMesher = nullptr;
+bool                    Chunk::computeMeshing = false;
+UploadRing*             Chunk::uploadRing = nullptr;
+
+/* the chunk objects and their buffers come from fixed-size pools (see Pool.hpp) */
+void*   Chunk::operator new( size_t size ) {
+    return Pool::forSize(size).allocate();
+}
+
+void    Chunk::operator delete( void* ptr, size_t size ) {
+    Pool::forSize(size).release(ptr);
+}
+
+static uint8_t* allocateBuffer( size_t size ) {
+    return static_cast<uint8_t*>(Pool::forSize(size).allocate());
+}
+
+static void     releaseBuffer( uint8_t* buffer, size_t size ) {
+    Pool::forSize(size).release(buffer);
+}
+
+/* the padded volumes of the chunk being processed, shared by all the chunks */
+/* the directions of the neighbouring chunks, in the order of the sides (+x, -x, +y, -y, +z, -z) */
+static const std::array<glm::ivec3, 6>  sideDirections = { glm::ivec3(1, 0, 0), glm::ivec3(-1, 0, 0), glm::ivec3(0, 1, 0), glm::ivec3(0, -1, 0), glm::ivec3(0, 0, 1), glm::ivec3(0, 0, -1) };
+
+static std::vector<uint8_t> haloTexture;
+static std::vector<uint8_t> haloLightMap;
+
+Chunk::Chunk( const glm::vec3& position, const glm::ivec3& chunkSize, const uint8_t* texture, const uint margin ) : position(position), chunkSize(chunkSize), margin(margin), meshed(false), lighted(false), underground(false), outOfRange(false), uniform(false), uniformId(0), uniformLight(0), uniformMask(15), modified(true), approximate(false), lodLevel(0), seamsChanged(false) {
     this->createModelTransform(position);
     this->paddedSize = chunkSize + static_cast<int>(margin);
     this->y_step = paddedSize.x * paddedSize.z;
     this->sidesWaterUpdate = 0;
     this->sidesLightUpdate = 0;
     this->firstLightPass = true;
+    this->mesh_opaque.vao = this->mesh_opaque.vbo = 0;
+    this->mesh_transparent.vao = this->mesh_transparent.vbo = 0;
+    this->connectivity.fill(0x3F);
+    this->occluderLayers = glm::ivec2(0);
+    this->geometryMin = glm::vec3(INFINITY);
+    this->geometryMax = glm::vec3(-INFINITY);
+    this->renderFrame = 0;
+    this->instance = -1;
+    this->computeMeshed = false;
+    this->mesh_opaque.faceVao = this->mesh_transparent.faceVao = 0;
+    this->mesh_opaque.faces = this->mesh_transparent.faces = 0;
+    this->texture = nullptr;
+    this->lightMap = nullptr;
 
-    this->texture = static_cast<uint8_t*>(malloc(sizeof(uint8_t) * paddedSize.x * paddedSize.y * paddedSize.z));
-    memcpy(this->texture, texture, paddedSize.x * paddedSize.y * paddedSize.z);
+    /* only the chunk and the ring written by the generation are kept, the rest of the margin is border */
+    const int size = chunkSize.x * chunkSize.y * chunkSize.z;
+    this->blocs = allocateBuffer(size);
+    this->shellBlocs = allocateBuffer(this->getShellSize());
+    this->splitPadded(texture, this->blocs, this->shellBlocs);
     /* the light-mask is only a horizontal slice containing information about wether the sky is seen from this vertical position */
-    this->lightMask = static_cast<uint8_t*>(malloc(sizeof(uint8_t) * paddedSize.x * paddedSize.z));
+    this->lightMask = allocateBuffer(paddedSize.x * paddedSize.z);
     memset(this->lightMask, 15, paddedSize.x * paddedSize.z);
-    /* the light-map is the voxels light values in the chunk */
-    this->lightMap = static_cast<uint8_t*>(malloc(sizeof(uint8_t) * paddedSize.x * paddedSize.y * paddedSize.z));
-    memset(this->lightMap, 0, paddedSize.x * paddedSize.y * paddedSize.z);
+    /* the light values of the chunk and of its ring */
+    this->light = allocateBuffer(size);
+    memset(this->light, 0, size);
+    this->shellLight = allocateBuffer(this->getShellSize());
+    memset(this->shellLight, 0, this->getShellSize());
+}
+
+/* a uniform chunk (only air, or only one solid bloc, margins included) has no voxel buffers nor GPU objects */
+Chunk::Chunk( const glm::vec3& position, const glm::ivec3& chunkSize, uint8_t uniformId, const uint margin ) : position(position), chunkSize(chunkSize), margin(margin), meshed(false), lighted(false), underground(false), outOfRange(false), uniform(true), uniformId(uniformId), uniformLight(0), uniformMask(15), modified(true), approximate(false), lodLevel(0), seamsChanged(false) {
+    this->createModelTransform(position);
+    this->paddedSize = chunkSize + static_cast<int>(margin);
+    this->y_step = paddedSize.x * paddedSize.z;
+    this->sidesWaterUpdate = 0;
+    this->sidesLightUpdate = 0;
+    this->firstLightPass = true;
+    this->mesh_opaque.vao = this->mesh_opaque.vbo = 0;
+    this->mesh_transparent.vao = this->mesh_transparent.vbo = 0;
+    this->connectivity.fill(0x3F);
+    this->occluderLayers = glm::ivec2(0);
+    this->geometryMin = glm::vec3(INFINITY);
+    this->geometryMax = glm::vec3(-INFINITY);
+    this->renderFrame = 0;
+    this->instance = -1;
+    this->computeMeshed = false;
+    this->mesh_opaque.faceVao = this->mesh_transparent.faceVao = 0;
+    this->mesh_opaque.faces = this->mesh_transparent.faces = 0;
+    this->blocs = this->light = this->shellBlocs = this->shellLight = nullptr;
+    this->texture = this->lightMap = nullptr;
+    this->lightMask = nullptr;
+}
+
+/*  serialized chunk: version, state flags, the uniform values, then (if not uniform) the blocs, the light,
+    the ring blocs, the ring light and the light-mask. The blocs hold the water state.
+*/
+enum eSerializedFlags { serializedUniform = 1, serializedLighted = 2, serializedFirstLightPass = 4, serializedUnderground = 8, serializedApproximate = 16 };
+static const uint8_t    serializedVersion = 2;
+static const size_t     serializedHeaderSize = 5;
+
+/* restore a chunk from its serialized data (the data must have been checked with isSerializedValid) */
+Chunk::Chunk( const glm::vec3& position, const glm::ivec3& chunkSize, const std::vector<uint8_t>& data, const uint margin ) : position(position), chunkSize(chunkSize), margin(margin), meshed(false), outOfRange(false), modified(false), lodLevel(0), seamsChanged(false) {
+    this->createModelTransform(position);
+    this->paddedSize = chunkSize + static_cast<int>(margin);
+    this->y_step = paddedSize.x * paddedSize.z;
+    this->sidesWaterUpdate = 0;
+    this->sidesLightUpdate = 0;
+    this->mesh_opaque.vao = this->mesh_opaque.vbo = 0;
+    this->mesh_transparent.vao = this->mesh_transparent.vbo = 0;
+    this->connectivity.fill(0x3F);
+    this->occluderLayers = glm::ivec2(0);
+    this->geometryMin = glm::vec3(INFINITY);
+    this->geometryMax = glm::vec3(-INFINITY);
+    this->renderFrame = 0;
+    this->instance = -1;
+    this->computeMeshed = false;
+    this->mesh_opaque.faceVao = this->mesh_transparent.faceVao = 0;
+    this->mesh_opaque.faces = this->mesh_transparent.faces = 0;
+    const uint8_t flags = data[1];
+    this->uniform = (flags & serializedUniform) != 0;
+    this->lighted = (flags & serializedLighted) != 0;
+    this->firstLightPass = (flags & serializedFirstLightPass) != 0;
+    this->underground = (flags & serializedUnderground) != 0;
+    this->approximate = (flags & serializedApproximate) != 0;
+    this->uniformId = data[2];
+    this->uniformLight = data[3];
+    this->uniformMask = data[4];
+    this->blocs = this->light = this->shellBlocs = this->shellLight = nullptr;
+    this->texture = this->lightMap = nullptr;
+    this->lightMask = nullptr;
+    if (this->uniform == true)
+        return ;
+    const size_t size = chunkSize.x * chunkSize.y * chunkSize.z;
+    const size_t shellSize = this->getShellSize();
+    const uint8_t* p = data.data() + serializedHeaderSize;
+    this->blocs = allocateBuffer(size);
+    this->light = allocateBuffer(size);
+    this->shellBlocs = allocateBuffer(shellSize);
+    this->shellLight = allocateBuffer(shellSize);
+    this->lightMask = allocateBuffer(this->y_step);
+    memcpy(this->blocs, p, size);
+    memcpy(this->light, p + size, size);
+    memcpy(this->shellBlocs, p + size * 2, shellSize);
+    memcpy(this->shellLight, p + size * 2 + shellSize, shellSize);
+    memcpy(this->lightMask, p + (size + shellSize) * 2, this->y_step);
 }
 
 Chunk::~Chunk( void ) {
+    const int size = chunkSize.x * chunkSize.y * chunkSize.z;
     this->mesh_opaque.voxels.clear();
     this->mesh_transparent.voxels.clear();
-    free(this->texture);
-    this->texture = nullptr;
-    free(this->lightMask);
-    this->lightMask = nullptr;
-    free(this->lightMap);
-    this->lightMap = nullptr;
-    glDeleteVertexArrays(1, &this->mesh_opaque.vao);
+    releaseBuffer(this->blocs, size);
+    releaseBuffer(this->light, size);
+    releaseBuffer(this->shellBlocs, this->getShellSize());
+    releaseBuffer(this->shellLight, this->getShellSize());
+    releaseBuffer(this->lightMask, this->y_step);
+    this->blocs = this->light = this->shellBlocs = this->shellLight = this->lightMask = nullptr;
+    GLState::deleteVertexArrays(1, &this->mesh_opaque.vao);
     glDeleteBuffers(1, &this->mesh_opaque.vbo);
-    glDeleteVertexArrays(1, &this->mesh_transparent.vao);
+    GLState::deleteVertexArrays(1, &this->mesh_transparent.vao);
     glDeleteBuffers(1, &this->mesh_transparent.vbo);
+    this->releaseFaces(&this->mesh_opaque);
+    this->releaseFaces(&this->mesh_transparent);
+    if (this->computeMeshed == true) {
+        computeMesher->release(this->instance);
+        computeMeshedCount--;
+    }
+    if (this->instance >= 0)
+        freeInstances.push_back(this->instance);
+}
+
+void    Chunk::serialize( std::vector<uint8_t>& data ) const {
+    const size_t size = chunkSize.x * chunkSize.y * chunkSize.z;
+    const size_t shellSize = this->getShellSize();
+    const uint8_t flags = (this->uniform ? serializedUniform : 0) | (this->lighted ? serializedLighted : 0) |
+                          (this->firstLightPass ? serializedFirstLightPass : 0) | (this->underground ? serializedUnderground : 0) |
+                          (this->approximate ? serializedApproximate : 0);
+    data.assign({ serializedVersion, flags, this->uniformId, this->uniformLight, this->uniformMask });
+    if (this->uniform == true)
+        return ;
+    data.insert(data.end(), this->blocs, this->blocs + size);
+    data.insert(data.end(), this->light, this->light + size);
+    data.insert(data.end(), this->shellBlocs, this->shellBlocs + shellSize);
+    data.insert(data.end(), this->shellLight, this->shellLight + shellSize);
+    data.insert(data.end(), this->lightMask, this->lightMask + this->y_step);
+}
+
+const bool  Chunk::isSerializedValid( const std::vector<uint8_t>& data, const glm::ivec3& chunkSize, const uint margin ) {
+    const glm::ivec3 paddedSize = chunkSize + static_cast<int>(margin);
+    const glm::ivec3 s = chunkSize;
+    const size_t size = s.x * s.y * s.z;
+    const size_t shellSize = (s.x + 2) * (s.y + 2) * (s.z + 2) - size;
+    if (data.size() < serializedHeaderSize || data[0] != serializedVersion)
+        return false;
+    if ((data[1] & serializedUniform) != 0)
+        return (data.size() == serializedHeaderSize);
+    return (data.size() == serializedHeaderSize + (size + shellSize) * 2 + paddedSize.x * paddedSize.z);
+}
+
+/*  The ring is stored in the order of forEachShellVoxel: the bottom layer, then for each layer the back
+    row, the left and right voxels of the inner rows and the front row, then the top layer.
+*/
+const int   Chunk::getShellSize( void ) const {
+    return (chunkSize.x + 2) * (chunkSize.y + 2) * (chunkSize.z + 2) - chunkSize.x * chunkSize.y * chunkSize.z;
+}
+
+/* index of a voxel of the ring (x, y, z in [-1, chunkSize], on the ring) */
+const int   Chunk::getShellIndex( int x, int y, int z ) const {
+    const int w = chunkSize.x + 2;
+    const int layer = w * 2 + chunkSize.z * 2;
+    if (y == -1)
+        return (x+1) + (z+1) * w;
+    if (y == chunkSize.y)
+        return w * (chunkSize.z + 2) + chunkSize.y * layer + (x+1) + (z+1) * w;
+    const int base = w * (chunkSize.z + 2) + y * layer;
+    if (z == -1)
+        return base + (x+1);
+    if (z == chunkSize.z)
+        return base + w + chunkSize.z * 2 + (x+1);
+    return base + w + z * 2 + (x == -1 ? 0 : 1);
+}
+
+template <typename F>
+void    Chunk::forEachShellVoxel( const F& f ) const {
+    int n = 0;
+    for (int y = -1; y < chunkSize.y+1; ++y)
+        for (int z = -1; z < chunkSize.z+1; ++z) {
+            if (y == -1 || z == -1 || y == chunkSize.y || z == chunkSize.z) {
+                for (int x = -1; x < chunkSize.x+1; ++x)
+                    f(x, y, z, n++);
+            }
+            else {
+                f(-1, y, z, n++);
+                f(chunkSize.x, y, z, n++);
+            }
+        }
+}
+
+/* chunk coordinates accessors, the ring comes from the shell and the rest of the margin is border */
+const uint8_t   Chunk::voxelAt( int x, int y, int z ) const {
+    if (this->uniform == true)
+        return this->uniformId;
+    if (x >= 0 && y >= 0 && z >= 0 && x < chunkSize.x && y < chunkSize.y && z < chunkSize.z)
+        return this->blocs[x + z * chunkSize.x + y * chunkSize.x * chunkSize.z];
+    if (x >= -1 && y >= -1 && z >= -1 && x <= chunkSize.x && y <= chunkSize.y && z <= chunkSize.z)
+        return this->shellBlocs[this->getShellIndex(x, y, z)];
+    return 255;
+}
+
+const uint8_t   Chunk::lightAt( int x, int y, int z ) const {
+    if (this->uniform == true)
+        return this->uniformLight;
+    if (x >= 0 && y >= 0 && z >= 0 && x < chunkSize.x && y < chunkSize.y && z < chunkSize.z)
+        return this->light[x + z * chunkSize.x + y * chunkSize.x * chunkSize.z];
+    if (x >= -1 && y >= -1 && z >= -1 && x <= chunkSize.x && y <= chunkSize.y && z <= chunkSize.z)
+        return this->shellLight[this->getShellIndex(x, y, z)];
+    return 0;
+}
+
+const uint8_t   Chunk::getVoxel( int i ) const {
+    const int m = this->margin / 2;
+    return this->voxelAt(i % paddedSize.x - m, i / this->y_step - m, (i / paddedSize.x) % paddedSize.z - m);
+}
+
+const uint8_t   Chunk::getLight( int i ) const {
+    const int m = this->margin / 2;
+    return this->lightAt(i % paddedSize.x - m, i / this->y_step - m, (i / paddedSize.x) % paddedSize.z - m);
+}
+
+/* split a padded volume into the chunk volume and its ring */
+void    Chunk::splitPadded( const uint8_t* padded, uint8_t* volume, uint8_t* shell ) const {
+    const int m = this->margin / 2;
+    for (int y = 0; y < chunkSize.y; ++y)
+        for (int z = 0; z < chunkSize.z; ++z)
+            memcpy(volume + z * chunkSize.x + y * chunkSize.x * chunkSize.z, padded + m + (z+m) * paddedSize.x + (y+m) * this->y_step, chunkSize.x);
+    this->forEachShellVoxel([&]( int x, int y, int z, int n ) {
+        shell[n] = padded[(x+m) + (z+m) * paddedSize.x + (y+m) * this->y_step];
+    });
+}
+
+/*  Build the padded volumes used by the water, light and meshing passes. The ring comes from the shell,
+    then the faces with a loaded neighbour are read from its border, keeping the water the chunk pushed to
+    it and the neighbour did not process yet. The edges and corners of the ring, the faces without
+    neighbour and the ring light stay the shell ones (the light pass pulls the neighbours light itself).
+*/
+void    Chunk::gatherHalo( const std::array<Chunk*, 6>& neighbouringChunks ) {
+    const int m = this->margin / 2;
+    const size_t paddedVolume = paddedSize.x * paddedSize.y * paddedSize.z;
+    if (haloTexture.size() < paddedVolume) {
+        haloTexture.resize(paddedVolume);
+        haloLightMap.resize(paddedVolume);
+    }
+    this->texture = haloTexture.data();
+    this->lightMap = haloLightMap.data();
+    memset(this->texture, 255, paddedVolume);
+    memset(this->lightMap, 0, paddedVolume);
+    for (int y = 0; y < chunkSize.y; ++y)
+        for (int z = 0; z < chunkSize.z; ++z) {
+            const int i = m + (z+m) * paddedSize.x + (y+m) * this->y_step;
+            const int j = z * chunkSize.x + y * chunkSize.x * chunkSize.z;
+            memcpy(this->texture + i, this->blocs + j, chunkSize.x);
+            memcpy(this->lightMap + i, this->light + j, chunkSize.x);
+        }
+    this->forEachShellVoxel([&]( int x, int y, int z, int n ) {
+        const int i = (x+m) + (z+m) * paddedSize.x + (y+m) * this->y_step;
+        this->texture[i] = this->shellBlocs[n];
+        this->lightMap[i] = this->shellLight[n];
+    });
+    /* the faces: a plane of the ring against the opposite border plane of the neighbour, along the axes u and v */
+    const glm::ivec3 paddedSteps = glm::ivec3(1, this->y_step, paddedSize.x);
+    const glm::ivec3 steps = glm::ivec3(1, chunkSize.x * chunkSize.z, chunkSize.x);
+    for (int side = 0; side < 6; ++side) {
+        const Chunk* neighbour = neighbouringChunks[side];
+        if (neighbour == nullptr)
+            continue;
+        const int axis = side / 2;
+        const int u = (axis == 0 ? 2 : 0);
+        const int v = (axis == 1 ? 2 : 1);
+        const int ring = (side % 2 == 0 ? chunkSize[axis] : -1);
+        const int border = (side % 2 == 0 ? 0 : chunkSize[axis] - 1);
+        for (int b = 0; b < chunkSize[v]; ++b) {
+            uint8_t* row = this->texture + (ring+m) * paddedSteps[axis] + (b+m) * paddedSteps[v] + m * paddedSteps[u];
+            const int j = border * steps[axis] + b * steps[v];
+            for (int a = 0; a < chunkSize[u]; ++a) {
+                const uint8_t neighbourBloc = (neighbour->uniform ? neighbour->uniformId : neighbour->blocs[j + a * steps[u]]);
+                uint8_t& bloc = row[a * paddedSteps[u]];
+                bloc = (neighbourBloc == 0 && bloc == 15 ? bloc : neighbourBloc);
+            }
+        }
+    }
+}
+
+/* write the padded volumes back to the chunk and its ring */
+void    Chunk::scatterHalo( void ) {
+    this->splitPadded(this->texture, this->blocs, this->shellBlocs);
+    this->splitPadded(this->lightMap, this->light, this->shellLight);
+    this->releaseHalo();
+}
+
+void    Chunk::releaseHalo( void ) {
+    this->texture = nullptr;
+    this->lightMap = nullptr;
+}
+
+/* uniform chunks share constant light-mask slices instead of owning one */
+static const uint8_t*   getConstantSlice( uint8_t value, size_t size ) {
+    static std::array<std::vector<uint8_t>, 16> slices;
+    if (slices[value].size() < size)
+        slices[value].assign(size, value);
+    return slices[value].data();
+}
+
+const uint8_t*  Chunk::getLightMask( void ) const {
+    if (this->uniform == true)
+        return getConstantSlice(this->uniformMask, this->y_step);
+    return this->lightMask;
+}
+
+/* allocate and fill the buffers of a uniform chunk, called when its content is about to diverge (water, partial light) */
+void    Chunk::materialize( void ) {
+    const int size = chunkSize.x * chunkSize.y * chunkSize.z;
+    this->blocs = allocateBuffer(size);
+    memset(this->blocs, this->uniformId, size);
+    this->shellBlocs = allocateBuffer(this->getShellSize());
+    memset(this->shellBlocs, this->uniformId, this->getShellSize());
+    this->lightMask = allocateBuffer(paddedSize.x * paddedSize.z);
+    memset(this->lightMask, this->uniformMask, paddedSize.x * paddedSize.z);
+    this->light = allocateBuffer(size);
+    memset(this->light, this->uniformLight, size);
+    this->shellLight = allocateBuffer(this->getShellSize());
+    memset(this->shellLight, this->uniformLight, this->getShellSize());
+    this->uniform = false;
+    Chunk::materializedCount++;
+}
+
+/*  iterate over the voxels bordering the chunk (same traversal as the water and light passes) and check the predicate on the matching
+    neighbour, with the position of the voxel in the neighbour
+*/
+template <typename F>
+const bool  Chunk::isNeighbourBorderMatching( const std::array<Chunk*, 6>& neighbouringChunks, int minY, const F& predicate ) const {
+    for (int y = chunkSize.y; y >= minY; --y)
+        for (int z = -1; z < chunkSize.z+1; ++z)
+            for (int x = -1; x < chunkSize.x+1; ++x) {
+                if (!(x == -1 || y == -1 || z == -1 || x == chunkSize.x || y == chunkSize.y || z == chunkSize.z))
+                    continue;
+                int side = 6;
+                if (x == chunkSize.x) side = 0; else if (x == -1) side = 1;
+                if (y == chunkSize.y) side = 2;
+                if (z == chunkSize.z) side = 4; else if (z == -1) side = 5;
+                if (side < 6 && neighbouringChunks[side] != nullptr && predicate(neighbouringChunks[side], glm::ivec3(x, y, z) - chunkSize * sideDirections[side], side))
+                    return true;
+            }
+    return false;
 }
 
 const bool  Chunk::isVoxelTransparent( int i ) const {
@@ -171,20 +534,46 @@ glm::ivec2  Chunk::getVerticesAoValue( int i, uint8_t visibleFaces ) const {
     );
 }
 
-void    Chunk::rebuildMesh( void ) {
+void    Chunk::rebuildMesh( const std::array<Chunk*, 6>& neighbouringChunks ) {
+    const bool wasComputeMeshed = this->computeMeshed;
     if (this->meshed == true) {
         this->mesh_opaque.voxels.clear();
         this->mesh_transparent.voxels.clear();
-        glDeleteVertexArrays(1, &this->mesh_opaque.vao);
+        GLState::deleteVertexArrays(1, &this->mesh_opaque.vao);
         glDeleteBuffers(1, &this->mesh_opaque.vbo);
-        glDeleteVertexArrays(1, &this->mesh_transparent.vao);
+        GLState::deleteVertexArrays(1, &this->mesh_transparent.vao);
         glDeleteBuffers(1, &this->mesh_transparent.vbo);
+        this->releaseFaces(&this->mesh_opaque);
+        this->releaseFaces(&this->mesh_transparent);
+        if (this->computeMeshed == true)
+            computeMeshedCount--;
+        this->computeMeshed = false;
     }
-    this->buildMesh();
+    this->buildMesh(neighbouringChunks);
+    if (wasComputeMeshed == true && this->computeMeshed == false) /* meshed by the other path, the range of its slot is reclaimed */
+        computeMesher->release(this->instance);
 }
 
-void    Chunk::buildMesh( void ) {
+void    Chunk::buildMesh( const std::array<Chunk*, 6>& neighbouringChunks ) {
     const int m = this->margin / 2;
+    this->seamsChanged = false;
+    this->computeConnectivity();
+    this->computeOccluderLayers();
+    if (this->uniform == true) { /* air has no faces, and a solid chunk has all its voxels culled */
+        this->computeGeometryBounds();
+        this->meshed = true;
+        return ;
+    }
+    if (this->lodLevel > 0) { /* distant chunk, meshed from its downsampled voxels */
+        this->buildLodMesh(neighbouringChunks);
+        return ;
+    }
+    if (computeMesher != nullptr && computeMeshing == true) { /* the faces are built on the GPU */
+        this->buildComputeMesh(neighbouringChunks);
+        return ;
+    }
+    this->gatherHalo(neighbouringChunks);
+    this->openSeams(neighbouringChunks, this->texture, this->lightMap, chunkSize, m, paddedSize.x, this->y_step);
     this->mesh_opaque.voxels.reserve(chunkSize.x * chunkSize.y * chunkSize.z);
     this->mesh_transparent.voxels.reserve(chunkSize.x * chunkSize.y * chunkSize.z);
 
@@ -216,11 +605,300 @@ void    Chunk::buildMesh( void ) {
                     this->mesh_transparent.voxels.push_back( (point_t){ glm::vec3(x, y, z), ao, b, visibleFaces, light } );
                 }
             }
+    this->releaseHalo();
+    this->setupMesh(&this->mesh_opaque, GL_STATIC_DRAW);
+    this->setupMesh(&this->mesh_transparent, GL_STATIC_DRAW);
+    /* the meshes were reserved for the worst case */
+    this->mesh_opaque.voxels.shrink_to_fit();
+    this->mesh_transparent.voxels.shrink_to_fit();
+    this->computeGeometryBounds();
+    this->meshed = true;
+}
+
+/*  the padded volumes are meshed by the compute shader into the slot of the chunk instance, the faces and their
+    draw commands stay on the GPU. The faces are not known here, the bounds are the chunk and the water above it.
+*/
+void    Chunk::buildComputeMesh( const std::array<Chunk*, 6>& neighbouringChunks ) {
+    this->gatherHalo(neighbouringChunks);
+    this->openSeams(neighbouringChunks, this->texture, this->lightMap, chunkSize, this->margin / 2, paddedSize.x, this->y_step);
+    this->updateInstance();
+    computeMesher->mesh(this->instance, this->texture, this->lightMap);
+    this->releaseHalo();
+    this->mesh_opaque.faceVbo = this->mesh_opaque.faceTexture = 0;
+    this->setupFaceArray(&this->mesh_opaque);
+    this->geometryMin = this->position - 0.5f;
+    this->geometryMax = this->position + glm::vec3(this->chunkSize) - 0.5f + glm::vec3(0, 1, 0);
+    this->computeMeshed = true;
+    computeMeshedCount++;
+    this->meshed = true;
+}
+
+/*  the voxels are centered on their position and scaled by the lod level, a point p spans [p*s - 0.5, p*s + s - 0.5].
+    The water is raised by one bloc when the camera is underwater.
+*/
+void    Chunk::computeGeometryBounds( void ) {
+    const float s = static_cast<float>(1 << this->lodLevel);
+    glm::vec3 min = glm::vec3(INFINITY);
+    glm::vec3 max = glm::vec3(-INFINITY);
+    for (auto* mesh : { &this->mesh_opaque, &this->mesh_transparent })
+        for (size_t i = 0; i < mesh->voxels.size(); ++i) {
+            min = glm::min(min, mesh->voxels[i].position * s);
+            max = glm::max(max, mesh->voxels[i].position * s);
+        }
+    if (min.x > max.x) {
+        this->geometryMin = min;
+        this->geometryMax = max;
+        return ;
+    }
+    this->geometryMin = this->position + min - 0.5f;
+    this->geometryMax = this->position + max + (s - 0.5f) + glm::vec3(0, this->mesh_transparent.voxels.empty() ? 0.0f : 1.0f, 0);
+}
+
+/*  The longest run of layers without any air or water voxel, as [first, last + 1) in voxels (empty when
+    there is none). These layers are solid through the whole chunk, their box is an occluder for the
+    occlusion buffer.
+*/
+void    Chunk::computeOccluderLayers( void ) {
+    this->occluderLayers = glm::ivec2(0);
+    if (this->uniform == true) {
+        if (this->uniformId != 0 && this->uniformId != 15)
+            this->occluderLayers = glm::ivec2(0, chunkSize.y);
+        return ;
+    }
+    const int layer = chunkSize.x * chunkSize.z;
+    int start = 0;
+    for (int y = 0; y < chunkSize.y; ++y) {
+        const uint8_t* b = this->blocs + y * layer;
+        if (std::any_of(b, b + layer, []( uint8_t id ) { return (id == 0 || id == 15); })) {
+            start = y + 1;
+            continue;
+        }
+        if (y + 1 - start > this->occluderLayers.y - this->occluderLayers.x)
+            this->occluderLayers = glm::ivec2(start, y + 1);
+    }
+}
+
+/* the flood fill buffers, shared by all the chunks */
+static std::vector<uint8_t> fillVisited;
+static std::vector<int>     fillStack;
+
+/*  Flood fill the transparent voxels of the chunk, the sides touched by a same region of air or water
+    can see each other through the chunk. A solid chunk connects nothing, a uniform air chunk everything.
+*/
+void    Chunk::computeConnectivity( void ) {
+    if (this->uniform == true) {
+        this->connectivity.fill(this->uniformId == 0 || this->uniformId == 15 ? 0x3F : 0x0);
+        return ;
+    }
+    const int size = chunkSize.x * chunkSize.y * chunkSize.z;
+    const int z_step = chunkSize.x;
+    const int layer = chunkSize.x * chunkSize.z;
+    auto isTransparent = [this]( int i ) { return (this->blocs[i] == 0 || this->blocs[i] == 15); };
+    fillVisited.assign(size, 0);
+    this->connectivity.fill(0x0);
+    for (int start = 0; start < size; ++start) {
+        if (fillVisited[start] != 0 || !isTransparent(start))
+            continue;
+        uint8_t sides = 0;
+        fillVisited[start] = 1;
+        fillStack.push_back(start);
+        while (fillStack.empty() == false) {
+            const int i = fillStack.back();
+            fillStack.pop_back();
+            const int x = i % chunkSize.x;
+            const int z = (i / z_step) % chunkSize.z;
+            const int y = i / layer;
+            sides |= ((x == chunkSize.x-1) << 0) | ((x == 0) << 1) | ((y == chunkSize.y-1) << 2) | ((y == 0) << 3) | ((z == chunkSize.z-1) << 4) | ((z == 0) << 5);
+            const std::array<int, 6> next = {
+                (x < chunkSize.x-1 ? i + 1 : -1), (x > 0 ? i - 1 : -1),
+                (y < chunkSize.y-1 ? i + layer : -1), (y > 0 ? i - layer : -1),
+                (z < chunkSize.z-1 ? i + z_step : -1), (z > 0 ? i - z_step : -1)
+            };
+            for (int n = 0; n < 6; ++n)
+                if (next[n] != -1 && fillVisited[next[n]] == 0 && isTransparent(next[n])) {
+                    fillVisited[next[n]] = 1;
+                    fillStack.push_back(next[n]);
+                }
+        }
+        for (int side = 0; side < 6; ++side)
+            if (sides & (1 << side))
+                this->connectivity[side] |= sides;
+    }
+}
+
+/* the lod grids of the chunk being meshed, shared by all the chunks */
+static std::vector<uint8_t> lodBlocs;
+static std::vector<uint8_t> lodLight;
+
+/*  bloc and light of a cell of the lod grid (x, y, z in cells, at most one of them outside of the chunk).
+    The cell is solid when solid blocs fill half of it and takes the bloc seen from above, otherwise it is
+    water if it holds more water than air. Its light is the brightest of its transparent voxels. The cells
+    outside of the chunk come from the neighbour, or from the ring when the neighbour is not loaded.
+*/
+void    Chunk::getLodCell( const std::array<Chunk*, 6>& neighbouringChunks, int x, int y, int z, uint8_t& bloc, uint8_t& cellLight ) const {
+    const int s = 1 << this->lodLevel;
+    const glm::ivec3 n = chunkSize / s;
+    glm::ivec3 from = glm::ivec3(x, y, z) * s;
+    glm::ivec3 to = from + s;
+    const Chunk* owner = this;
+    int side = 6;
+    if (x == n.x) side = 0; else if (x == -1) side = 1;
+    if (y == n.y) side = 2; else if (y == -1) side = 3;
+    if (z == n.z) side = 4; else if (z == -1) side = 5;
+    if (side < 6 && neighbouringChunks[side] != nullptr) {
+        owner = neighbouringChunks[side];
+        from = (from + chunkSize) % chunkSize;
+        to = from + s;
+    }
+    else if (side < 6) { /* the ring is only one voxel deep */
+        from = glm::clamp(from, glm::ivec3(-1), chunkSize);
+        to = glm::clamp(to, glm::ivec3(0), chunkSize + 1);
+    }
+    int solid = 0, water = 0, air = 0;
+    uint8_t top = 0;
+    cellLight = 0;
+    for (int vy = to.y-1; vy >= from.y; --vy)
+        for (int vz = from.z; vz < to.z; ++vz)
+            for (int vx = from.x; vx < to.x; ++vx) {
+                const uint8_t v = owner->voxelAt(vx, vy, vz);
+                if (v == 0 || v == 15) {
+                    water += (v == 15);
+                    air += (v == 0);
+                    cellLight = std::max(cellLight, owner->lightAt(vx, vy, vz));
+                }
+                else {
+                    top = (solid == 0 ? v : top);
+                    solid++;
+                }
+            }
+    if (solid * 2 >= solid + water + air)
+        bloc = top;
+    else
+        bloc = (water > air ? 15 : 0);
+}
+
+/*  Mesh the chunk from a grid of cells of (1 << lodLevel) voxels per side, with a one cell margin around it.
+    The points are in cells (the model transform scales them) and have no ambient occlusion.
+*/
+void    Chunk::buildLodMesh( const std::array<Chunk*, 6>& neighbouringChunks ) {
+    const glm::ivec3 n = chunkSize / (1 << this->lodLevel);
+    const glm::ivec3 p = n + 2;
+    const int zStep = p.x;
+    const int yStep = p.x * p.z;
+    lodBlocs.assign(p.x * p.y * p.z, 255);
+    lodLight.assign(p.x * p.y * p.z, 0);
+    for (int y = -1; y <= n.y; ++y)
+        for (int z = -1; z <= n.z; ++z)
+            for (int x = -1; x <= n.x; ++x) {
+                const int outside = (x == -1 || x == n.x) + (y == -1 || y == n.y) + (z == -1 || z == n.z);
+                if (outside <= 1) { /* the edges and corners are not needed */
+                    const int i = (x+1) + (z+1) * zStep + (y+1) * yStep;
+                    this->getLodCell(neighbouringChunks, x, y, z, lodBlocs[i], lodLight[i]);
+                }
+            }
+    this->openSeams(neighbouringChunks, lodBlocs.data(), lodLight.data(), n, 1, zStep, yStep);
+    this->mesh_opaque.voxels.reserve(n.x * n.y * n.z);
+    this->mesh_transparent.voxels.reserve(n.x * n.y * n.z);
+    /* right, left, front, back, top, bottom (same bits as getVisibleFaces) */
+    const std::array<int, 6> offsets = { 1, -1, zStep, -zStep, yStep, -yStep };
+    for (int y = n.y-1; y >= 0; --y)
+        for (int z = 0; z < n.z; ++z)
+            for (int x = 0; x < n.x; ++x) {
+                const int i = (x+1) + (z+1) * zStep + (y+1) * yStep;
+                uint8_t visibleFaces = 0, underwaterFaces = 0, airFaces = 0;
+                int light = 0;
+                for (int f = 0; f < 6; ++f) {
+                    const uint8_t neighbour = lodBlocs[i + offsets[f]];
+                    visibleFaces |= (neighbour == 0 || neighbour == 15) << (5 - f);
+                    underwaterFaces |= (neighbour == 15) << (5 - f);
+                    airFaces |= (neighbour == 0) << (5 - f);
+                    light |= static_cast<int>(lodLight[i + offsets[f]]) << (4 * (5 - f));
+                }
+                if (lodBlocs[i] != 0 && lodBlocs[i] != 15 && visibleFaces != 0) {
+                    uint8_t b = static_cast<uint8_t>(lodBlocs[i] - 1);
+                    /* change dirt to grass on top */
+                    if (lodBlocs[i] == 1 && lodBlocs[i + yStep] == 0 && lodLight[i + yStep] > 1)
+                        b = 1;
+                    this->mesh_opaque.voxels.push_back( (point_t){ glm::vec3(x, y, z), glm::ivec2(0), b, visibleFaces, light | (underwaterFaces << 24) } );
+                }
+                else if (lodBlocs[i] == 15 && airFaces != 0)
+                    this->mesh_transparent.voxels.push_back( (point_t){ glm::vec3(x, y, z), glm::ivec2(0), 14, 0x03, light } );
+            }
     this->setupMesh(&this->mesh_opaque, GL_STATIC_DRAW);
     this->setupMesh(&this->mesh_transparent, GL_STATIC_DRAW);
+    this->mesh_opaque.voxels.shrink_to_fit();
+    this->mesh_transparent.voxels.shrink_to_fit();
+    this->computeGeometryBounds();
     this->meshed = true;
 }
 
+/*  Skirts between chunks meshed at different levels: the two meshes do not sample the surface at the same
+    cells and each one culls its border faces against the voxels of the other, which leaves cracks along the
+    seam. Near the transparent voxels (within a cell of the coarser level), the solid voxels of the side plane
+    of the grid become air, so the border faces are drawn. They take the light of the closest transparent
+    voxel of their line. The grid has n cells per side after offset cells of margin (side planes at -1 and n).
+*/
+void    Chunk::openSeams( const std::array<Chunk*, 6>& neighbouringChunks, uint8_t* grid, uint8_t* gridLight, const glm::ivec3& n, int offset, int zStep, int yStep ) const {
+    const glm::ivec3 steps = glm::ivec3(1, yStep, zStep);
+    std::vector<int> distance(std::max(n.y, n.z));
+    std::vector<uint8_t> nearest(distance.size());
+    for (int side = 0; side < 6; ++side) {
+        if (this->isSeamOpen(neighbouringChunks[side]) == false)
+            continue;
+        const int depth = std::max((2 << std::max(this->lodLevel, neighbouringChunks[side]->lodLevel)) >> this->lodLevel, 1);
+        /* the lines run along y on the vertical sides, along z on the top and bottom ones */
+        const int axis = side / 2;
+        const int vAxis = (axis == 1 ? 2 : 1);
+        const int uAxis = 3 - axis - vAxis;
+        const int plane = (side % 2 == 0 ? n[axis] : -1);
+        const int origin = (plane + offset) * steps[axis] + offset * (steps[uAxis] + steps[vAxis]);
+        for (int u = 0; u < n[uAxis]; ++u) {
+            const int line = origin + u * steps[uAxis];
+            int d = depth + 1;
+            uint8_t l = 0;
+            for (int v = n[vAxis] - 1; v >= 0; --v) { /* the closest transparent voxel above */
+                const int i = line + v * steps[vAxis];
+                d = (grid[i] == 0 || grid[i] == 15 ? 0 : d + 1);
+                l = (d == 0 ? gridLight[i] : l);
+                distance[v] = d;
+                nearest[v] = l;
+            }
+            d = depth + 1;
+            l = 0;
+            for (int v = 0; v < n[vAxis]; ++v) { /* or below */
+                const int i = line + v * steps[vAxis];
+                d = (grid[i] == 0 || grid[i] == 15 ? 0 : d + 1);
+                l = (d == 0 ? gridLight[i] : l);
+                if (d < distance[v]) {
+                    distance[v] = d;
+                    nearest[v] = l;
+                }
+                if (distance[v] > 0 && distance[v] <= depth && grid[i] != 255) {
+                    grid[i] = 0;
+                    gridLight[i] = std::max(gridLight[i], nearest[v]);
+                }
+            }
+        }
+    }
+}
+
+/* the meshes are built at this level by the next buildMesh or rebuildMesh */
+void    Chunk::setLodLevel( int level ) {
+    this->lodLevel = level;
+    this->createModelTransform(this->position);
+}
+
+/* add the memory held by the chunk to the usage */
+void    Chunk::addMemoryUsage( memoryUsage_t& usage ) const {
+    const size_t size = chunkSize.x * chunkSize.y * chunkSize.z + this->getShellSize();
+    usage.voxels += (this->blocs != nullptr ? size : 0);
+    usage.light += (this->light != nullptr ? size : 0) + (this->lightMask != nullptr ? this->y_step : 0);
+    usage.cpuMeshes += (this->mesh_opaque.voxels.capacity() + this->mesh_transparent.voxels.capacity()) * sizeof(point_t);
+    if (this->meshed == true && this->uniform == false)
+        usage.gpuBuffers += (this->mesh_opaque.voxels.size() + this->mesh_transparent.voxels.size()) * sizeof(point_t) + \
+                            (this->mesh_opaque.faces + this->mesh_transparent.faces) * sizeof(face_t);
+}
+
 const bool  Chunk::isBorder( int i ) {
     const int m = this->margin / 2;
     return (i % paddedSize.x < m || /* left border */
@@ -242,10 +920,55 @@ const bool  Chunk::isMaskZero( const uint8_t* mask ) {
     return !b;
 }
 
+const bool  Chunk::isMaskFull( const uint8_t* mask ) {
+    const int m = this->margin / 2;
+    for (int z = -1; z < chunkSize.z+1; ++z)
+        for (int x = -1; x < chunkSize.x+1; ++x)
+            if (mask[(x+m) + (z+m) * paddedSize.x] != 15)
+                return false;
+    return true;
+}
+
 void    Chunk::computeLight( const std::array<Chunk*, 6>& neighbouringChunks, const uint8_t* aboveLightMask ) {
     const int m = this->margin / 2;
     std::queue<int>   lightNodes;
 
+    const std::array<int, 6> offset = { 1, -1, this->y_step, -this->y_step, paddedSize.x, -paddedSize.x };
+    this->modified |= this->firstLightPass;
+    if (this->uniform == true) {
+        this->sidesLightUpdate = 0;
+        if (this->firstLightPass == true) {
+            this->firstLightPass = false;
+            this->lighted = true;
+            if (aboveLightMask != nullptr && isMaskZero(aboveLightMask)) {
+                this->underground = true;
+                this->uniformMask = 0;
+                return ;
+            }
+            if (this->uniformId != 0) { /* a solid chunk stops the light and stays dark */
+                this->uniformMask = 0;
+                return ;
+            }
+            if (aboveLightMask == nullptr || isMaskFull(aboveLightMask)) { /* air under the open sky is fully lit */
+                this->uniformLight = 15;
+                return ;
+            }
+            /* partially shadowed air, the light has to be propagated */
+            this->firstLightPass = true;
+            this->lighted = false;
+            this->materialize();
+        }
+        else {
+            /* only dark air can receive light from its neighbours */
+            if (this->uniformId != 0 || this->uniformLight == 15 || this->isNeighbourBorderMatching(neighbouringChunks, -1, [&]( const Chunk* chunk, const glm::ivec3& p, int side ) {
+                    const glm::ivec3 q = p + sideDirections[side];
+                    return (chunk->lightAt(q.x, q.y, q.z) >= this->uniformLight + 2);
+                }) == false)
+                return ;
+            this->materialize();
+        }
+    }
+
     if (this->firstLightPass == true) { /* only do on first pass */
         if (aboveLightMask != nullptr) {
             memcpy(lightMask, aboveLightMask, this->y_step);
@@ -256,6 +979,9 @@ void    Chunk::computeLight( const std::array<Chunk*, 6>& neighbouringChunks, co
                 return ;
             }
         }
+    }
+    this->gatherHalo(neighbouringChunks);
+    if (this->firstLightPass == true) {
         /* first pass */
         for (int y = chunkSize.y; y >= 0; --y)
             for (int z = -1; z < chunkSize.z+1; ++z)
@@ -283,8 +1009,6 @@ void    Chunk::computeLight( const std::array<Chunk*, 6>& neighbouringChunks, co
                     lightMap[i] = lightMask[j];
                 }
     }
-    const std::array<int, 6> offset = { 1, -1, this->y_step, -this->y_step, paddedSize.x, -paddedSize.x };
-    const std::array<int, 6> offsetInv = { -chunkSize.x, chunkSize.x, -this->y_step * chunkSize.y, this->y_step * chunkSize.y, -paddedSize.x * chunkSize.z, paddedSize.x * chunkSize.z };
     /* create nodes from neighbouring chunks */
     for (int y = chunkSize.y; y >= -1; --y)
         for (int z = -1; z < chunkSize.z+1; ++z)
@@ -297,7 +1021,8 @@ void    Chunk::computeLight( const std::array<Chunk*, 6>& neighbouringChunks, co
                     if (z == chunkSize.z) side = 4; else if (z == -1) side = 5;
 
                     if (neighbouringChunks[side] != nullptr && side != 6) {
-                        int currentLight = (int)neighbouringChunks[side]->getLightMap()[i + offsetInv[side] + offset[side]];
+                        const glm::ivec3 p = glm::ivec3(x, y, z) - chunkSize * sideDirections[side] + sideDirections[side];
+                        int currentLight = (int)neighbouringChunks[side]->lightAt(p.x, p.y, p.z);
                         if (isVoxelTransparent(i) && this->lightMap[i] + 2 <= currentLight) {
                             this->lightMap[i] = currentLight - 1;
                             lightNodes.push(i);
@@ -306,6 +1031,7 @@ void    Chunk::computeLight( const std::array<Chunk*, 6>& neighbouringChunks, co
                 }
             }
     this->sidesLightUpdate = 0;
+    this->modified |= !lightNodes.empty();
     /* propagation pass */
     while (lightNodes.empty() == false) {
         int index = lightNodes.front();
@@ -322,6 +1048,7 @@ void    Chunk::computeLight( const std::array<Chunk*, 6>& neighbouringChunks, co
             }
         }
     }
+    this->scatterHalo();
     this->lighted = true;
     this->firstLightPass = false;
 }
@@ -331,8 +1058,17 @@ void    Chunk::computeWater( const std::array<Chunk*, 6>& neighbouringChunks ) {
     std::queue<int>   waterNodes;
 
     const std::array<int, 6> offset = { 1, -1, this->y_step, -this->y_step, paddedSize.x, -paddedSize.x };
-    const std::array<int, 6> offsetInv = { -chunkSize.x, chunkSize.x, -this->y_step * chunkSize.y, this->y_step * chunkSize.y, -paddedSize.x * chunkSize.z, paddedSize.x * chunkSize.z };
 
+    if (this->uniform == true) {
+        this->sidesWaterUpdate = 0;
+        /* a uniform chunk only changes if it is made of air and water flows in from a neighbour */
+        if (this->uniformId != 0 || this->isNeighbourBorderMatching(neighbouringChunks, 0, [&]( const Chunk* chunk, const glm::ivec3& p, int side ) {
+                return (chunk->voxelAt(p.x, p.y, p.z) == 15);
+            }) == false)
+            return ;
+        this->materialize();
+    }
+    this->gatherHalo(neighbouringChunks);
     /* initial pass to add nodes generated in texture */
     for (int y = chunkSize.y; y >= 0; --y)
         for (int z = -1; z < chunkSize.z+1; ++z)
@@ -346,7 +1082,9 @@ void    Chunk::computeWater( const std::array<Chunk*, 6>& neighbouringChunks ) {
                     if (z == chunkSize.z) side = 4; else if (z == -1) side = 5;
 
                     if (neighbouringChunks[side] != nullptr && side < 6) {
-                        if ((int)neighbouringChunks[side]->getTexture()[i + offsetInv[side]] == 15) {
+                        const glm::ivec3 p = glm::ivec3(x, y, z) - chunkSize * sideDirections[side];
+                        if ((int)neighbouringChunks[side]->voxelAt(p.x, p.y, p.z) == 15) {
+                            this->modified |= (this->texture[i] != 15);
                             this->texture[i] = 15;
                             waterNodes.push(i);
                         }
@@ -369,6 +1107,7 @@ void    Chunk::computeWater( const std::array<Chunk*, 6>& neighbouringChunks ) {
         for (int side = 0; side < 6; side++) {
             if (side != 2 && this->texture[index + offset[side]] == 0) { /* propagate water on air blocks */
                 this->texture[index + offset[side]] = 15;
+                this->modified = true;
                 waterNodes.push(index + offset[side]);
                 /* set sides that were updated (to propagate to neighbours) */
                 if (isBorder(index + offset[side]))
@@ -376,53 +1115,198 @@ void    Chunk::computeWater( const std::array<Chunk*, 6>& neighbouringChunks ) {
             }
         }
     }
+    this->scatterHalo();
 }
 
-void    Chunk::render( Shader shader, Camera& camera, GLuint textureAtlas, uint renderDistance, int underwater ) {
+/* the chunk is in the camera fustrum and in the render distance (flags the chunk out of range when far enough) */
+const bool  Chunk::isInView( Camera& camera, uint renderDistance ) {
     float distHorizontal = glm::distance(this->position * glm::vec3(1,0,1), camera.getPosition() * glm::vec3(1,0,1));
     if (distHorizontal > renderDistance * 3.0f) {
         outOfRange = true;
-        return;
+        return false;
     }
     glm::vec3 size = this->chunkSize;
-    if (camera.aabInFustrum(-(this->position + size / 2), size) && this->texture && distHorizontal - 16 <= renderDistance) {
-        /* set transform matrix */
-        shader.setMat4UniformValue("_mvp", camera.getViewProjectionMatrix() * this->transform);
-        shader.setMat4UniformValue("_model", this->transform);
-        shader.setIntUniformValue("cameraUnderwater", underwater);
-        /* texture atlas */
-        glActiveTexture(GL_TEXTURE0);
-        shader.setIntUniformValue("atlas", 0);
-        glBindTexture(GL_TEXTURE_2D, textureAtlas);
-
-        /* render opaque */
-        if (this->mesh_opaque.voxels.size() > 0) {
-            glBindVertexArray(this->mesh_opaque.vao);
-            glDrawArrays(GL_POINTS, 0, this->mesh_opaque.voxels.size());
-            glBindVertexArray(0);
+    return (camera.aabInFustrum(-(this->position + size / 2), size) && distHorizontal - 16 <= renderDistance);
+}
+
+/*  render the opaque mesh (culled by the terrain, see Terrain::cullChunks), return the number of points drawn
+    (or of faces, with the face renderer). The chunk state comes from its instance and the frame uniform block,
+    so a draw only binds its vertex array. The points are expanded by the geometry shader, or their faces
+    pulled by the face vertex shader.
+*/
+const uint  Chunk::renderOpaque( Camera& camera, bool faces ) {
+    if (this->computeMeshed == true)
+        return this->renderComputeMesh(false, camera.getPosition());
+    if (this->uniform == true || this->mesh_opaque.voxels.size() == 0)
+        return 0;
+    if (faces)
+        return this->renderFaces(&this->mesh_opaque, camera.getPosition());
+    GLState::bindVertexArray(this->mesh_opaque.vao);
+    glDrawArrays(GL_POINTS, 0, this->mesh_opaque.voxels.size());
+    return this->mesh_opaque.voxels.size();
+}
+
+/* render the water mesh (raised by the waterOffset uniform of the pass), return the number of points (or faces) drawn */
+const uint  Chunk::renderTransparent( Camera& camera, bool faces ) {
+    if (this->computeMeshed == true)
+        return this->renderComputeMesh(true, camera.getPosition());
+    if (this->uniform == true || this->mesh_transparent.voxels.size() == 0)
+        return 0;
+    if (faces)
+        return this->renderFaces(&this->mesh_transparent, camera.getPosition());
+    GLState::bindVertexArray(this->mesh_transparent.vao);
+    glDrawArrays(GL_POINTS, 0, this->mesh_transparent.voxels.size());
+    return this->mesh_transparent.voxels.size();
+}
+
+/*  six vertices per face, the faces buffer is bound on the active texture unit (see Terrain::renderChunks).
+    Only the directions facing the camera are drawn, the consecutive ones in a single draw.
+*/
+const uint  Chunk::renderFaces( mesh_t* mesh, const glm::vec3& eye ) {
+    if (mesh->faceVao == 0)
+        this->setupFaces(mesh);
+    const uint8_t directions = this->getFacingDirections(eye);
+    GLState::bindVertexArray(mesh->faceVao);
+    GLState::bindTexture(GL_TEXTURE_BUFFER, mesh->faceTexture);
+    uint drawn = 0;
+    for (int f = 0; f < 6; ++f) {
+        if ((directions & (1 << f)) == 0)
+            continue;
+        const int first = f;
+        while (f + 1 < 6 && (directions & (1 << (f + 1))) != 0)
+            ++f;
+        const GLsizei count = mesh->faceFirst[f + 1] - mesh->faceFirst[first];
+        if (count > 0)
+            glDrawArrays(GL_TRIANGLES, mesh->faceFirst[first] * 6, count * 6);
+        drawn += count;
+    }
+    return drawn;
+}
+
+/*  the buckets of a compute mesh are drawn by the compute mesher from their commands, through the vertex array of
+    the opaque mesh (the instance attribute). The faces submitted are only known to the GPU, return 0.
+*/
+const uint  Chunk::renderComputeMesh( bool transparent, const glm::vec3& eye ) {
+    GLState::bindVertexArray(this->mesh_opaque.faceVao);
+    computeMesher->draw(this->instance, transparent, this->getFacingDirections(eye));
+    return 0;
+}
+
+/*  the directions (+x, -x, +y, -y, +z, -z bits) whose faces can be turned to the camera: the faces of +x are
+    all turned away when the camera is below the minimum of the geometry bounds. The shader picks the face of
+    an axis from the cell, so the bounds are widened by a cell.
+*/
+const uint8_t   Chunk::getFacingDirections( const glm::vec3& eye ) const {
+    const float s = static_cast<float>(1 << this->lodLevel);
+    uint8_t directions = 0;
+    for (int a = 0; a < 3; ++a) {
+        directions |= (eye[a] > this->geometryMin[a] - s) << (a * 2);
+        directions |= (eye[a] < this->geometryMax[a] + s) << (a * 2 + 1);
+    }
+    return directions;
+}
+
+/* per face (+x, -x, +y, -y, +z, -z): its bit in the visible faces, its light and underwater bits, its ao byte */
+static const uint8_t    faceBits[6] = { 0x20, 0x10, 0x02, 0x01, 0x08, 0x04 };
+static const int        faceLightShifts[6] = { 20, 16, 4, 0, 12, 8 };
+static const int        faceUnderwaterBits[6] = { 29, 28, 25, 24, 27, 26 };
+static const int        faceAoWords[6] = { 0, 0, 1, 1, 0, 0 };
+static const int        faceAoShifts[6] = { 24, 16, 8, 0, 8, 0 };
+
+/*  the faces of the points, in a buffer read through a buffer texture (the vertex arrays only hold the chunk
+    instance attribute). Both faces of an axis are kept, the shader draws the one facing the camera. The faces
+    are grouped by direction, so the directions turned away from the camera are skipped (see renderFaces).
+*/
+void    Chunk::setupFaces( mesh_t* mesh ) {
+    std::array<std::vector<face_t>, 6> directions;
+    for (size_t i = 0; i < mesh->voxels.size(); ++i) {
+        const point_t& p = mesh->voxels[i];
+        const uint32_t position = static_cast<uint32_t>(p.position.x) | (static_cast<uint32_t>(p.position.y) << 8) | (static_cast<uint32_t>(p.position.z) << 16);
+        const int flippedQuads = (p.ao.y >> 16) & 0xFF;
+        for (int f = 0; f < 6; ++f) {
+            if ((p.visibleFaces & faceBits[f]) == 0)
+                continue;
+            const uint32_t ao = (static_cast<uint32_t>(p.ao[faceAoWords[f]]) >> faceAoShifts[f]) & 0xFF;
+            const uint32_t light = (static_cast<uint32_t>(p.light) >> faceLightShifts[f]) & 0xF;
+            directions[f].push_back((face_t){
+                position | (f << 24) | (((flippedQuads & faceBits[f]) != 0) << 27) | (((p.light >> faceUnderwaterBits[f]) & 0x1) << 28),
+                p.id | (ao << 8) | (light << 16)
+            });
         }
-        /* render transparent */
-        if (this->mesh_transparent.voxels.size() > 0) {
-            /* perform small offset of mesh to have waterline a bit lower */
-            glm::mat4 newTransform = this->transform;
-            newTransform = glm::translate(newTransform, glm::vec3(0, underwater, 0)); /* HACK: back faces are off by 1 unit down, so if we're underwater, we raise water voxels by one so that water line is at "correct" height */
-            shader.setMat4UniformValue("_mvp", camera.getViewProjectionMatrix() * newTransform);
-            shader.setMat4UniformValue("_model", newTransform);
-
-            glBindVertexArray(this->mesh_transparent.vao);
-            glDrawArrays(GL_POINTS, 0, this->mesh_transparent.voxels.size());
-            glBindVertexArray(0);
+    }
+    mesh->faceFirst[0] = 0;
+    for (int f = 0; f < 6; ++f)
+        mesh->faceFirst[f + 1] = mesh->faceFirst[f] + directions[f].size();
+    mesh->faces = mesh->faceFirst[6];
+    glGenBuffers(1, &mesh->faceVbo);
+    /* the directions are written one after the other into the upload ring (or its staging buffer) */
+    uint8_t* faces = uploadRing->map(mesh->faces * sizeof(face_t));
+    for (int f = 0; f < 6; ++f)
+        std::memcpy(faces + mesh->faceFirst[f] * sizeof(face_t), directions[f].data(), directions[f].size() * sizeof(face_t));
+    uploadRing->store(mesh->faceVbo, GL_STATIC_DRAW);
+    glGenTextures(1, &mesh->faceTexture);
+    GLState::bindTexture(GL_TEXTURE_BUFFER, mesh->faceTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32UI, mesh->faceVbo);
+    this->setupFaceArray(mesh);
+}
+
+/* the vertex array of the faces, only the chunk attribute (as the points vertex arrays) */
+void    Chunk::setupFaceArray( mesh_t* mesh ) {
+    glGenVertexArrays(1, &mesh->faceVao);
+    GLState::bindVertexArray(mesh->faceVao);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    glEnableVertexAttribArray(5);
+    glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), reinterpret_cast<GLvoid*>(this->instance * sizeof(glm::vec4)));
+    glVertexAttribDivisor(5, 1);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void    Chunk::releaseFaces( mesh_t* mesh ) {
+    if (mesh->faceVao == 0)
+        return;
+    GLState::deleteVertexArrays(1, &mesh->faceVao);
+    GLState::deleteTextures(1, &mesh->faceTexture);
+    glDeleteBuffers(1, &mesh->faceVbo);
+    mesh->faceVao = 0;
+    mesh->faces = 0;
+}
+
+/*  write the offset and scale of the chunk cells in its slot of the instance buffer. The buffer is grown
+    under the same name, so the vertex arrays pointing to it stay valid.
+*/
+void    Chunk::updateInstance( void ) {
+    if (this->instance < 0) {
+        if (freeInstances.empty() == false) {
+            this->instance = freeInstances.back();
+            freeInstances.pop_back();
+        }
+        else {
+            this->instance = instances.size();
+            instances.push_back(glm::vec4(0));
         }
     }
+    instances[this->instance] = glm::vec4(glm::vec3(this->transform[3]), this->transform[0][0]);
+    if (instanceBuffer == 0)
+        glGenBuffers(1, &instanceBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    if (instances.size() > instanceCapacity) {
+        instanceCapacity = std::max(static_cast<size_t>(1024), instances.size() * 2);
+        glBufferData(GL_ARRAY_BUFFER, instanceCapacity * sizeof(glm::vec4), nullptr, GL_DYNAMIC_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, instances.size() * sizeof(glm::vec4), instances.data());
+    }
+    else
+        glBufferSubData(GL_ARRAY_BUFFER, this->instance * sizeof(glm::vec4), sizeof(glm::vec4), &instances[this->instance]);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
 void    Chunk::setupMesh( mesh_t* mesh, int mode ) {
+    this->updateInstance();
     /* new for transparent */
     glGenVertexArrays(1, &mesh->vao);
     glGenBuffers(1, &mesh->vbo);
-	glBindVertexArray(mesh->vao);
+	GLState::bindVertexArray(mesh->vao);
 	glBindBuffer(GL_ARRAY_BUFFER, mesh->vbo);
-	glBufferData(GL_ARRAY_BUFFER, mesh->voxels.size() * sizeof(point_t), mesh->voxels.data(), mode);
+    uploadRing->store(mesh->vbo, mesh->voxels.data(), mesh->voxels.size() * sizeof(point_t), mode);
     /* position attribute */
 	glEnableVertexAttribArray(0);
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(point_t), static_cast<GLvoid*>(0));
@@ -438,12 +1322,20 @@ void    Chunk::setupMesh( mesh_t* mesh, int mode ) {
     /* light attribute */
     glEnableVertexAttribArray(4);
 	glVertexAttribIPointer(4, 1, GL_INT, sizeof(point_t), reinterpret_cast<GLvoid*>(offsetof(point_t, light)));
+    /* chunk attribute, the slot of the chunk read by every point (the non-instanced draws read the instance 0) */
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    glEnableVertexAttribArray(5);
+    glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), reinterpret_cast<GLvoid*>(this->instance * sizeof(glm::vec4)));
+    glVertexAttribDivisor(5, 1);
 
     glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    GLState::bindVertexArray(0);
 }
 
 void    Chunk::createModelTransform( const glm::vec3& position ) {
+    const float s = static_cast<float>(1 << this->lodLevel);
     this->transform = glm::mat4();
-    this->transform = glm::translate(this->transform, position);
+    /* a lod point is a cell of s voxels per side, centered on them */
+    this->transform = glm::translate(this->transform, position + (s - 1.0f) / 2.0f);
+    this->transform = glm::scale(this->transform, glm::vec3(s));
 }
\ No newline at end of file
@@ -0,0 +1,71 @@
+#include "ChunkCache.hpp"
+
+static uint64_t getKey( const glm::vec3& p ) {
+    glm::ivec3 c = glm::ivec3(p);
+    return static_cast<uint64_t>(c.x + 0x1FFFFF) | (static_cast<uint64_t>(c.y + 0x1FFFFF) << 21) | (static_cast<uint64_t>(c.z + 0x1FFFFF) << 42);
+}
+
+ChunkCache::ChunkCache( RegionStore* regionStore, size_t maxBytes, size_t maxEntries ) : regionStore(regionStore), bytes(0), maxBytes(maxBytes), maxEntries(maxEntries) {
+    this->stats = (cacheStats_t){ 0, 0, 0, 0, 0 };
+}
+
+/* the modified chunks still in the cache are saved */
+ChunkCache::~ChunkCache( void ) {
+    while (this->entries.empty() == false)
+        this->drop(std::prev(this->entries.end()));
+}
+
+void    ChunkCache::insert( const glm::vec3& chunkPosition, const std::vector<uint8_t>& data, bool modified ) {
+    uint64_t key = getKey(chunkPosition);
+    auto it = this->index.find(key);
+    if (it != this->index.end()) { /* replace the previous entry */
+        this->bytes -= it->second->payload.size();
+        this->entries.erase(it->second);
+        this->index.erase(it);
+    }
+    this->entries.push_front((cacheEntry_t){ chunkPosition, {}, modified });
+    RegionStore::pack(data, this->entries.front().payload);
+    this->entries.front().payload.shrink_to_fit();
+    this->bytes += this->entries.front().payload.size();
+    this->index[key] = this->entries.begin();
+    this->stats.inserted++;
+    this->shrink();
+}
+
+/* remove the chunk from the cache and return its serialized data, false if it is not in the cache */
+const bool  ChunkCache::take( const glm::vec3& chunkPosition, std::vector<uint8_t>& data, bool& modified ) {
+    auto it = this->index.find(getKey(chunkPosition));
+    if (it == this->index.end() || RegionStore::unpack(it->second->payload.data(), it->second->payload.size(), data) == false) {
+        this->stats.misses++;
+        return false;
+    }
+    modified = it->second->modified;
+    this->bytes -= it->second->payload.size();
+    this->entries.erase(it->second);
+    this->index.erase(it);
+    this->stats.hits++;
+    return true;
+}
+
+void    ChunkCache::setLimits( size_t maxBytes, size_t maxEntries ) {
+    this->maxBytes = maxBytes;
+    this->maxEntries = maxEntries;
+    this->shrink();
+}
+
+/* remove an entry, written to the region files if it was modified */
+void    ChunkCache::drop( std::list<cacheEntry_t>::iterator it ) {
+    if (it->modified && this->regionStore != nullptr)
+        this->stats.written += this->regionStore->savePayload(it->position, it->payload);
+    this->bytes -= it->payload.size();
+    this->index.erase(getKey(it->position));
+    this->entries.erase(it);
+}
+
+/* drop the least recently evicted chunks until the cache is under its limits */
+void    ChunkCache::shrink( void ) {
+    while (this->entries.empty() == false && (this->bytes > this->maxBytes || this->entries.size() > this->maxEntries)) {
+        this->drop(std::prev(this->entries.end()));
+        this->stats.dropped++;
+    }
+}
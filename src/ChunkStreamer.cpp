@@ -0,0 +1,104 @@
+#include "ChunkStreamer.hpp"
+
+ChunkStreamer::ChunkStreamer( GLFWwindow* window, const glm::ivec3& chunkSize, uint margin, int seed, const std::unordered_map<std::string, std::string>& pragmas ) :
+chunkSize(chunkSize), margin(margin), seed(seed), pragmas(pragmas), requests(queueSize), results(queueSize), running(false) {
+    this->requested = this->received = 0;
+    this->batches = this->batchUs = this->waitUs = 0;
+    /* the window hints of the rendering context are still set, only its visibility changes */
+    glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+    this->context = glfwCreateWindow(1, 1, "ft_vox streaming", NULL, window);
+    glfwWindowHint(GLFW_VISIBLE, GL_TRUE);
+    if (this->context == nullptr) {
+        std::cerr << "chunk streamer: no shared context, the chunks are generated on the render thread" << std::endl;
+        return;
+    }
+    this->running = true;
+    this->thread = std::thread(&ChunkStreamer::run, this);
+}
+
+ChunkStreamer::~ChunkStreamer( void ) {
+    this->running = false;
+    if (this->thread.joinable())
+        this->thread.join();
+    if (this->context != nullptr)
+        glfwDestroyWindow(this->context);
+}
+
+const bool  ChunkStreamer::request( const glm::vec3& key, const std::vector<float>& columnFields ) {
+    if (this->requests.push((streamRequest_t){ key, columnFields }) == false)
+        return false;
+    this->requested++;
+    return true;
+}
+
+const bool  ChunkStreamer::receive( streamResult_t& result ) {
+    if (this->results.pop(result) == false)
+        return false;
+    this->received++;
+    return true;
+}
+
+const streamerStats_t   ChunkStreamer::getStats( void ) const {
+    return (streamerStats_t){ this->requested, this->received, this->batches.load(), ComputeGenerator::isSupported(), this->batchUs.load() / 1000.0, this->waitUs.load() / 1000.0 };
+}
+
+/* the streaming thread: its GL objects are created and deleted with its context current */
+void    ChunkStreamer::run( void ) {
+    glfwMakeContextCurrent(this->context);
+    try {
+        if (ComputeGenerator::isSupported())
+            this->loop<ComputeGenerator>();
+        else
+            this->loop<FragmentGenerator>();
+    }
+    catch (std::exception& e) {
+        std::cerr << "chunk streamer: " << e.what() << std::endl;
+        this->running = false;
+    }
+    glfwMakeContextCurrent(NULL);
+}
+
+/* the generators have the same interface (see FragmentGenerator) */
+template <typename T>
+void    ChunkStreamer::loop( void ) {
+    T                       generator(this->chunkSize, this->margin, this->pragmas);
+    std::vector<glm::vec3>  batch;
+    streamRequest_t         request;
+    while (this->running.load()) {
+        while (generator.isFull() == false && this->requests.pop(request)) {
+            generator.add(request.key * glm::vec3(this->chunkSize), request.columnFields);
+            batch.push_back(request.key);
+        }
+        if (batch.empty()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        this->generate(generator, batch);
+        batch.clear();
+    }
+}
+
+/* dispatch the batch and wait for its fence here, the read back is then a plain copy */
+template <typename T>
+void    ChunkStreamer::generate( T& generator, const std::vector<glm::vec3>& batch ) {
+    tTimePoint start = std::chrono::high_resolution_clock::now();
+    generator.submit(this->seed);
+    GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush();
+    tTimePoint waitStart = std::chrono::high_resolution_clock::now();
+    while (glClientWaitSync(fence, 0, 1000000) == GL_TIMEOUT_EXPIRED && this->running.load())
+        ;
+    glDeleteSync(fence);
+    this->waitUs += static_cast<uint64_t>((static_cast<tMilliseconds>(std::chrono::high_resolution_clock::now() - waitStart)).count() * 1000.0);
+    generator.read();
+    for (size_t i = 0; i < batch.size(); ++i) {
+        const uint8_t* voxels = generator.getVoxels(i);
+        streamResult_t result = { batch[i], std::vector<uint8_t>(voxels, voxels + generator.getSlotSize()) };
+        /* the render thread takes the results every frame */
+        while (this->results.push(std::move(result)) == false && this->running.load())
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    generator.clear();
+    this->batches++;
+    this->batchUs += static_cast<uint64_t>((static_cast<tMilliseconds>(std::chrono::high_resolution_clock::now() - start)).count() * 1000.0);
+}
@@ -0,0 +1,135 @@
+#include "ColumnTree.hpp"
+
+ColumnTree::ColumnTree( const glm::ivec3& chunkSize, int height, int levels ) : chunkSize(chunkSize), height(height), levels(levels) {
+    this->stats = (columnTreeStats_t){ 0, 0, 0, 0 };
+}
+
+ColumnTree::~ColumnTree( void ) {
+}
+
+void    ColumnTree::setChunk( const glm::vec3& chunkPosition, Chunk* chunk ) {
+    const columnNodeKey_t key = { static_cast<int>(chunkPosition.x), static_cast<int>(chunkPosition.z), 0 };
+    const int y = static_cast<int>(chunkPosition.y);
+    auto it = this->nodes.find(key);
+    if (chunk == nullptr) {
+        if (it != this->nodes.end() && y >= 0 && y < this->height)
+            it->second.chunks[y] = nullptr;
+        this->dirty.insert(key);
+        return ;
+    }
+    if (y < 0 || y >= this->height)
+        return;
+    /* the column and its ancestors, their bounds are computed by the next refresh */
+    for (int level = 0; level <= this->levels; ++level) {
+        const columnNodeKey_t ancestor = { key.x >> level, key.z >> level, level };
+        if (this->nodes.find(ancestor) == this->nodes.end()) {
+            this->nodes[ancestor] = (columnNode_t){ glm::vec3(INFINITY), glm::vec3(-INFINITY), std::vector<Chunk*>() };
+            if (level == this->levels)
+                this->roots.insert(ancestor);
+        }
+    }
+    columnNode_t& column = this->nodes.at(key);
+    if (column.chunks.empty())
+        column.chunks.assign(this->height, nullptr);
+    column.chunks[y] = chunk;
+    this->dirty.insert(key);
+}
+
+void    ColumnTree::markChunk( const glm::vec3& chunkPosition ) {
+    this->dirty.insert({ static_cast<int>(chunkPosition.x), static_cast<int>(chunkPosition.z), 0 });
+}
+
+/* compute the bounds of the marked columns, then of their parents, up to the roots */
+void    ColumnTree::refresh( void ) {
+    std::unordered_set<columnNodeKey_t, ColumnNodeKeyHash> current;
+    current.swap(this->dirty);
+    for (int level = 0; level <= this->levels && current.empty() == false; ++level) {
+        std::unordered_set<columnNodeKey_t, ColumnNodeKeyHash> parents;
+        for (auto it = current.begin(); it != current.end(); ++it) {
+            this->computeBounds(*it);
+            if (level < this->levels)
+                parents.insert({ it->x >> 1, it->z >> 1, level + 1 });
+        }
+        current.swap(parents);
+    }
+}
+
+/* the union of the bounds of the chunks (or children), the nodes left without any are removed */
+void    ColumnTree::computeBounds( const columnNodeKey_t& key ) {
+    auto it = this->nodes.find(key);
+    if (it == this->nodes.end())
+        return;
+    glm::vec3 min = glm::vec3(INFINITY);
+    glm::vec3 max = glm::vec3(-INFINITY);
+    bool used = false;
+    if (key.level == 0) {
+        for (size_t y = 0; y < it->second.chunks.size(); ++y)
+            if (it->second.chunks[y] != nullptr) {
+                min = glm::min(min, it->second.chunks[y]->getGeometryMin());
+                max = glm::max(max, it->second.chunks[y]->getGeometryMax());
+                used = true;
+            }
+    }
+    else {
+        for (int c = 0; c < 4; ++c) {
+            auto child = this->nodes.find({ key.x * 2 + (c & 1), key.z * 2 + (c >> 1), key.level - 1 });
+            if (child != this->nodes.end()) {
+                min = glm::min(min, child->second.min);
+                max = glm::max(max, child->second.max);
+                used = true;
+            }
+        }
+    }
+    this->stats.refreshed++;
+    if (used == false) {
+        this->nodes.erase(it);
+        this->roots.erase(key);
+        return ;
+    }
+    it->second.min = min;
+    it->second.max = max;
+}
+
+void    ColumnTree::cull( Camera& camera, float renderDistance, std::vector<Chunk*>& visible ) {
+    this->refresh();
+    this->stats.frames++;
+    for (auto it = this->roots.begin(); it != this->roots.end(); ++it)
+        this->visit(*it, camera, renderDistance, visible);
+}
+
+/*  a chunk is in range when its corner is within the render distance (plus 16 blocs, as Chunk::isInView).
+    A node is skipped when its geometry is farther than that by more than a chunk diagonal.
+*/
+void    ColumnTree::visit( const columnNodeKey_t& key, Camera& camera, float renderDistance, std::vector<Chunk*>& visible ) {
+    auto it = this->nodes.find(key);
+    if (it == this->nodes.end() || it->second.min.x > it->second.max.x)
+        return;
+    const columnNode_t& node = it->second;
+    const glm::vec2 camera2d = glm::vec2(camera.getPosition().x, camera.getPosition().z);
+    this->stats.nodes++;
+    if (this->isInRange(node.min, node.max, camera2d, renderDistance + 16.0f + this->chunkSize.x * std::sqrt(2.0f)) == false)
+        return;
+    if (camera.aabInFustrum(-(node.min + node.max) * 0.5f, node.max - node.min) == false)
+        return;
+    if (key.level > 0) {
+        for (int c = 0; c < 4; ++c)
+            this->visit({ key.x * 2 + (c & 1), key.z * 2 + (c >> 1), key.level - 1 }, camera, renderDistance, visible);
+        return ;
+    }
+    for (size_t y = 0; y < node.chunks.size(); ++y) {
+        Chunk* chunk = node.chunks[y];
+        if (chunk == nullptr || chunk->getGeometryMin().x > chunk->getGeometryMax().x)
+            continue;
+        this->stats.chunks++;
+        const glm::vec2 corner = glm::vec2(chunk->getPosition().x, chunk->getPosition().z);
+        if (glm::distance(corner, camera2d) - 16 > renderDistance)
+            continue;
+        if (camera.aabInFustrum(-(chunk->getGeometryMin() + chunk->getGeometryMax()) * 0.5f, chunk->getGeometryMax() - chunk->getGeometryMin()))
+            visible.push_back(chunk);
+    }
+}
+
+const bool  ColumnTree::isInRange( const glm::vec3& min, const glm::vec3& max, const glm::vec2& camera, float distance ) const {
+    const glm::vec2 closest = glm::clamp(camera, glm::vec2(min.x, min.z), glm::vec2(max.x, max.z));
+    return (glm::distance(closest, camera) <= distance);
+}
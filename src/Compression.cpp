@@ -0,0 +1,91 @@
+#include "Compression.hpp"
+#include <algorithm>
+
+static const size_t minMatch = 4;
+static const size_t maxMatch = 0x7F + minMatch;
+static const size_t maxLiterals = 0x80;
+static const size_t maxOffset = 0xFFFF;
+static const int    hashBits = 12;
+
+static inline uint32_t  hashSequence( const uint8_t* p ) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return (v * 2654435761u) >> (32 - hashBits);
+}
+
+static void flushLiterals( const uint8_t* src, size_t start, size_t end, std::vector<uint8_t>& dst ) {
+    while (start < end) {
+        size_t n = std::min(end - start, maxLiterals);
+        dst.push_back(static_cast<uint8_t>(n - 1));
+        dst.insert(dst.end(), src + start, src + start + n);
+        start += n;
+    }
+}
+
+void    compress( const uint8_t* src, size_t size, std::vector<uint8_t>& dst ) {
+    std::vector<int64_t> table(1 << hashBits, -1); /* last position of a 4 bytes sequence */
+    size_t literals = 0;
+    size_t i = 0;
+    dst.clear();
+    dst.reserve(size / 4);
+    while (i + minMatch <= size) {
+        size_t length = 0, offset = 0;
+        /* runs of the previous byte are the most common match */
+        if (i > 0 && src[i] == src[i-1]) {
+            while (i + length < size && length < maxMatch && src[i + length] == src[i - 1])
+                length++;
+            offset = 1;
+        }
+        uint32_t h = hashSequence(src + i);
+        int64_t candidate = table[h];
+        table[h] = static_cast<int64_t>(i);
+        if (candidate >= 0 && i - candidate <= maxOffset && i - candidate > 1) {
+            size_t n = 0;
+            while (i + n < size && n < maxMatch && src[candidate + n] == src[i + n])
+                n++;
+            if (n > length) {
+                length = n;
+                offset = i - candidate;
+            }
+        }
+        if (length < minMatch) {
+            i++;
+            continue;
+        }
+        flushLiterals(src, literals, i, dst);
+        dst.push_back(static_cast<uint8_t>(0x80 | (length - minMatch)));
+        dst.push_back(static_cast<uint8_t>(offset & 0xFF));
+        dst.push_back(static_cast<uint8_t>(offset >> 8));
+        i += length;
+        literals = i;
+    }
+    flushLiterals(src, literals, size, dst);
+}
+
+/* return false if the stream is corrupted or does not decompress to exactly dstSize bytes */
+const bool  decompress( const uint8_t* src, size_t size, uint8_t* dst, size_t dstSize ) {
+    size_t i = 0, o = 0;
+    while (i < size) {
+        uint8_t token = src[i++];
+        if ((token & 0x80) == 0) {
+            size_t n = token + 1;
+            if (i + n > size || o + n > dstSize)
+                return false;
+            memcpy(dst + o, src + i, n);
+            i += n;
+            o += n;
+        }
+        else {
+            size_t n = (token & 0x7F) + minMatch;
+            if (i + 2 > size)
+                return false;
+            size_t offset = src[i] | (src[i+1] << 8);
+            i += 2;
+            if (offset == 0 || offset > o || o + n > dstSize)
+                return false;
+            for (size_t k = 0; k < n; ++k, ++o) /* overlapping copy */
+                dst[o] = dst[o - offset];
+        }
+    }
+    return (o == dstSize);
+}
@@ -0,0 +1,85 @@
+#include "ComputeGenerator.hpp"
+
+ComputeGenerator::ComputeGenerator( const glm::ivec3& chunkSize, uint margin, const std::unordered_map<std::string, std::string>& pragmas ) : margin(margin) {
+    this->paddedSize = chunkSize + static_cast<int>(margin);
+    this->slotSize = this->paddedSize.x * this->paddedSize.y * this->paddedSize.z;
+    this->stats = (computeGeneratorStats_t){ 0, 0 };
+    this->shader = new Shader("./shader/compute/generateChunk.comp.glsl", pragmas);
+    this->voxels.resize(this->slotSize * capacity);
+    this->positions.reserve(capacity);
+    glGenBuffers(1, &this->buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, this->buffer);
+    glBufferData(GL_ARRAY_BUFFER, this->slotSize * capacity, nullptr, GL_DYNAMIC_READ);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glGenTextures(1, &this->columns);
+    GLState::bindTexture(GL_TEXTURE_2D_ARRAY, this->columns);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA32F, this->paddedSize.x, this->paddedSize.z, capacity, 0, GL_RGBA, GL_FLOAT, NULL);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    GLState::bindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+ComputeGenerator::~ComputeGenerator( void ) {
+    glDeleteBuffers(1, &this->buffer);
+    GLState::deleteTextures(1, &this->columns);
+    delete this->shader;
+}
+
+const bool  ComputeGenerator::isSupported( void ) {
+#ifdef GL_VERSION_4_3
+    return (GLAD_GL_VERSION_4_3 != 0);
+#else
+    return false;
+#endif
+}
+
+const int   ComputeGenerator::add( const glm::vec3& position, const std::vector<float>& columnFields ) {
+    const int slot = this->positions.size();
+    this->positions.push_back(position);
+    GLState::bindTexture(GL_TEXTURE_2D_ARRAY, this->columns);
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, slot, this->paddedSize.x, this->paddedSize.z, 1, GL_RGBA, GL_FLOAT, columnFields.data());
+    GLState::bindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    return slot;
+}
+
+void    ComputeGenerator::dispatch( int seed ) {
+    this->submit(seed);
+    this->read();
+}
+
+void    ComputeGenerator::submit( int seed ) {
+    if (this->positions.empty())
+        return;
+#ifdef GL_VERSION_4_3
+    const GLint chunks = this->positions.size();
+    this->shader->use();
+    this->shader->setIvec3UniformValue("paddedSize", this->paddedSize);
+    this->shader->setIntUniformValue("margin", this->margin);
+    this->shader->setIntUniformValue("seed", seed);
+    this->shader->setIntUniformValue("coarseLattice", 0);
+    this->shader->setIntUniformValue("useColumn", 1);
+    this->shader->setIntUniformValue("chunks", chunks);
+    glUniform3fv(this->shader->getUniformLocation("chunkPositions"), chunks, &this->positions[0][0]);
+    GLState::activeTexture(GL_TEXTURE3);
+    this->shader->setIntUniformValue("columnsSampler", 3);
+    GLState::bindTexture(GL_TEXTURE_2D_ARRAY, this->columns);
+    GLState::activeTexture(GL_TEXTURE0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, this->buffer);
+    /* a word of 4 voxels per invocation, the chunks are stacked along z */
+    glDispatchCompute((this->paddedSize.x / 4 + 3) / 4, (this->paddedSize.y + 3) / 4, (this->paddedSize.z * chunks + 3) / 4);
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+#endif
+}
+
+void    ComputeGenerator::read( void ) {
+    if (this->positions.empty())
+        return;
+#ifdef GL_VERSION_4_3
+    const GLint chunks = this->positions.size();
+    glBindBuffer(GL_ARRAY_BUFFER, this->buffer);
+    glGetBufferSubData(GL_ARRAY_BUFFER, 0, this->slotSize * chunks, this->voxels.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    this->stats.batches++;
+    this->stats.chunks += chunks;
+#endif
+}
@@ -0,0 +1,290 @@
+#include "ComputeMesher.hpp"
+
+/* the words of the state buffer: the arena top, failures count and failure flag, the counts, firsts and cursors of the buckets, then the failed slots */
+static const size_t stateWords = 3 + 3 * ComputeMesher::buckets + ComputeMesher::failureLog;
+/* two words per face, as face_t, and per range of a slot (first face, capacity) */
+static const size_t faceSize = 2 * sizeof(GLuint);
+static const size_t rangeSize = 2 * sizeof(GLuint);
+
+ComputeMesher::ComputeMesher( const glm::ivec3& chunkSize, uint margin, UploadRing* uploadRing ) : uploadRing(uploadRing), chunkSize(chunkSize), margin(margin) {
+    this->paddedSize = chunkSize + static_cast<int>(margin);
+    this->volumeSize = this->paddedSize.x * this->paddedSize.y * this->paddedSize.z;
+    this->shader = new Shader("./shader/compute/meshChunk.comp.glsl", std::unordered_map<std::string, std::string>());
+    this->volume = this->state = this->slots = this->commands = this->faces = 0;
+    resizeBuffer(this->volume, 0, this->volumeSize * 2, false);
+    resizeBuffer(this->state, 0, stateWords * sizeof(GLuint), true);
+    this->slotCapacity = 0;
+    this->reserveSlots(1);
+    GLint maxTexels = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+    this->maxArenaSize = static_cast<size_t>(maxTexels);
+    glGenTextures(1, &this->facesTexture);
+    this->arenaSize = 0;
+    GLuint arena = 0;
+    resizeBuffer(arena, 0, std::min(static_cast<size_t>(1 << 21), this->maxArenaSize) * faceSize, false);
+    this->setArena(arena, std::min(static_cast<size_t>(1 << 21), this->maxArenaSize));
+    this->stats = (computeMesherStats_t){ 0, 0, 0, 0, 0, 0 };
+    this->arenaTop = this->relocatedTop = 0;
+    glGenBuffers(1, &this->statusCopy);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, this->statusCopy);
+    glBufferData(GL_COPY_WRITE_BUFFER, stateWords * sizeof(GLuint), nullptr, GL_STREAM_READ);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    this->statusFence = 0;
+    this->failuresRead = 0;
+    this->pending = false;
+}
+
+ComputeMesher::~ComputeMesher( void ) {
+    if (this->statusFence != 0)
+        glDeleteSync(this->statusFence);
+    GLState::deleteTextures(1, &this->facesTexture);
+    glDeleteBuffers(1, &this->volume);
+    glDeleteBuffers(1, &this->state);
+    glDeleteBuffers(1, &this->slots);
+    glDeleteBuffers(1, &this->commands);
+    glDeleteBuffers(1, &this->faces);
+    glDeleteBuffers(1, &this->statusCopy);
+    delete this->shader;
+}
+
+/* the volume is orphaned, the previous mesh may still read it. The three passes are ordered by barriers */
+void    ComputeMesher::mesh( int slot, const uint8_t* texture, const uint8_t* lightMap ) {
+#ifdef GL_VERSION_4_3
+    this->reserveSlots(slot + 1);
+    this->failedSlots[slot] = 0;
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, this->volume);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, this->volumeSize * 2, nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    this->uploadRing->upload(this->volume, 0, texture, this->volumeSize);
+    this->uploadRing->upload(this->volume, this->volumeSize, lightMap, this->volumeSize);
+    this->shader->use();
+    this->shader->setIntUniformValue("slot", slot);
+    glUniform1ui(this->shader->getUniformLocation("arenaSize"), static_cast<GLuint>(this->arenaSize));
+    this->shader->setIvec3UniformValue("chunkSize", this->chunkSize);
+    this->shader->setIvec3UniformValue("paddedSize", this->paddedSize);
+    this->shader->setIntUniformValue("margin", this->margin);
+    const GLuint buffers[5] = { this->volume, this->state, this->slots, this->commands, this->faces };
+    for (GLuint b = 0; b < 5; ++b)
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, b, buffers[b]);
+    const glm::ivec3 groups = (this->chunkSize + 3) / 4;
+    this->shader->setIntUniformValue("pass", 0);
+    glDispatchCompute(groups.x, groups.y, groups.z);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    this->shader->setIntUniformValue("pass", 1);
+    glDispatchCompute(1, 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    this->shader->setIntUniformValue("pass", 2);
+    glDispatchCompute(groups.x, groups.y, groups.z);
+    /* the faces are fetched by the face vertex shader, the commands read by the draws */
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+    this->pending = true;
+    this->stats.meshes++;
+#endif
+}
+
+void    ComputeMesher::bind( void ) {
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, this->commands);
+}
+
+/* the faces buffer is bound on the active texture unit, the consecutive buckets facing the camera in a single draw */
+void    ComputeMesher::draw( int slot, bool transparent, uint8_t directions ) {
+#ifdef GL_VERSION_4_3
+    const size_t base = slot * buckets + (transparent ? 6 : 0);
+    if (transparent) /* only the top and bottom of the water */
+        directions &= 0x0C;
+    GLState::bindTexture(GL_TEXTURE_BUFFER, this->facesTexture);
+    for (int f = 0; f < 6; ++f) {
+        if ((directions & (1 << f)) == 0)
+            continue;
+        const int first = f;
+        while (f + 1 < 6 && (directions & (1 << (f + 1))) != 0)
+            ++f;
+        glMultiDrawArraysIndirect(GL_TRIANGLES, reinterpret_cast<GLvoid*>((base + first) * sizeof(drawCommand_t)), f + 1 - first, 0);
+        this->stats.draws++;
+    }
+#endif
+}
+
+/* the range and the commands of the slot are cleared, the slot may be meshed again from an empty range */
+void    ComputeMesher::release( int slot ) {
+    if (slot < 0 || static_cast<size_t>(slot) >= this->slotCapacity)
+        return;
+#ifdef GL_VERSION_4_3
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+#endif
+    const std::vector<uint8_t> zeros(buckets * sizeof(drawCommand_t), 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, this->slots);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, slot * rangeSize, rangeSize, zeros.data());
+    glBindBuffer(GL_COPY_WRITE_BUFFER, this->commands);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, slot * buckets * sizeof(drawCommand_t), buckets * sizeof(drawCommand_t), zeros.data());
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    this->failedSlots[slot] = 0;
+}
+
+/*  The state is copied when the previous copy was read, and read once its fence is signaled, so the CPU never
+    waits for the GPU. The failures are counted by the shader, the slots of the new ones are marked for the
+    chunks to remesh them, once the arena was relocated (past the log size, all the slots are).
+*/
+void    ComputeMesher::update( void ) {
+    GLuint failures = 0;
+    if (this->statusFence != 0) {
+        const GLenum status = glClientWaitSync(this->statusFence, 0, 0);
+        if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED) {
+            std::vector<GLuint> state(stateWords);
+            glDeleteSync(this->statusFence);
+            this->statusFence = 0;
+            glBindBuffer(GL_COPY_READ_BUFFER, this->statusCopy);
+            glGetBufferSubData(GL_COPY_READ_BUFFER, 0, stateWords * sizeof(GLuint), state.data());
+            glBindBuffer(GL_COPY_READ_BUFFER, 0);
+            this->arenaTop = state[0];
+            failures = state[1] - this->failuresRead;
+            const GLuint* log = state.data() + stateWords - failureLog;
+            for (GLuint f = this->failuresRead; f != state[1] && failures <= failureLog; ++f)
+                this->failedSlots[log[f % failureLog]] = 1;
+            if (failures > failureLog)
+                std::fill(this->failedSlots.begin(), this->failedSlots.end(), 1);
+            this->failuresRead = state[1];
+            this->stats.failures += failures;
+        }
+    }
+    /* at the buffer texture limit, only once enough faces were added to be worth reclaiming */
+    const bool relocatable = (this->arenaSize < this->maxArenaSize || this->arenaTop > this->relocatedTop + this->arenaSize / 8);
+    if ((failures > 0 || this->arenaTop > this->arenaSize / 4 * 3) && relocatable)
+        this->relocate();
+    if (this->statusFence == 0 && this->pending) {
+#ifdef GL_VERSION_4_3
+        glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+#endif
+        glBindBuffer(GL_COPY_READ_BUFFER, this->state);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, this->statusCopy);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, stateWords * sizeof(GLuint));
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        this->statusFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        this->pending = false;
+    }
+}
+
+const size_t    ComputeMesher::getBytes( void ) const {
+    return this->volumeSize * 2 + this->slotCapacity * (rangeSize + buckets * sizeof(drawCommand_t)) + this->arenaSize * faceSize;
+}
+
+/* the ranges and commands of the slots, grown as the chunk instance buffer */
+void    ComputeMesher::reserveSlots( size_t count ) {
+    if (count <= this->slotCapacity)
+        return;
+    const size_t capacity = std::max(static_cast<size_t>(1024), count * 2);
+#ifdef GL_VERSION_4_3
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+#endif
+    resizeBuffer(this->slots, this->slotCapacity * rangeSize, capacity * rangeSize, true);
+    resizeBuffer(this->commands, this->slotCapacity * buckets * sizeof(drawCommand_t), capacity * buckets * sizeof(drawCommand_t), true);
+    this->failedSlots.resize(capacity, 0);
+    this->slotCapacity = capacity;
+}
+
+/*  The live ranges (the ones of the slots) are packed at the start of a new arena, the released and outgrown
+    ranges between them are reclaimed. The arena doubles when the live faces fill more than half of it. The
+    ranges and the commands are read back to be moved, a stall, but only once the arena is almost full.
+*/
+void    ComputeMesher::relocate( void ) {
+#ifdef GL_VERSION_4_3
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+#endif
+    std::vector<GLuint> ranges(this->slotCapacity * 2);
+    std::vector<drawCommand_t> slotCommands(this->slotCapacity * buckets);
+    GLuint top = 0;
+    glBindBuffer(GL_COPY_READ_BUFFER, this->slots);
+    glGetBufferSubData(GL_COPY_READ_BUFFER, 0, ranges.size() * sizeof(GLuint), ranges.data());
+    glBindBuffer(GL_COPY_READ_BUFFER, this->commands);
+    glGetBufferSubData(GL_COPY_READ_BUFFER, 0, slotCommands.size() * sizeof(drawCommand_t), slotCommands.data());
+    glBindBuffer(GL_COPY_READ_BUFFER, this->state);
+    glGetBufferSubData(GL_COPY_READ_BUFFER, 0, sizeof(GLuint), &top);
+    /* the live ranges in the arena order, so that the ranges already packed are moved with a single copy */
+    std::vector<int> live;
+    size_t liveFaces = 0;
+    for (size_t s = 0; s < this->slotCapacity; ++s)
+        if (ranges[s * 2 + 1] > 0) {
+            live.push_back(s);
+            liveFaces += ranges[s * 2 + 1];
+        }
+    std::sort(live.begin(), live.end(), [&ranges]( int a, int b ) { return ranges[a * 2] < ranges[b * 2]; });
+    size_t size = this->arenaSize;
+    if (liveFaces > this->arenaSize / 2)
+        size = std::min(this->arenaSize * 2, this->maxArenaSize);
+    GLuint arena = 0;
+    resizeBuffer(arena, 0, size * faceSize, false);
+    glBindBuffer(GL_COPY_READ_BUFFER, this->faces);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, arena);
+    GLuint packed = 0;
+    size_t runFrom = 0, runTo = 0, runSize = 0;
+    for (size_t i = 0; i < live.size(); ++i) {
+        GLuint* range = &ranges[live[i] * 2];
+        if (runSize > 0 && range[0] != runFrom + runSize) {
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, runFrom * faceSize, runTo * faceSize, runSize * faceSize);
+            runSize = 0;
+        }
+        if (runSize == 0) {
+            runFrom = range[0];
+            runTo = packed;
+        }
+        runSize += range[1];
+        for (int b = 0; b < buckets; ++b) { /* the commands count vertices, six per face */
+            drawCommand_t& command = slotCommands[live[i] * buckets + b];
+            command.first = command.first - range[0] * 6 + packed * 6;
+        }
+        range[0] = packed;
+        packed += range[1];
+    }
+    if (runSize > 0)
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, runFrom * faceSize, runTo * faceSize, runSize * faceSize);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, this->slots);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, 0, ranges.size() * sizeof(GLuint), ranges.data());
+    glBindBuffer(GL_COPY_WRITE_BUFFER, this->commands);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, 0, slotCommands.size() * sizeof(drawCommand_t), slotCommands.data());
+    glBindBuffer(GL_COPY_WRITE_BUFFER, this->state);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, 0, sizeof(GLuint), &packed);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    glDeleteBuffers(1, &this->faces);
+    this->stats.relocations++;
+    this->stats.grows += (size > this->arenaSize);
+    this->stats.reclaimed += top - packed;
+    this->setArena(arena, size);
+    this->arenaTop = this->relocatedTop = packed;
+    if (this->statusFence != 0) { /* the state copied before the relocation, copied again */
+        glDeleteSync(this->statusFence);
+        this->statusFence = 0;
+        this->pending = true;
+    }
+}
+
+/* the faces buffer and the buffer texture over it */
+void    ComputeMesher::setArena( GLuint buffer, size_t size ) {
+    this->faces = buffer;
+    GLState::bindTexture(GL_TEXTURE_BUFFER, this->facesTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32UI, this->faces);
+    GLState::bindTexture(GL_TEXTURE_BUFFER, 0);
+    this->arenaSize = size;
+}
+
+/* a new buffer of the size, with the used bytes of the previous one (the rest is zeroed or undefined) */
+void    ComputeMesher::resizeBuffer( GLuint& buffer, size_t used, size_t size, bool zeroed ) {
+    GLuint  resized;
+    glGenBuffers(1, &resized);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, resized);
+    if (zeroed) {
+        const std::vector<uint8_t> zeros(size, 0);
+        glBufferData(GL_COPY_WRITE_BUFFER, size, zeros.data(), GL_DYNAMIC_DRAW);
+    }
+    else
+        glBufferData(GL_COPY_WRITE_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+    if (buffer != 0) {
+        glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, used);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glDeleteBuffers(1, &buffer);
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    buffer = resized;
+}
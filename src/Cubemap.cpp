@@ -14,21 +14,21 @@ Cubemap::Cubemap( const std::vector<std::string>& paths ) {
 }
 
 Cubemap::~Cubemap( void ) {
-    glDeleteTextures(1, &this->textures[0]);
-    glDeleteVertexArrays(1, &this->vao);
+    GLState::deleteTextures(1, &this->textures[0]);
+    GLState::deleteVertexArrays(1, &this->vao);
     glDeleteBuffers(1, &this->vbo);
     glDeleteBuffers(1, &this->ebo);
 }
 
 void    Cubemap::render( Shader shader ) {
     /* activate texture */
-    glActiveTexture(GL_TEXTURE0);
+    GLState::activeTexture(GL_TEXTURE0);
     shader.setIntUniformValue("skybox", 0);
-    glBindTexture(GL_TEXTURE_2D, this->textures[0]);
+    GLState::bindTexture(GL_TEXTURE_2D, this->textures[0]);
 
-    glBindVertexArray(this->vao);
+    GLState::bindVertexArray(this->vao);
     glDrawElements(GL_TRIANGLES, this->indices.size(), GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
+    GLState::bindVertexArray(0);
 }
 
 void    Cubemap::update( void ) {
@@ -38,7 +38,7 @@ void    Cubemap::setup( int mode ) {
 	glGenVertexArrays(1, &this->vao);
     glGenBuffers(1, &this->vbo);
 	glGenBuffers(1, &this->ebo);
-	glBindVertexArray(this->vao);
+	GLState::bindVertexArray(this->vao);
 	glBindBuffer(GL_ARRAY_BUFFER, this->vbo);
 	glBufferData(GL_ARRAY_BUFFER, this->vertices.size() * sizeof(glm::vec3), this->vertices.data(), mode);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->ebo);
@@ -48,5 +48,5 @@ void    Cubemap::setup( int mode ) {
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), static_cast<GLvoid*>(0));
 
     glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    GLState::bindVertexArray(0);
 }
@@ -1,7 +1,7 @@
 #include "Env.hpp"
 #include <OpenGL/gl.h>
 
-Env::Env( void ) {
+Env::Env( uint32_t seed ) {
     try {
         this->initGlfwEnvironment("4.0");
         // this->initGlfwWindow(720, 480); /* 1280x720 */
@@ -11,8 +11,8 @@ Env::Env( void ) {
             throw Exception::InitError("glad initialization failed");
         this->controller = new Controller(this->window.ptr);
 
-        this->terrain = new Terrain(160, 256); /* mandatory part */
-        // this->terrain = new Terrain(224, 256); /* Bonus part for render distance */
+        this->terrain = new Terrain(160, 256, seed); /* mandatory part */
+        // this->terrain = new Terrain(224, 256, seed); /* Bonus part for render distance */
 
         this->lights = {
             new Light(
@@ -76,10 +76,19 @@ void	Env::initGlfwWindow( size_t width, size_t height ) {
 void    Env::setupController( void ) {
     this->controller->setKeyProperties(GLFW_KEY_P, eKeyMode::toggle, 1, 1000);
     this->controller->setKeyProperties(GLFW_KEY_F, eKeyMode::toggle, 1, 1000);
+    this->controller->setKeyProperties(GLFW_KEY_L, eKeyMode::cycle, 0, 500, 3); /* generation lattice: full, 4x4x4, 4x8x4 */
+    this->controller->setKeyProperties(GLFW_KEY_K, eKeyMode::cycle, 2, 500, 3); /* lod levels: full resolution, up to 2x, up to 4x */
+    this->controller->setKeyProperties(GLFW_KEY_O, eKeyMode::toggle, 1, 1000); /* cave culling */
+    this->controller->setKeyProperties(GLFW_KEY_I, eKeyMode::toggle, 1, 1000); /* occlusion culling */
+    this->controller->setKeyProperties(GLFW_KEY_J, eKeyMode::toggle, 1, 1000); /* hierarchical culling (column tree) */
+    this->controller->setKeyProperties(GLFW_KEY_B, eKeyMode::toggle, 1, 1000); /* opaque chunks front to back (off to compare the overdraw) */
+    this->controller->setKeyProperties(GLFW_KEY_V, eKeyMode::toggle, 0, 1000); /* chunk faces pulled by the vertex shader (off: points expanded by the geometry shader) */
+    this->controller->setKeyProperties(GLFW_KEY_G, eKeyMode::toggle, 0, 1000); /* chunks meshed by a compute shader and drawn with indirect draws (GL 4.3, with the faces) */
+    this->controller->setKeyProperties(GLFW_KEY_H, eKeyMode::toggle, 0, 1000); /* terrain stats printed every second */
 }
 
 void    Env::framebufferSizeCallback( GLFWwindow* window, int width, int height ) {
-    glViewport(0, 0, width, height);
+    GLState::viewport(0, 0, width, height);
 }
 
 Light*  Env::getDirectionalLight( void ) {
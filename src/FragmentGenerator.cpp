@@ -0,0 +1,130 @@
+#include "FragmentGenerator.hpp"
+
+FragmentGenerator::FragmentGenerator( const glm::ivec3& chunkSize, uint margin, const std::unordered_map<std::string, std::string>& pragmas ) : margin(margin) {
+    this->paddedSize = chunkSize + static_cast<int>(margin);
+    this->slotSize = this->paddedSize.x * this->paddedSize.y * this->paddedSize.z;
+    this->columnSize = this->paddedSize.x * this->paddedSize.z * 4;
+    this->shader = new Shader("./shader/vertex/screenQuad.vert.glsl", "./shader/fragment/generateChunk.frag.glsl", pragmas);
+    this->voxels.resize(this->slotSize * capacity);
+    this->columns.resize(this->columnSize * capacity);
+    this->positions.reserve(capacity);
+    /* the quad of Terrain::setupChunkGenerationRenderingQuad: position and texture coordinates */
+    const float quad[20] = {
+        -1.0,-1.0, 0.0,  0.0, 1.0,
+         1.0,-1.0, 0.0,  1.0, 1.0,
+         1.0, 1.0, 0.0,  1.0, 0.0,
+        -1.0, 1.0, 0.0,  0.0, 0.0
+    };
+    const unsigned int indices[6] = { 0, 1, 2,  2, 3, 0 };
+    glGenVertexArrays(1, &this->vao);
+    glGenBuffers(1, &this->vbo);
+    glGenBuffers(1, &this->ebo);
+    GLState::bindVertexArray(this->vao);
+    glBindBuffer(GL_ARRAY_BUFFER, this->vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), static_cast<GLvoid*>(0));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), reinterpret_cast<GLvoid*>(3 * sizeof(float)));
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    GLState::bindVertexArray(0);
+    /* the voxels of a chunk are paddedSize.x by paddedSize.y * paddedSize.z texels */
+    glGenTextures(1, &this->layers);
+    GLState::bindTexture(GL_TEXTURE_2D_ARRAY, this->layers);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_R8, this->paddedSize.x, this->paddedSize.y * this->paddedSize.z, capacity, 0, GL_RED, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    GLState::bindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    glGenTextures(1, &this->column);
+    GLState::bindTexture(GL_TEXTURE_2D, this->column);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, this->paddedSize.x, this->paddedSize.z, 0, GL_RGBA, GL_FLOAT, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    GLState::bindTexture(GL_TEXTURE_2D, 0);
+    glGenFramebuffers(1, &this->fbo);
+}
+
+FragmentGenerator::~FragmentGenerator( void ) {
+    GLState::deleteFramebuffers(1, &this->fbo);
+    GLState::deleteTextures(1, &this->layers);
+    GLState::deleteTextures(1, &this->column);
+    GLState::deleteVertexArrays(1, &this->vao);
+    glDeleteBuffers(1, &this->vbo);
+    glDeleteBuffers(1, &this->ebo);
+    delete this->shader;
+}
+
+const int   FragmentGenerator::add( const glm::vec3& position, const std::vector<float>& columnFields ) {
+    const int slot = this->positions.size();
+    this->positions.push_back(position);
+    std::copy(columnFields.begin(), columnFields.begin() + this->columnSize, this->columns.begin() + slot * this->columnSize);
+    return slot;
+}
+
+void    FragmentGenerator::dispatch( int seed ) {
+    this->submit(seed);
+    this->read();
+}
+
+/* a draw per chunk, into its layer, with the uniforms of Terrain::renderChunkGeneration at full resolution */
+void    FragmentGenerator::submit( int seed ) {
+    if (this->positions.empty())
+        return;
+    const glm::ivec4 m_viewport = GLState::getViewport();
+    GLState::disable(GL_DEPTH_TEST);
+    GLState::bindFramebuffer(this->fbo);
+    GLState::viewport(0, 0, this->paddedSize.x, this->paddedSize.y * this->paddedSize.z);
+    this->shader->use();
+    this->shader->setFloatUniformValue("near", 0.1f);
+    this->shader->setVec3UniformValue("chunkSize", glm::vec3(this->paddedSize));
+    this->shader->setIntUniformValue("margin", this->margin);
+    this->shader->setIntUniformValue("seed", seed);
+    this->shader->setIntUniformValue("coarseLattice", 0);
+    this->shader->setIntUniformValue("latticePass", 0);
+    this->shader->setIntUniformValue("columnPass", 0);
+    this->shader->setIntUniformValue("horizonPass", 0);
+    this->shader->setIntUniformValue("useColumn", 1);
+    GLState::activeTexture(GL_TEXTURE3);
+    this->shader->setIntUniformValue("columnSampler", 3);
+    GLState::bindTexture(GL_TEXTURE_2D, this->column);
+    GLState::bindVertexArray(this->vao);
+    for (size_t i = 0; i < this->positions.size(); ++i) {
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, this->layers, 0, i);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, this->paddedSize.x, this->paddedSize.z, GL_RGBA, GL_FLOAT, &this->columns[i * this->columnSize]);
+        this->shader->setVec3UniformValue("chunkPosition", this->positions[i]);
+        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+    }
+    GLState::bindVertexArray(0);
+    GLState::activeTexture(GL_TEXTURE0);
+    GLState::enable(GL_DEPTH_TEST);
+    GLState::bindFramebuffer(0);
+    GLState::viewport(m_viewport[0], m_viewport[1], m_viewport[2], m_viewport[3]);
+}
+
+/* the layers are read back at once, the unused ones with them */
+void    FragmentGenerator::read( void ) {
+    if (this->positions.empty())
+        return;
+    GLState::bindTexture(GL_TEXTURE_2D_ARRAY, this->layers);
+    glGetTexImage(GL_TEXTURE_2D_ARRAY, 0, GL_RED, GL_UNSIGNED_BYTE, this->voxels.data());
+    GLState::bindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    decode(this->voxels.data(), this->slotSize * this->positions.size());
+}
+
+/*  The shader writes sqrt(id / 255) (see generateChunk.frag.glsl). Some drivers read it back as the id, the
+    conforming ones as round(sqrt(id / 255) * 255), which is above 15 for every bloc: both give the id.
+*/
+void    FragmentGenerator::decode( uint8_t* voxels, size_t size ) {
+    static const std::array<uint8_t, 256> ids = []() {
+        std::array<uint8_t, 256> table;
+        for (int i = 0; i < 256; ++i)
+            table[i] = static_cast<uint8_t>(i);
+        for (int id = 1; id <= static_cast<int>(eBloc::water); ++id)
+            table[static_cast<int>(std::round(std::sqrt(id / 255.0) * 255.0))] = static_cast<uint8_t>(id);
+        return table;
+    }();
+    for (size_t i = 0; i < size; ++i)
+        voxels[i] = ids[voxels[i]];
+}
@@ -0,0 +1,171 @@
+#include "GLState.hpp"
+
+const GLuint    GLState::unknown;
+
+GLState::GLState( void ) {
+    this->stats = (glStateStats_t){ 0, 0, 0 };
+    this->reset();
+}
+
+/* a cache per thread, each thread has its own context (see ChunkStreamer) */
+GLState&    GLState::state( void ) {
+    static thread_local GLState current;
+    return current;
+}
+
+void    GLState::invalidate( void ) {
+    state().reset();
+}
+
+void    GLState::reset( void ) {
+    this->program = this->vao = this->unit = this->fbo = unknown;
+    for (int u = 0; u < textureUnits; ++u)
+        this->textures[u].fill(unknown);
+    this->viewKnown = false;
+    this->enabled.fill(-1);
+}
+
+/* count the call, return true when it must be sent */
+const bool  GLState::isChanged( GLuint& current, GLuint value ) {
+    GLState& s = state();
+    if (current == value) {
+        s.stats.elided++;
+        return false;
+    }
+    current = value;
+    s.stats.issued++;
+    return true;
+}
+
+void    GLState::useProgram( GLuint program ) {
+    if (isChanged(state().program, program))
+        glUseProgram(program);
+}
+
+void    GLState::bindVertexArray( GLuint vao ) {
+    if (isChanged(state().vao, vao))
+        glBindVertexArray(vao);
+}
+
+void    GLState::activeTexture( GLenum unit ) {
+    if (isChanged(state().unit, unit))
+        glActiveTexture(unit);
+}
+
+void    GLState::bindTexture( GLenum target, GLuint texture ) {
+    GLState& s = state();
+    const int t = getTargetIndex(target);
+    const int u = static_cast<int>(s.unit - GL_TEXTURE0);
+    if (t < 0 || s.unit == unknown || u >= textureUnits) {
+        s.stats.issued++;
+        glBindTexture(target, texture);
+        return;
+    }
+    if (isChanged(s.textures[u][t], texture))
+        glBindTexture(target, texture);
+}
+
+void    GLState::bindFramebuffer( GLuint fbo ) {
+    if (isChanged(state().fbo, fbo))
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+}
+
+void    GLState::viewport( GLint x, GLint y, GLsizei width, GLsizei height ) {
+    GLState& s = state();
+    const glm::ivec4 view = glm::ivec4(x, y, width, height);
+    if (s.viewKnown == true && s.view == view) {
+        s.stats.elided++;
+        return;
+    }
+    s.view = view;
+    s.viewKnown = true;
+    s.stats.issued++;
+    glViewport(x, y, width, height);
+}
+
+/* only queried when the viewport was never set through the cache */
+const glm::ivec4&   GLState::getViewport( void ) {
+    GLState& s = state();
+    if (s.viewKnown == false) {
+        glGetIntegerv(GL_VIEWPORT, &s.view[0]);
+        s.viewKnown = true;
+    }
+    return s.view;
+}
+
+void    GLState::enable( GLenum capability ) {
+    setCapability(capability, true);
+}
+
+void    GLState::disable( GLenum capability ) {
+    setCapability(capability, false);
+}
+
+void    GLState::setCapability( GLenum capability, bool enable ) {
+    GLState& s = state();
+    const int c = getCapabilityIndex(capability);
+    if (c >= 0 && s.enabled[c] == static_cast<int>(enable)) {
+        s.stats.elided++;
+        return;
+    }
+    if (c >= 0)
+        s.enabled[c] = static_cast<int>(enable);
+    s.stats.issued++;
+    if (enable)
+        glEnable(capability);
+    else
+        glDisable(capability);
+}
+
+/* the deleted objects are unbound by GL */
+void    GLState::deleteVertexArrays( GLsizei n, const GLuint* vaos ) {
+    GLState& s = state();
+    for (GLsizei i = 0; i < n; ++i)
+        if (vaos[i] != 0 && s.vao == vaos[i])
+            s.vao = 0;
+    glDeleteVertexArrays(n, vaos);
+}
+
+void    GLState::deleteTextures( GLsizei n, const GLuint* textures ) {
+    GLState& s = state();
+    for (GLsizei i = 0; i < n; ++i)
+        for (int u = 0; u < textureUnits; ++u)
+            for (int t = 0; t < textureTargets; ++t)
+                if (textures[i] != 0 && s.textures[u][t] == textures[i])
+                    s.textures[u][t] = 0;
+    glDeleteTextures(n, textures);
+}
+
+void    GLState::deleteFramebuffers( GLsizei n, const GLuint* fbos ) {
+    GLState& s = state();
+    for (GLsizei i = 0; i < n; ++i)
+        if (fbos[i] != 0 && s.fbo == fbos[i])
+            s.fbo = 0;
+    glDeleteFramebuffers(n, fbos);
+}
+
+void    GLState::endFrame( void ) {
+    state().stats.frames++;
+}
+
+const int   GLState::getTargetIndex( GLenum target ) {
+    switch (target) {
+        case GL_TEXTURE_2D:         return 0;
+        case GL_TEXTURE_3D:         return 1;
+        case GL_TEXTURE_CUBE_MAP:   return 2;
+        case GL_TEXTURE_2D_ARRAY:   return 3;
+        case GL_TEXTURE_BUFFER:     return 4;
+    }
+    return -1;
+}
+
+const int   GLState::getCapabilityIndex( GLenum capability ) {
+    switch (capability) {
+        case GL_DEPTH_TEST:         return 0;
+        case GL_CULL_FACE:          return 1;
+        case GL_BLEND:              return 2;
+        case GL_SCISSOR_TEST:       return 3;
+        case GL_FRAMEBUFFER_SRGB:   return 4;
+    }
+    return -1;
+}
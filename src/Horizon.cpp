@@ -0,0 +1,190 @@
+#include "Horizon.hpp"
+
+Horizon::Horizon( uint levels, int size, float step, uint samplesBudget ) : size(size), samplesBudget(samplesBudget) {
+    this->stats = (horizonStats_t){ 0, 0, 0 };
+    this->levels.resize(levels);
+    for (uint l = 0; l < levels; ++l) {
+        this->levels[l].step = step * static_cast<float>(1 << l);
+        this->setupLevel(this->levels[l]);
+    }
+    this->setupGrid();
+    this->shader = new Shader("./shader/vertex/horizon.vert.glsl", "./shader/fragment/horizon.frag.glsl");
+}
+
+Horizon::~Horizon( void ) {
+    for (size_t l = 0; l < this->levels.size(); ++l) {
+        GLState::deleteFramebuffers(1, &this->levels[l].fbo);
+        GLState::deleteTextures(1, &this->levels[l].texture);
+    }
+    GLState::deleteVertexArrays(1, &this->vao);
+    glDeleteBuffers(1, &this->vbo);
+    glDeleteBuffers(1, &this->ebo);
+    delete this->shader;
+}
+
+/* the level centered on the camera, snapped to two samples so that it stays aligned on the next level */
+const glm::ivec2    Horizon::getTargetOrigin( const horizonLevel_t& level, const glm::vec3& cameraPosition ) const {
+    const glm::ivec2 center = glm::ivec2(
+        static_cast<int>(std::floor(cameraPosition.x / (level.step * 2.0f))) * 2,
+        static_cast<int>(std::floor(cameraPosition.z / (level.step * 2.0f))) * 2
+    );
+    return center - this->size / 2;
+}
+
+/*  move the levels with the camera, only the samples entering a level are evaluated. The levels are
+    updated from the finest, and the moves exceeding the samples budget wait for the next update.
+*/
+void    Horizon::update( const glm::vec3& cameraPosition, Shader& generationShader, GLuint quadVao ) {
+    uint budget = this->samplesBudget;
+    bool moved = false;
+    for (size_t l = 0; l < this->levels.size(); ++l) {
+        horizonLevel_t& level = this->levels[l];
+        const glm::ivec2 target = this->getTargetOrigin(level, cameraPosition);
+        if (level.filled == true && target == level.origin)
+            continue;
+        const glm::ivec2 d = glm::ivec2(std::abs(target.x - level.origin.x), std::abs(target.y - level.origin.y));
+        const bool full = (level.filled == false || d.x >= this->size || d.y >= this->size);
+        const uint samples = (full ? this->size * this->size : (d.x + d.y) * this->size - d.x * d.y);
+        if (samples > budget && moved == true) {
+            this->stats.deferred++;
+            continue;
+        }
+        generationShader.setIvec2UniformValue("horizonOrigin", target);
+        generationShader.setIntUniformValue("horizonSize", this->size);
+        generationShader.setFloatUniformValue("horizonStep", level.step);
+        if (full)
+            this->renderSamples(level, target, target + this->size, generationShader, quadVao);
+        else {
+            const glm::ivec2 from = level.origin;
+            /* the columns entering the level, then the rows entering it over the columns kept */
+            if (target.x > from.x)
+                this->renderSamples(level, glm::ivec2(from.x + this->size, target.y), target + this->size, generationShader, quadVao);
+            if (target.x < from.x)
+                this->renderSamples(level, target, glm::ivec2(from.x, target.y + this->size), generationShader, quadVao);
+            const int keptFrom = std::max(from.x, target.x);
+            const int keptTo = std::min(from.x, target.x) + this->size;
+            if (target.y > from.y)
+                this->renderSamples(level, glm::ivec2(keptFrom, from.y + this->size), glm::ivec2(keptTo, target.y + this->size), generationShader, quadVao);
+            if (target.y < from.y)
+                this->renderSamples(level, glm::ivec2(keptFrom, target.y), glm::ivec2(keptTo, from.y), generationShader, quadVao);
+        }
+        level.origin = target;
+        level.filled = true;
+        budget -= std::min(budget, samples);
+        moved = true;
+        this->stats.samples += samples;
+        this->stats.moves++;
+    }
+}
+
+/* evaluate the samples [from, to) of the level, the area wraps around the texture in up to four rectangles */
+void    Horizon::renderSamples( horizonLevel_t& level, const glm::ivec2& from, const glm::ivec2& to, Shader& generationShader, GLuint quadVao ) {
+    const glm::ivec2 start = glm::ivec2(((from.x % this->size) + this->size) % this->size, ((from.y % this->size) + this->size) % this->size);
+    const glm::ivec2 extent = to - from;
+    GLState::bindFramebuffer(level.fbo);
+    GLState::viewport(0, 0, this->size, this->size);
+    GLState::enable(GL_SCISSOR_TEST);
+    GLState::bindVertexArray(quadVao);
+    for (int sy = 0; sy < 2; ++sy)
+        for (int sx = 0; sx < 2; ++sx) {
+            const int x = (sx == 0 ? start.x : 0);
+            const int y = (sy == 0 ? start.y : 0);
+            const int w = (sx == 0 ? std::min(extent.x, this->size - start.x) : extent.x - (this->size - start.x));
+            const int h = (sy == 0 ? std::min(extent.y, this->size - start.y) : extent.y - (this->size - start.y));
+            if (w <= 0 || h <= 0)
+                continue;
+            glScissor(x, y, w, h);
+            glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+        }
+    GLState::bindVertexArray(0);
+    GLState::disable(GL_SCISSOR_TEST);
+}
+
+/*  render the levels beyond the chunks. The horizon is far away, so it uses a projection of its own
+    reaching the coarsest level, the depth buffer is cleared afterwards and the chunks drawn over it.
+*/
+void    Horizon::render( Camera& camera, GLuint textureAtlas, float innerDistance ) {
+    const float outer = this->getExtent();
+    if (outer <= innerDistance)
+        return;
+    const glm::mat4 projection = glm::perspective(glm::radians(camera.getFov()), camera.getAspect(), std::max(1.0f, innerDistance * 0.25f), outer * 2.0f);
+    this->shader->use();
+    this->shader->setMat4UniformValue("_vp", projection * camera.getViewMatrix());
+    this->shader->setVec3UniformValue("cameraPos", camera.getPosition());
+    this->shader->setFloatUniformValue("innerDistance", innerDistance);
+    this->shader->setFloatUniformValue("outerDistance", outer);
+    this->shader->setIntUniformValue("size", this->size);
+    GLState::activeTexture(GL_TEXTURE0);
+    this->shader->setIntUniformValue("atlas", 0);
+    GLState::bindTexture(GL_TEXTURE_2D, textureAtlas);
+    GLState::activeTexture(GL_TEXTURE1);
+    this->shader->setIntUniformValue("samples", 1);
+    GLState::disable(GL_CULL_FACE);
+    GLState::bindVertexArray(this->vao);
+    for (size_t l = 0; l < this->levels.size(); ++l) {
+        const horizonLevel_t& level = this->levels[l];
+        if (level.filled == false || level.step * (this->size / 2 - 1) <= innerDistance) /* hidden by the chunks */
+            continue;
+        /* the area of the finer level (minus one of its samples, they overlap a bit) is not drawn twice */
+        glm::vec4 innerBounds = glm::vec4(0.0f);
+        if (l > 0 && this->levels[l-1].filled == true) {
+            const horizonLevel_t& finer = this->levels[l-1];
+            innerBounds = glm::vec4(
+                (finer.origin.x + 1) * finer.step, (finer.origin.y + 1) * finer.step,
+                (finer.origin.x + this->size - 2) * finer.step, (finer.origin.y + this->size - 2) * finer.step
+            );
+        }
+        this->shader->setVec4UniformValue("innerBounds", innerBounds);
+        this->shader->setIvec2UniformValue("origin", level.origin);
+        this->shader->setFloatUniformValue("step", level.step);
+        GLState::bindTexture(GL_TEXTURE_2D, level.texture);
+        glDrawElements(GL_TRIANGLES, this->indicesCount, GL_UNSIGNED_INT, 0);
+    }
+    GLState::bindVertexArray(0);
+    GLState::bindTexture(GL_TEXTURE_2D, 0);
+    GLState::activeTexture(GL_TEXTURE0);
+    GLState::enable(GL_CULL_FACE);
+}
+
+void    Horizon::setupLevel( horizonLevel_t& level ) {
+    level.origin = glm::ivec2(0);
+    level.filled = false;
+    glGenFramebuffers(1, &level.fbo);
+    GLState::bindFramebuffer(level.fbo);
+    glGenTextures(1, &level.texture);
+    GLState::bindTexture(GL_TEXTURE_2D, level.texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32F, this->size, this->size, 0, GL_RG, GL_FLOAT, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, level.texture, 0);
+    GLState::bindTexture(GL_TEXTURE_2D, 0);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        throw Exception::RuntimeError("Horizon: incomplete level framebuffer");
+    GLState::bindFramebuffer(0);
+}
+
+/* the grid shared by the levels, one vertex per sample (the heights are fetched by the vertex shader) */
+void    Horizon::setupGrid( void ) {
+    std::vector<glm::vec2>      vertices;
+    std::vector<unsigned int>   indices;
+    for (int z = 0; z < this->size; ++z)
+        for (int x = 0; x < this->size; ++x)
+            vertices.push_back(glm::vec2(x, z));
+    for (int z = 0; z < this->size - 1; ++z)
+        for (int x = 0; x < this->size - 1; ++x) {
+            const unsigned int i = x + z * this->size;
+            indices.insert(indices.end(), { i, i + this->size, i + 1, i + 1, i + this->size, i + this->size + 1 });
+        }
+    this->indicesCount = indices.size();
+    glGenVertexArrays(1, &this->vao);
+    glGenBuffers(1, &this->vbo);
+    glGenBuffers(1, &this->ebo);
+    GLState::bindVertexArray(this->vao);
+    glBindBuffer(GL_ARRAY_BUFFER, this->vbo);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(glm::vec2), vertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), static_cast<GLvoid*>(0));
+    GLState::bindVertexArray(0);
+}
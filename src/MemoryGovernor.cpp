@@ -0,0 +1,40 @@
+#include "MemoryGovernor.hpp"
+
+static const uint   shrinkDelay = 10;   /* updates between two decreases, to let the evictions happen */
+static const uint   growDelay = 120;    /* updates without pressure before an increase */
+
+MemoryGovernor::MemoryGovernor( size_t budget, uint renderDistance, uint minRenderDistance, uint step ) : budget(budget), renderDistance(renderDistance), maxRenderDistance(renderDistance), step(step), updatesSinceChange(0) {
+    this->minRenderDistance = std::min(minRenderDistance, renderDistance);
+    this->stats = (governorStats_t){ 0, 0, 0 };
+}
+
+MemoryGovernor::~MemoryGovernor( void ) {
+}
+
+/* adapt the render distance to the memory used by the resident chunks (after the evictions) */
+void    MemoryGovernor::update( const memoryUsage_t& usage ) {
+    const size_t resident = getResident(usage);
+    this->updatesSinceChange++;
+    if (resident > this->budget && this->renderDistance > this->minRenderDistance && this->updatesSinceChange >= shrinkDelay) {
+        this->renderDistance = std::max(this->minRenderDistance, this->renderDistance - std::min(this->step, this->renderDistance));
+        this->updatesSinceChange = 0;
+        this->stats.shrinks++;
+    }
+    else if (resident < this->budget / 4 * 3 && this->renderDistance < this->maxRenderDistance && this->updatesSinceChange >= growDelay) {
+        this->renderDistance = std::min(this->maxRenderDistance, this->renderDistance + this->step);
+        this->updatesSinceChange = 0;
+        this->stats.grows++;
+    }
+}
+
+/* bytes of resident chunks to evict */
+const size_t    MemoryGovernor::getExcess( const memoryUsage_t& usage ) const {
+    const size_t resident = getResident(usage);
+    return (resident > this->budget ? resident - this->budget : 0);
+}
+
+/* the chunk cache limit: what the resident chunks leave of the budget */
+const size_t    MemoryGovernor::getCacheBudget( const memoryUsage_t& usage, size_t cacheMaxBytes ) const {
+    const size_t resident = getResident(usage);
+    return (resident < this->budget ? std::min(cacheMaxBytes, this->budget - resident) : 0);
+}
@@ -0,0 +1,237 @@
+#include "OcclusionBuffer.hpp"
+
+/* the faces of a box (corner i is at x = i & 1, y = i & 2, z = i & 4), counter-clockwise seen from outside */
+static const int    boxFaces[6][4] = {
+    { 1, 3, 7, 5 }, { 0, 4, 6, 2 }, { 2, 6, 7, 3 }, { 0, 1, 5, 4 }, { 4, 5, 7, 6 }, { 0, 2, 3, 1 }
+};
+
+OcclusionBuffer::OcclusionBuffer( int width, int height, uint threads ) {
+    this->width = std::max(tileSize, width / tileSize * tileSize);
+    this->height = std::max(tileSize, height / tileSize * tileSize);
+    this->tilesX = this->width / tileSize;
+    this->tilesY = this->height / tileSize;
+    this->depth.assign(this->width * this->height, 1.0f);
+    this->tiles.assign(this->tilesX * this->tilesY, 1.0f);
+    this->viewProjection = glm::mat4(1.0f);
+    const int bands = std::max(1, std::min(static_cast<int>(threads), this->tilesY));
+    this->bandHeight = (this->tilesY + bands - 1) / bands * tileSize;
+    this->generation = 0;
+    this->pending = 0;
+    this->stopping = false;
+    for (int y = this->bandHeight, band = 1; y < this->height; y += this->bandHeight, ++band)
+        this->workers.push_back(std::thread(&OcclusionBuffer::work, this, band));
+}
+
+OcclusionBuffer::~OcclusionBuffer( void ) {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+    }
+    this->wake.notify_all();
+    for (size_t i = 0; i < this->workers.size(); ++i)
+        this->workers[i].join();
+}
+
+void    OcclusionBuffer::clear( const glm::mat4& viewProjection ) {
+    this->viewProjection = viewProjection;
+    std::fill(this->depth.begin(), this->depth.end(), 1.0f);
+    std::fill(this->tiles.begin(), this->tiles.end(), 1.0f);
+    this->triangles.clear();
+}
+
+/* the box must be inside solid voxels, its faces are set up now and rasterized by rasterize */
+void    OcclusionBuffer::addOccluder( const glm::vec3& min, const glm::vec3& max ) {
+    std::array<glm::vec4, 8> corners;
+    for (int i = 0; i < 8; ++i)
+        corners[i] = this->viewProjection * glm::vec4((i & 1 ? max.x : min.x), (i & 2 ? max.y : min.y), (i & 4 ? max.z : min.z), 1.0f);
+    for (int f = 0; f < 6; ++f) {
+        const int* q = boxFaces[f];
+        this->addTriangle(corners[q[0]], corners[q[1]], corners[q[2]]);
+        this->addTriangle(corners[q[0]], corners[q[2]], corners[q[3]]);
+    }
+}
+
+/* clip the triangle by the near plane (z + w >= 0), it gives one or two triangles */
+void    OcclusionBuffer::addTriangle( const glm::vec4& a, const glm::vec4& b, const glm::vec4& c ) {
+    const glm::vec4 in[3] = { a, b, c };
+    glm::vec4 out[4];
+    int n = 0;
+    for (int i = 0; i < 3; ++i) {
+        const glm::vec4& current = in[i];
+        const glm::vec4& next = in[(i + 1) % 3];
+        const float dc = current.z + current.w;
+        const float dn = next.z + next.w;
+        if (dc >= 0.0f)
+            out[n++] = current;
+        if ((dc >= 0.0f) != (dn >= 0.0f))
+            out[n++] = current + (next - current) * (dc / (dc - dn));
+    }
+    if (n < 3)
+        return;
+    const glm::vec3 p0 = this->toBuffer(out[0]);
+    const glm::vec3 p2 = this->toBuffer(out[2]);
+    this->setupTriangle(p0, this->toBuffer(out[1]), p2);
+    if (n == 4)
+        this->setupTriangle(p0, p2, this->toBuffer(out[3]));
+}
+
+const glm::vec3 OcclusionBuffer::toBuffer( const glm::vec4& clip ) const {
+    const glm::vec3 ndc = glm::vec3(clip) / clip.w;
+    return glm::vec3((ndc.x * 0.5f + 0.5f) * this->width, (ndc.y * 0.5f + 0.5f) * this->height, ndc.z * 0.5f + 0.5f);
+}
+
+void    OcclusionBuffer::setupTriangle( const glm::vec3& a, const glm::vec3& b, const glm::vec3& c ) {
+    const float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+    if (area <= 0.0f) /* back facing or degenerate */
+        return;
+    occluderTriangle_t t;
+    t.bounds = glm::ivec4(
+        std::max(0, static_cast<int>(std::floor(std::min(a.x, std::min(b.x, c.x))))),
+        std::max(0, static_cast<int>(std::floor(std::min(a.y, std::min(b.y, c.y))))),
+        std::min(this->width, static_cast<int>(std::ceil(std::max(a.x, std::max(b.x, c.x))))),
+        std::min(this->height, static_cast<int>(std::ceil(std::max(a.y, std::max(b.y, c.y)))))
+    );
+    if (t.bounds.x >= t.bounds.z || t.bounds.y >= t.bounds.w)
+        return;
+    t.v[0] = glm::vec2(a);
+    t.v[1] = glm::vec2(b);
+    t.v[2] = glm::vec2(c);
+    t.plane.x = ((b.z - a.z) * (c.y - a.y) - (c.z - a.z) * (b.y - a.y)) / area;
+    t.plane.y = ((c.z - a.z) * (b.x - a.x) - (b.z - a.z) * (c.x - a.x)) / area;
+    t.plane.z = a.z - t.plane.x * a.x - t.plane.y * a.y;
+    t.depthRange = glm::vec2(
+        std::max(0.0f, std::min(a.z, std::min(b.z, c.z))),
+        std::min(1.0f, std::max(a.z, std::max(b.z, c.z)))
+    );
+    this->triangles.push_back(t);
+}
+
+/* rasterize the occluders in bands of tile rows, then build the tiles depth */
+void    OcclusionBuffer::rasterize( void ) {
+    if (this->workers.empty()) {
+        this->rasterizeBand(0, this->height);
+        return ;
+    }
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->pending = this->workers.size();
+        this->generation++;
+    }
+    this->wake.notify_all();
+    this->rasterizeBand(0, this->bandHeight);
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->done.wait(lock, [this]() { return this->pending == 0; });
+}
+
+/* a worker sleeps between the frames, the mutex orders its band with the triangles and with the tests */
+void    OcclusionBuffer::work( int band ) {
+    uint64_t seen = 0;
+    std::unique_lock<std::mutex> lock(this->mutex);
+    for (;;) {
+        this->wake.wait(lock, [this, &seen]() { return this->stopping || this->generation != seen; });
+        if (this->stopping)
+            return ;
+        seen = this->generation;
+        lock.unlock();
+        this->rasterizeBand(band * this->bandHeight, std::min(this->height, (band + 1) * this->bandHeight));
+        lock.lock();
+        if (--this->pending == 0)
+            this->done.notify_one();
+    }
+}
+
+void    OcclusionBuffer::rasterizeBand( int y0, int y1 ) {
+    for (size_t i = 0; i < this->triangles.size(); ++i)
+        if (this->triangles[i].bounds.y < y1 && this->triangles[i].bounds.w > y0)
+            this->rasterizeTriangle(this->triangles[i], y0, y1);
+    for (int ty = y0 / tileSize; ty < y1 / tileSize; ++ty)
+        for (int tx = 0; tx < this->tilesX; ++tx) {
+            float farthest = 0.0f;
+            for (int y = ty * tileSize; y < (ty + 1) * tileSize; ++y)
+                for (int x = tx * tileSize; x < (tx + 1) * tileSize; ++x)
+                    farthest = std::max(farthest, this->depth[x + y * this->width]);
+            this->tiles[tx + ty * this->tilesX] = farthest;
+        }
+}
+
+/*  the coverage is sampled at the pixel centers, four pixels at a time (the width is a multiple of four).
+    The SSE and scalar paths make the same operations, so they give the same depths.
+*/
+void    OcclusionBuffer::rasterizeTriangle( const occluderTriangle_t& t, int y0, int y1 ) {
+    float ex[3], ey[3], e0[3];
+    for (int i = 0; i < 3; ++i) {
+        const glm::vec2& from = t.v[i];
+        const glm::vec2& to = t.v[(i + 1) % 3];
+        ex[i] = from.y - to.y;
+        ey[i] = to.x - from.x;
+        e0[i] = -(ex[i] * from.x + ey[i] * from.y);
+    }
+    const int xs = t.bounds.x & ~3;
+    for (int y = std::max(y0, t.bounds.y); y < std::min(y1, t.bounds.w); ++y) {
+        float* row = &this->depth[y * this->width];
+        const float py = static_cast<float>(y) + 0.5f;
+        const float rowE[3] = { ey[0] * py + e0[0], ey[1] * py + e0[1], ey[2] * py + e0[2] };
+        const float rowD = t.plane.y * py + t.plane.z;
+#if defined(__SSE2__)
+        const __m128 offsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+        const __m128 zero = _mm_setzero_ps();
+        for (int x = xs; x < t.bounds.z; x += 4) {
+            const __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), offsets);
+            const __m128 w0 = _mm_add_ps(_mm_set1_ps(rowE[0]), _mm_mul_ps(_mm_set1_ps(ex[0]), px));
+            const __m128 w1 = _mm_add_ps(_mm_set1_ps(rowE[1]), _mm_mul_ps(_mm_set1_ps(ex[1]), px));
+            const __m128 w2 = _mm_add_ps(_mm_set1_ps(rowE[2]), _mm_mul_ps(_mm_set1_ps(ex[2]), px));
+            const __m128 mask = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(w0, zero), _mm_cmpge_ps(w1, zero)), _mm_cmpge_ps(w2, zero));
+            if (_mm_movemask_ps(mask) == 0)
+                continue;
+            __m128 d = _mm_add_ps(_mm_set1_ps(rowD), _mm_mul_ps(_mm_set1_ps(t.plane.x), px));
+            d = _mm_min_ps(_mm_max_ps(d, _mm_set1_ps(t.depthRange.x)), _mm_set1_ps(t.depthRange.y));
+            const __m128 old = _mm_loadu_ps(row + x);
+            _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(mask, _mm_min_ps(old, d)), _mm_andnot_ps(mask, old)));
+        }
+#else
+        for (int x = xs; x < t.bounds.z; x += 4)
+            for (int k = 0; k < 4; ++k) {
+                const float px = static_cast<float>(x) + (static_cast<float>(k) + 0.5f);
+                if (rowE[0] + ex[0] * px < 0.0f || rowE[1] + ex[1] * px < 0.0f || rowE[2] + ex[2] * px < 0.0f)
+                    continue;
+                const float d = std::min(std::max(rowD + t.plane.x * px, t.depthRange.x), t.depthRange.y);
+                row[x + k] = std::min(row[x + k], d);
+            }
+#endif
+    }
+}
+
+/*  the box is hidden when its nearest depth is behind every pixel it covers. The tiles are tested first,
+    the pixels only where a tile is farther. The rectangle is grown by a pixel, as the occluders coverage
+    is only sampled at the pixel centers.
+*/
+const bool  OcclusionBuffer::isVisible( const glm::vec3& min, const glm::vec3& max ) const {
+    glm::vec2 lo = glm::vec2(INFINITY);
+    glm::vec2 hi = glm::vec2(-INFINITY);
+    float nearest = 1.0f;
+    for (int i = 0; i < 8; ++i) {
+        const glm::vec4 clip = this->viewProjection * glm::vec4((i & 1 ? max.x : min.x), (i & 2 ? max.y : min.y), (i & 4 ? max.z : min.z), 1.0f);
+        if (clip.z + clip.w <= 0.0f) /* crosses the near plane */
+            return true;
+        const glm::vec3 p = this->toBuffer(clip);
+        lo = glm::min(lo, glm::vec2(p));
+        hi = glm::max(hi, glm::vec2(p));
+        nearest = std::min(nearest, p.z);
+    }
+    const int x0 = std::max(0, static_cast<int>(std::floor(lo.x)) - 1);
+    const int y0 = std::max(0, static_cast<int>(std::floor(lo.y)) - 1);
+    const int x1 = std::min(this->width, static_cast<int>(std::ceil(hi.x)) + 1);
+    const int y1 = std::min(this->height, static_cast<int>(std::ceil(hi.y)) + 1);
+    if (x0 >= x1 || y0 >= y1) /* out of the buffer, left to the fustrum test */
+        return true;
+    for (int ty = y0 / tileSize; ty <= (y1 - 1) / tileSize; ++ty)
+        for (int tx = x0 / tileSize; tx <= (x1 - 1) / tileSize; ++tx) {
+            if (this->tiles[tx + ty * this->tilesX] < nearest)
+                continue;
+            for (int y = std::max(y0, ty * tileSize); y < std::min(y1, (ty + 1) * tileSize); ++y)
+                for (int x = std::max(x0, tx * tileSize); x < std::min(x1, (tx + 1) * tileSize); ++x)
+                    if (this->depth[x + y * this->width] >= nearest)
+                        return true;
+        }
+    return false;
+}
@@ -0,0 +1,81 @@
+#include "Pool.hpp"
+
+static const size_t cacheLineSize = 64;
+
+Pool::Pool( size_t blockSize, size_t slabSize ) : freeList(nullptr) {
+    this->blockSize = (std::max(blockSize, sizeof(void*)) + cacheLineSize - 1) / cacheLineSize * cacheLineSize;
+    this->slabSize = std::max(slabSize, this->blockSize);
+    this->stats = (poolStats_t){ 0, 0, 0, 0, 0, 0 };
+}
+
+Pool::~Pool( void ) {
+    for (size_t i = 0; i < this->slabList.size(); ++i)
+        munmap(this->slabList[i], this->slabSize);
+    this->slabList.clear();
+}
+
+std::map<size_t, Pool>&  Pool::pools( void ) {
+    static std::map<size_t, Pool> pools;
+    return pools;
+}
+
+Pool&   Pool::forSize( size_t blockSize ) {
+    std::map<size_t, Pool>& p = pools();
+    auto it = p.find(blockSize);
+    if (it == p.end())
+        it = p.emplace(std::piecewise_construct, std::forward_as_tuple(blockSize), std::forward_as_tuple(blockSize)).first;
+    return it->second;
+}
+
+/* map a new slab (huge pages first if available) and push its blocks on the free list */
+void    Pool::addSlab( void ) {
+    void* slab = MAP_FAILED;
+    bool huge = false;
+#if defined(MAP_HUGETLB)
+    if (this->slabSize % (2 << 20) == 0)
+        slab = mmap(nullptr, this->slabSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#elif defined(VM_FLAGS_SUPERPAGE_SIZE_2MB)
+    if (this->slabSize % (2 << 20) == 0)
+        slab = mmap(nullptr, this->slabSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, VM_FLAGS_SUPERPAGE_SIZE_2MB, 0);
+#endif
+    huge = (slab != MAP_FAILED);
+    if (slab == MAP_FAILED)
+        slab = mmap(nullptr, this->slabSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+    if (slab == MAP_FAILED)
+        throw std::bad_alloc();
+#if defined(MADV_HUGEPAGE)
+    if (huge == false) /* transparent huge pages */
+        madvise(slab, this->slabSize, MADV_HUGEPAGE);
+#endif
+    this->slabList.push_back(slab);
+    /* the blocks are linked in address order */
+    const size_t count = this->slabSize / this->blockSize;
+    uint8_t* base = static_cast<uint8_t*>(slab);
+    for (size_t i = count; i > 0; --i) {
+        void* block = base + (i - 1) * this->blockSize;
+        *static_cast<void**>(block) = this->freeList;
+        this->freeList = block;
+    }
+    this->stats.slabs++;
+    this->stats.hugeSlabs += huge;
+    this->stats.capacity += count;
+}
+
+void*   Pool::allocate( void ) {
+    if (this->freeList == nullptr)
+        this->addSlab();
+    void* block = this->freeList;
+    this->freeList = *static_cast<void**>(block);
+    this->stats.allocations++;
+    this->stats.used++;
+    return block;
+}
+
+void    Pool::release( void* block ) {
+    if (block == nullptr)
+        return ;
+    *static_cast<void**>(block) = this->freeList;
+    this->freeList = block;
+    this->stats.releases++;
+    this->stats.used--;
+}
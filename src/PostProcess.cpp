@@ -7,7 +7,7 @@ PostProcess::PostProcess( void ) {
 }
 
 PostProcess::~PostProcess( void ) {
-    glDeleteVertexArrays(1, &this->vao);
+    GLState::deleteVertexArrays(1, &this->vao);
     glDeleteBuffers(1, &this->vbo);
     glDeleteBuffers(1, &this->ebo);
 }
@@ -31,15 +31,15 @@ void    PostProcess::createRenderQuad( void ) {
 
 void    PostProcess::render( Shader shader, GLuint tex ) {
     /* bind textures */
-    glActiveTexture(GL_TEXTURE0);
+    GLState::activeTexture(GL_TEXTURE0);
     shader.setIntUniformValue("l_tex", 0);
-    glBindTexture(GL_TEXTURE_2D, tex);
+    GLState::bindTexture(GL_TEXTURE_2D, tex);
 
     /* render */
-    glBindVertexArray(this->vao);
+    GLState::bindVertexArray(this->vao);
     glDrawElements(GL_TRIANGLES, this->indices.size(), GL_UNSIGNED_INT, 0);
 
-    glBindVertexArray(0);
+    GLState::bindVertexArray(0);
 }
 
 void    PostProcess::setup( int mode ) {
@@ -49,7 +49,7 @@ void    PostProcess::setup( int mode ) {
 	glGenBuffers(1, &this->ebo);
     // bind vertex array object, basically this is an object to allow us to not redo all of this process each time
     // we want to draw an object to screen, all the states we set are stored in the VAO
-	glBindVertexArray(this->vao);
+	GLState::bindVertexArray(this->vao);
     // copy our vertices array in a buffer for OpenGL to use
 	glBindBuffer(GL_ARRAY_BUFFER, this->vbo);
 	glBufferData(GL_ARRAY_BUFFER, this->vertices.size() * sizeof(tQuadVertex), this->vertices.data(), mode);
@@ -65,5 +65,5 @@ void    PostProcess::setup( int mode ) {
     glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(tQuadVertex), reinterpret_cast<GLvoid*>(offsetof(tQuadVertex, TexCoords)));
 
     glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    GLState::bindVertexArray(0);
 }
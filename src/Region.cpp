@@ -0,0 +1,242 @@
+#include "Region.hpp"
+
+const glm::ivec3    Region::size = glm::ivec3(32, 8, 32);
+static const char   regionMagic[4] = { 'V', 'O', 'X', 'R' };
+static const size_t regionHeaderSize = sizeof(regionMagic) + sizeof(uint32_t) + 32 * 8 * 32 * sizeof(regionEntry_t);
+
+Region::Region( const std::string& path, uint32_t generation ) : lastUse(0), path(path), mapped(nullptr), mappedSize(0), outdated(false) {
+    this->fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (this->fd == -1)
+        throw Exception::RuntimeError("cannot open region " + path);
+    struct stat st;
+    fstat(this->fd, &st);
+    this->fileSize = st.st_size;
+    this->entries.assign(size.x * size.y * size.z, (regionEntry_t){ 0, 0 });
+    char magic[4];
+    uint32_t fileGeneration = 0;
+    if (this->fileSize != 0 && (this->fileSize < regionHeaderSize || pread(this->fd, magic, sizeof(magic), 0) != sizeof(magic) || memcmp(magic, regionMagic, sizeof(magic)) != 0)) {
+        close(this->fd);
+        throw Exception::RuntimeError("invalid region " + path);
+    }
+    if (this->fileSize != 0 && (pread(this->fd, &fileGeneration, sizeof(uint32_t), sizeof(regionMagic)) != sizeof(uint32_t) || fileGeneration != generation)) {
+        this->outdated = true;
+        this->fileSize = 0;
+    }
+    if (this->fileSize == 0) { /* new region, or the chunks of another generation are dropped */
+        if (this->writeHeader(generation) == false) {
+            close(this->fd);
+            throw Exception::RuntimeError("cannot write region " + path);
+        }
+        return ;
+    }
+    if (pread(this->fd, this->entries.data(), this->entries.size() * sizeof(regionEntry_t), sizeof(regionMagic) + sizeof(uint32_t)) != static_cast<ssize_t>(this->entries.size() * sizeof(regionEntry_t))) {
+        close(this->fd);
+        throw Exception::RuntimeError("invalid region " + path);
+    }
+    this->compact(generation);
+}
+
+/*  Rewrite the region without the payloads replaced since they were written, when they are more than the
+    live ones. The live payloads are copied to a new file renamed over the region, on failure the region
+    stays as it is.
+*/
+void    Region::compact( uint32_t generation ) {
+    size_t live = 0;
+    for (const regionEntry_t& entry : this->entries)
+        live += entry.size;
+    if (this->fileSize - regionHeaderSize <= live * 2)
+        return ;
+    const std::string compactPath = this->path + ".tmp";
+    const int compactFd = open(compactPath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (compactFd == -1)
+        return ;
+    std::vector<regionEntry_t> compactEntries(this->entries.size(), (regionEntry_t){ 0, 0 });
+    std::vector<uint8_t> payload;
+    size_t offset = regionHeaderSize;
+    bool written = (pwrite(compactFd, regionMagic, sizeof(regionMagic), 0) == sizeof(regionMagic) &&
+                    pwrite(compactFd, &generation, sizeof(uint32_t), sizeof(regionMagic)) == sizeof(uint32_t));
+    for (size_t i = 0; i < this->entries.size() && written; ++i) {
+        const regionEntry_t& entry = this->entries[i];
+        if (entry.offset == 0 || static_cast<size_t>(entry.offset) + entry.size > this->fileSize)
+            continue;
+        payload.resize(entry.size);
+        written = (pread(this->fd, payload.data(), entry.size, entry.offset) == static_cast<ssize_t>(entry.size) &&
+                   pwrite(compactFd, payload.data(), entry.size, offset) == static_cast<ssize_t>(entry.size));
+        compactEntries[i] = (regionEntry_t){ static_cast<uint32_t>(offset), entry.size };
+        offset += entry.size;
+    }
+    const size_t tableSize = compactEntries.size() * sizeof(regionEntry_t);
+    written = written && pwrite(compactFd, compactEntries.data(), tableSize, sizeof(regionMagic) + sizeof(uint32_t)) == static_cast<ssize_t>(tableSize);
+    if (written == false || fsync(compactFd) == -1 || rename(compactPath.c_str(), this->path.c_str()) == -1) {
+        close(compactFd);
+        unlink(compactPath.c_str());
+        return ;
+    }
+    close(this->fd);
+    this->fd = compactFd;
+    this->fileSize = offset;
+    this->entries = compactEntries;
+}
+
+/* the magic, the generation and an empty offset table, the file is cut after them */
+const bool  Region::writeHeader( uint32_t generation ) {
+    const size_t tableSize = this->entries.size() * sizeof(regionEntry_t);
+    if (ftruncate(this->fd, 0) == -1 ||
+        pwrite(this->fd, regionMagic, sizeof(regionMagic), 0) != sizeof(regionMagic) ||
+        pwrite(this->fd, &generation, sizeof(uint32_t), sizeof(regionMagic)) != sizeof(uint32_t) ||
+        pwrite(this->fd, this->entries.data(), tableSize, sizeof(regionMagic) + sizeof(uint32_t)) != static_cast<ssize_t>(tableSize))
+        return false;
+    this->fileSize = regionHeaderSize;
+    return true;
+}
+
+Region::~Region( void ) {
+    if (this->mapped != nullptr)
+        munmap(this->mapped, this->mappedSize);
+    close(this->fd);
+}
+
+const int   Region::getEntryIndex( const glm::ivec3& local ) const {
+    return local.x + local.z * size.x + local.y * size.x * size.z;
+}
+
+/* the file is mapped again when it grew since the last mapping */
+void    Region::map( void ) {
+    if (this->mapped != nullptr && this->mappedSize == this->fileSize)
+        return ;
+    if (this->mapped != nullptr)
+        munmap(this->mapped, this->mappedSize);
+    void* ptr = mmap(nullptr, this->fileSize, PROT_READ, MAP_SHARED, this->fd, 0);
+    this->mapped = (ptr == MAP_FAILED ? nullptr : static_cast<uint8_t*>(ptr));
+    this->mappedSize = (ptr == MAP_FAILED ? 0 : this->fileSize);
+}
+
+const bool  Region::load( const glm::ivec3& local, std::vector<uint8_t>& data ) {
+    const regionEntry_t& entry = this->entries[this->getEntryIndex(local)];
+    if (entry.offset == 0)
+        return false;
+    this->map();
+    if (this->mapped == nullptr || static_cast<size_t>(entry.offset) + entry.size > this->mappedSize)
+        return false;
+    data.assign(this->mapped + entry.offset, this->mapped + entry.offset + entry.size);
+    return true;
+}
+
+/*  the payload is always appended and the entry only moves to it once written, a failed save keeps the
+    previous payload untouched (the replaced ones are reclaimed by compact)
+*/
+const bool  Region::save( const glm::ivec3& local, const std::vector<uint8_t>& data ) {
+    const int index = this->getEntryIndex(local);
+    const regionEntry_t entry = { static_cast<uint32_t>(this->fileSize), static_cast<uint32_t>(data.size()) };
+    if (pwrite(this->fd, data.data(), data.size(), entry.offset) != static_cast<ssize_t>(data.size()))
+        return false;
+    this->fileSize += data.size();
+    if (pwrite(this->fd, &entry, sizeof(regionEntry_t), sizeof(regionMagic) + sizeof(uint32_t) + index * sizeof(regionEntry_t)) != sizeof(regionEntry_t))
+        return false;
+    this->entries[index] = entry;
+    return true;
+}
+
+RegionStore::RegionStore( const std::string& directory, uint32_t generation, size_t maxOpenRegions ) : directory(directory), generation(generation), maxOpenRegions(maxOpenRegions), useCounter(0), enabled(true) {
+    this->stats = (regionStats_t){ 0, 0, 0, 0, 0, 0, 0, 0.0 };
+    /* create the directory and its parents */
+    for (size_t i = 1; i <= directory.size() && this->enabled; ++i)
+        if (i == directory.size() || directory[i] == '/')
+            if (mkdir(directory.substr(0, i).c_str(), 0755) == -1 && errno != EEXIST) {
+                std::cout << "> regions: cannot create " << directory << ", chunks will not be saved" << std::endl;
+                this->enabled = false;
+            }
+}
+
+RegionStore::~RegionStore( void ) {
+    for (auto it = this->regions.begin(); it != this->regions.end(); ++it)
+        delete it->second;
+    this->regions.clear();
+}
+
+/* return the region of a chunk (opened if needed, created only if `create`) and the chunk position in the region */
+Region*     RegionStore::getRegion( const glm::vec3& chunkPosition, glm::ivec3& local, bool create ) {
+    glm::ivec3 p = glm::ivec3(chunkPosition);
+    glm::ivec3 r = glm::ivec3(
+        static_cast<int>(std::floor(p.x / static_cast<float>(Region::size.x))),
+        static_cast<int>(std::floor(p.y / static_cast<float>(Region::size.y))),
+        static_cast<int>(std::floor(p.z / static_cast<float>(Region::size.z)))
+    );
+    local = p - r * Region::size;
+    uint64_t key = static_cast<uint64_t>(r.x + 0x7FFF) | (static_cast<uint64_t>(r.y + 0x7FFF) << 16) | (static_cast<uint64_t>(r.z + 0x7FFF) << 32);
+    auto it = this->regions.find(key);
+    if (it == this->regions.end()) {
+        std::string path = this->directory + "/r." + std::to_string(r.x) + "." + std::to_string(r.y) + "." + std::to_string(r.z) + ".vox";
+        if (!create && access(path.c_str(), F_OK) == -1)
+            return nullptr;
+        if (this->regions.size() >= this->maxOpenRegions) { /* close the least recently used region */
+            auto lru = std::min_element(this->regions.begin(), this->regions.end(), []( const std::pair<uint64_t, Region*>& a, const std::pair<uint64_t, Region*>& b ) {
+                return a.second->lastUse < b.second->lastUse;
+            });
+            delete lru->second;
+            this->regions.erase(lru);
+        }
+        try {
+            it = this->regions.insert({ key, new Region(path, this->generation) }).first;
+            this->stats.outdated += it->second->isOutdated();
+        } catch (const std::exception& err) {
+            std::cout << "> regions: " << err.what() << std::endl;
+            return nullptr;
+        }
+    }
+    it->second->lastUse = ++this->useCounter;
+    return it->second;
+}
+
+void    RegionStore::pack( const std::vector<uint8_t>& data, std::vector<uint8_t>& payload ) {
+    compress(data.data(), data.size(), payload);
+    uint32_t rawSize = static_cast<uint32_t>(data.size());
+    payload.insert(payload.begin(), reinterpret_cast<uint8_t*>(&rawSize), reinterpret_cast<uint8_t*>(&rawSize) + sizeof(uint32_t));
+}
+
+const bool  RegionStore::unpack( const uint8_t* payload, size_t size, std::vector<uint8_t>& data ) {
+    if (size < sizeof(uint32_t))
+        return false;
+    uint32_t rawSize;
+    memcpy(&rawSize, payload, sizeof(uint32_t));
+    data.resize(rawSize);
+    return decompress(payload + sizeof(uint32_t), size - sizeof(uint32_t), data.data(), rawSize);
+}
+
+/* load the serialized chunk, return false if it was never saved */
+const bool  RegionStore::load( const glm::vec3& chunkPosition, std::vector<uint8_t>& data ) {
+    glm::ivec3 local;
+    Region* region = (this->enabled ? this->getRegion(chunkPosition, local, false) : nullptr);
+    std::vector<uint8_t> payload;
+    if (region == nullptr || region->load(local, payload) == false || unpack(payload.data(), payload.size(), data) == false) {
+        this->stats.misses++;
+        return false;
+    }
+    this->stats.loaded++;
+    return true;
+}
+
+const bool  RegionStore::save( const glm::vec3& chunkPosition, const std::vector<uint8_t>& data ) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector<uint8_t> payload;
+    pack(data, payload);
+    const bool saved = this->savePayload(chunkPosition, payload);
+    this->stats.saveMs += (static_cast<std::chrono::duration<double,std::milli>>(std::chrono::steady_clock::now() - start)).count();
+    return saved;
+}
+
+/* write an already packed chunk */
+const bool  RegionStore::savePayload( const glm::vec3& chunkPosition, const std::vector<uint8_t>& payload ) {
+    glm::ivec3 local;
+    Region* region = (this->enabled ? this->getRegion(chunkPosition, local, true) : nullptr);
+    if (region == nullptr || payload.size() < sizeof(uint32_t) || region->save(local, payload) == false) {
+        this->stats.failed += this->enabled;
+        return false;
+    }
+    uint32_t rawSize;
+    memcpy(&rawSize, payload.data(), sizeof(uint32_t));
+    this->stats.saved++;
+    this->stats.rawBytes += rawSize;
+    this->stats.storedBytes += payload.size();
+    return true;
+}
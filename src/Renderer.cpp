@@ -6,6 +6,7 @@ env(env),
 camera(80, (float)env->getWindow().width / (float)env->getWindow().height, 0.1f, 300.0f) {
     this->shader["default"] = new Shader("./shader/vertex/default.vert.glsl", "./shader/geometry/default.geom.glsl", "./shader/fragment/default.frag.glsl");
     // this->shader["default"] = new Shader("./shader/vertex/defaultQuad.vert.glsl", "./shader/geometry/defaultQuad.geom.glsl", "./shader/fragment/default.frag.glsl");
+    this->shader["face"]    = new Shader("./shader/vertex/face.vert.glsl", "./shader/fragment/default.frag.glsl");
     this->shader["skybox"]  = new Shader("./shader/vertex/skybox.vert.glsl", "./shader/fragment/skybox.frag.glsl");
     this->shader["fxaa"]  = new Shader("./shader/vertex/screenQuad.vert.glsl", "./shader/fragment/FXAA.frag.glsl");
     this->lastTime = std::chrono::steady_clock::now();
@@ -23,32 +24,41 @@ Renderer::~Renderer( void ) {
 void	Renderer::loop( void ) {
     static int frames = 0;
     static double last = 0.0;
-    glEnable(GL_DEPTH_TEST); /* z-buffering */
-    glEnable(GL_FRAMEBUFFER_SRGB); /* gamma correction */
-    glEnable(GL_BLEND); /* transparency */
-    glEnable(GL_CULL_FACE); /* face culling (back faces are not rendered) */
+    GLState::enable(GL_DEPTH_TEST); /* z-buffering */
+    GLState::enable(GL_FRAMEBUFFER_SRGB); /* gamma correction */
+    GLState::enable(GL_BLEND); /* transparency */
+    GLState::enable(GL_CULL_FACE); /* face culling (back faces are not rendered) */
     glCullFace(GL_BACK);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     while (!glfwWindowShouldClose(this->env->getWindow().ptr)) {
         glfwPollEvents();
         this->env->getController()->update();
         this->camera.handleInputs(this->env->getController()->getKeys(), this->env->getController()->getMouse());
+        this->env->getTerrain()->setGenerationLattice(this->env->getController()->getKeyValue(GLFW_KEY_L));
+        this->env->getTerrain()->setLodMode(this->env->getController()->getKeyValue(GLFW_KEY_K));
+        this->env->getTerrain()->setCaveCulling(this->env->getController()->getKeyValue(GLFW_KEY_O));
+        this->env->getTerrain()->setOcclusionCulling(this->env->getController()->getKeyValue(GLFW_KEY_I));
+        this->env->getTerrain()->setHierarchicalCulling(this->env->getController()->getKeyValue(GLFW_KEY_J));
+        this->env->getTerrain()->setFrontToBack(this->env->getController()->getKeyValue(GLFW_KEY_B));
+        this->env->getTerrain()->setFaceRendering(this->env->getController()->getKeyValue(GLFW_KEY_V));
+        this->env->getTerrain()->setComputeMeshing(this->env->getController()->getKeyValue(GLFW_KEY_G));
+        this->env->getTerrain()->setDebugStats(this->env->getController()->getKeyValue(GLFW_KEY_H));
         timepoint_t lastTime = std::chrono::high_resolution_clock::now();
 
         if (this->fxaa) {
             /* two pass rendering (for FXAA) */
-            glBindFramebuffer(GL_FRAMEBUFFER, this->framebuffer.fbo);
+            GLState::bindFramebuffer(this->framebuffer.fbo);
             glClear(GL_DEPTH_BUFFER_BIT);
             this->renderLights();
             this->renderSkybox();
             this->renderMeshes();
-            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            GLState::bindFramebuffer(0);
             glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
             this->renderPostFxaa();
         }
         else {
             /* no post-processing */
-            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            GLState::bindFramebuffer(0);
             glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
             glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
             this->renderLights();
@@ -56,6 +66,7 @@ void	Renderer::loop( void ) {
             this->renderMeshes();
         }
         glfwSwapBuffers(this->env->getWindow().ptr);
+        GLState::endFrame();
         /* test, update the chunks after rendering */
         this->env->getTerrain()->updateChunks(this->camera.getPosition());
         // std::cout << (static_cast<milliseconds_t>(std::chrono::high_resolution_clock::now() - lastTime)).count() << std::endl;
@@ -77,20 +88,19 @@ void	Renderer::loop( void ) {
 }
 
 void    Renderer::renderLights( void ) {
-    /* update shader uniforms */
-    this->shader["default"]->use();
-    /* render lights for meshes */
-    for (auto it = this->env->getLights().begin(); it != this->env->getLights().end(); it++)
-        (*it)->render(*this->shader["default"]);
+    /* update shader uniforms of both chunk renderers */
+    for (const char* name : { "default", "face" }) {
+        this->shader[name]->use();
+        /* render lights for meshes */
+        for (auto it = this->env->getLights().begin(); it != this->env->getLights().end(); it++)
+            (*it)->render(*this->shader[name]);
+    }
 }
 
 void    Renderer::renderMeshes( void ) {
-    /* update shader uniforms */
-    this->shader["default"]->use();
-    this->shader["default"]->setVec3UniformValue("cameraPos", this->camera.getPosition());
-    this->shader["default"]->setVec3UniformValue("viewPos", this->camera.getPosition());
-
-    this->env->getTerrain()->renderChunks(*this->shader["default"], this->camera);
+    /* the chunks shader uniforms are set by the terrain (frame uniform block) */
+    Terrain* terrain = this->env->getTerrain();
+    terrain->renderChunks(*this->shader[terrain->isFaceRendering() ? "face" : "default"], this->camera);
 
     // static bool check = false;
     // if (!check) {
@@ -101,32 +111,32 @@ void    Renderer::renderMeshes( void ) {
 
 void    Renderer::renderSkybox( void ) {
     glDepthFunc(GL_LEQUAL);
-    glDisable(GL_CULL_FACE);
+    GLState::disable(GL_CULL_FACE);
     this->shader["skybox"]->use();
     this->shader["skybox"]->setMat4UniformValue("view", glm::mat4(glm::mat3(this->camera.getViewMatrix())));
     this->shader["skybox"]->setMat4UniformValue("projection", this->camera.getProjectionMatrix());
     /* render skybox */
     this->env->getSkybox()->render(*this->shader["skybox"]);
-    glEnable(GL_CULL_FACE);
+    GLState::enable(GL_CULL_FACE);
     glDepthFunc(GL_LESS);
 }
 
 void    Renderer::renderPostFxaa( void ) {
-    glDisable(GL_DEPTH_TEST);
+    GLState::disable(GL_DEPTH_TEST);
     this->shader["fxaa"]->use();
     this->shader["fxaa"]->setFloatUniformValue("near", this->camera.getNear());
     this->shader["fxaa"]->setVec2UniformValue("win_size", glm::vec2(this->env->getWindow().width, this->env->getWindow().height));
     this->env->getPostProcess()->render(*this->shader["fxaa"], this->framebuffer.id);
-    glEnable(GL_DEPTH_TEST);
+    GLState::enable(GL_DEPTH_TEST);
 }
 
 void    Renderer::initFramebuffer( void ) {
     /* create FBO (FrameBuffer Object) */
     glGenFramebuffers(1, &this->framebuffer.fbo);
-    glBindFramebuffer(GL_FRAMEBUFFER, this->framebuffer.fbo);
+    GLState::bindFramebuffer(this->framebuffer.fbo);
     /* create a texture */
     glGenTextures(1, &this->framebuffer.id);
-    glBindTexture(GL_TEXTURE_2D, this->framebuffer.id);
+    GLState::bindTexture(GL_TEXTURE_2D, this->framebuffer.id);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, env->getWindow().width, env->getWindow().height, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -144,5 +154,5 @@ void    Renderer::initFramebuffer( void ) {
         return;
     /* unbind FBO as safety */
     glBindRenderbuffer(GL_RENDERBUFFER, 0);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    GLState::bindTexture(GL_TEXTURE_2D, 0);
 }
\ No newline at end of file
@@ -20,11 +20,35 @@ Shader::Shader( const std::string& vertexShader, const std::string& geometryShad
     this->id = this->createProgram({{ vertShader, geomShader, fragShader }});
 }
 
+/* the `#pragma <name>` lines of the fragment shader are replaced by generated sources */
+Shader::Shader( const std::string& vertexShader, const std::string& fragmentShader, const std::unordered_map<std::string, std::string>& pragmas ) {
+    std::string vSrc = getFromFile(vertexShader);
+    std::string fSrc = getFromFile(fragmentShader);
+    this->insertPragmas(fSrc, pragmas);
+
+    GLuint vertShader = this->create(vSrc.c_str(), GL_VERTEX_SHADER);
+    GLuint fragShader = this->create(fSrc.c_str(), GL_FRAGMENT_SHADER);
+    this->id = this->createProgram({{ vertShader, fragShader }});
+}
+
+/* a compute program (GL 4.3), its `#pragma <name>` lines are replaced as for the fragment shader */
+Shader::Shader( const std::string& computeShader, const std::unordered_map<std::string, std::string>& pragmas ) {
+    std::string cSrc = getFromFile(computeShader);
+    this->insertPragmas(cSrc, pragmas);
+
+#ifdef GL_VERSION_4_3
+    GLuint compShader = this->create(cSrc.c_str(), GL_COMPUTE_SHADER);
+    this->id = this->createProgram({{ compShader }});
+#else
+    throw Exception::ShaderError(-1, "compute shaders are not loaded (GL 4.3)");
+#endif
+}
+
 Shader::~Shader( void ) {
 }
 
 void    Shader::use( void ) const {
-    glUseProgram(this->id);
+    GLState::useProgram(this->id);
 }
 
 /*  we load the content of a file in a string (we need that because the shader compilation is done at
@@ -36,6 +60,25 @@ std::string   Shader::getFromFile( const std::string& filename ) {
     return (content);
 }
 
+/* an inserted source can have pragmas too, the lines are replaced until none is left */
+void    Shader::insertPragmas( std::string& source, const std::unordered_map<std::string, std::string>& pragmas ) {
+    std::unordered_map<std::string, bool> inserted;
+    for (bool replaced = true; replaced == true; ) {
+        replaced = false;
+        for (auto it = pragmas.begin(); it != pragmas.end(); ++it) {
+            std::string line = "#pragma " + it->first + "\n";
+            size_t pos = source.find(line);
+            if (pos == std::string::npos)
+                continue;
+            source.replace(pos, line.size(), it->second);
+            inserted[it->first] = replaced = true;
+        }
+    }
+    for (auto it = pragmas.begin(); it != pragmas.end(); ++it)
+        if (inserted.find(it->first) == inserted.end())
+            throw Exception::ShaderError(GL_FRAGMENT_SHADER, "missing #pragma " + it->first + "\n");
+}
+
 /*  we create the shader from a file in format glsl. The shaderType defines what type of shader it is
     and it returns the id to the created shader (the shader object is allocated by OpenGL in the back)
 */
@@ -91,6 +134,12 @@ unsigned int    Shader::getUniformLocation( const std::string& name ) {
     return (newLoc);
 }
 
+void    Shader::bindUniformBlock( const std::string& name, GLuint binding ) {
+    GLuint index = glGetUniformBlockIndex(this->id, name.c_str());
+    if (index != GL_INVALID_INDEX)
+        glUniformBlockBinding(this->id, index, binding);
+}
+
 void    Shader::setIntUniformValue( const std::string& name, const int i ) {
     glUniform1i(getUniformLocation(name), i);
 }
@@ -115,3 +164,25 @@ void    Shader::setVec3UniformValue( const std::string& name, const glm::vec3& v
 void    Shader::setVec4UniformValue( const std::string& name, const glm::vec4& v ) {
     glUniform4fv(getUniformLocation(name), 1, glm::value_ptr(v));
 }
+void    Shader::setIvec2UniformValue( const std::string& name, const glm::ivec2& v ) {
+    glUniform2iv(getUniformLocation(name), 1, glm::value_ptr(v));
+}
+void    Shader::setIvec3UniformValue( const std::string& name, const glm::ivec3& v ) {
+    glUniform3iv(getUniformLocation(name), 1, glm::value_ptr(v));
+}
+
+template <> void    Uniform<int>::set( const int& value ) const {
+    glUniform1i(this->location, value);
+}
+template <> void    Uniform<float>::set( const float& value ) const {
+    glUniform1f(this->location, value);
+}
+template <> void    Uniform<glm::vec3>::set( const glm::vec3& value ) const {
+    glUniform3fv(this->location, 1, glm::value_ptr(value));
+}
+template <> void    Uniform<glm::vec4>::set( const glm::vec4& value ) const {
+    glUniform4fv(this->location, 1, glm::value_ptr(value));
+}
+template <> void    Uniform<glm::mat4>::set( const glm::mat4& value ) const {
+    glUniformMatrix4fv(this->location, 1, GL_FALSE, glm::value_ptr(value));
+}
@@ -1,14 +1,69 @@
 #include "Terrain.hpp"
 #include "glm/ext.hpp"
 
-Terrain::Terrain( uint renderDistance, uint maxHeight ) : renderDistance(renderDistance), maxHeight(maxHeight) {
+Terrain::Terrain( uint renderDistance, uint maxHeight, uint32_t seed, size_t memoryBudget ) : renderDistance(renderDistance), maxHeight(maxHeight) {
     this->chunkSize = glm::ivec3(32);
     this->dataMargin = 4; // even though we only need a margin of 2, openGL does not like this number and gl_FragCoord values will be messed up...
     this->maxAllocatedTimePerFrame = 24.0;//ms
+    this->stats = (chunkStats_t){ 0, 0, 0, 0, 0, 0, 0, 0.0, 0.0, 0 };
     this->setupChunkGenerationRenderingQuad();
     this->setupChunkGenerationFbo();
-    this->chunkGenerationShader = new Shader("./shader/vertex/screenQuad.vert.glsl", "./shader/fragment/generateChunk.frag.glsl");
-    this->noiseSampler = loadTexture("./resource/RGBAnoiseMedium.png");
+    this->setupLatticeFbo();
+    this->setupColumnFbo();
+    this->setGenerationLattice(0);
+    this->latticeReport = (latticeReport_t){ 0, 0, 0, 0, 0.0, 0.0 };
+    this->latticeReportInterval = 8;
+    this->worldGen = new WorldGen(WorldGen::defaultRules(), seed);
+    this->worldGenReport = (worldGenReport_t){ 0, 0, 0, 0.0 };
+    this->worldGenReportInterval = 64;
+    this->regionStore = new RegionStore("./save/world-" + std::to_string(seed), this->worldGen->getGeneration());
+    this->cacheMaxBytes = 64 << 20;
+    this->cacheMaxEntries = 8192;
+    this->chunkCache = new ChunkCache(this->regionStore, this->cacheMaxBytes, this->cacheMaxEntries);
+    this->governor = new MemoryGovernor(memoryBudget, renderDistance, 64, this->chunkSize.x);
+    this->lodDistance = 96.0f;
+    this->lodHysteresis = 8.0f;
+    this->lodStats = (lodStats_t){ { 0, 0, 0 }, { 0, 0, 0 }, 0 };
+    this->setLodMode(2);
+    this->caveCulling = true;
+    this->cullingStats[0] = this->cullingStats[1] = (cullingStats_t){ 0, 0, 0, 0, 0 };
+    this->occlusionBuffer = new OcclusionBuffer(256, 128, std::max(1u, std::min(4u, std::thread::hardware_concurrency())));
+    this->occlusionCulling = true;
+    this->occluderDistance = 160.0f;
+    this->maxOccluders = 256;
+    this->occlusionStats = (occlusionStats_t){ 0, 0, 0, 0, 0, 0, 0.0 };
+    this->fustrumStats = (fustrumStats_t){ { 0, 0 }, { 0, 0 }, { 0.0, 0.0 }, 0 };
+    this->columnTree = new ColumnTree(this->chunkSize, this->maxHeight / this->chunkSize.y, 6);
+    this->hierarchicalCulling = true;
+    this->renderFrame = 0;
+    this->frontToBack = true;
+    this->debugStats = false;
+    this->statsInterval = 1000.0;
+    this->lastStatsPrint = std::chrono::high_resolution_clock::now();
+    this->renderStats = (renderStats_t){ 0, 0.0, 0, 0, 0, 0, 0, 0, 0.0, 0, 0.0, 0, 0, 0, 0.0, 0 };
+    this->renderQueryFaces[0] = this->renderQueryFaces[1] = false;
+    this->faceRendering = false;
+    glGenQueries(6, &this->renderQueries[0][0]);
+    glGenBuffers(1, &this->frameUniformBuffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, this->frameUniformBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(frameUniforms_t), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    this->chunkUniforms.program = 0;
+    const std::unordered_map<std::string, std::string> generationPragmas = {
+        { "worldgen", Shader::getFromFile("./shader/common/worldgen.glsl") },
+        { "worldgen_rules", this->worldGen->getGlslSource() }
+    };
+    this->chunkGenerationShader = new Shader("./shader/vertex/screenQuad.vert.glsl", "./shader/fragment/generateChunk.frag.glsl", generationPragmas);
+    /* the rendering context is the current one, the streaming context shares its objects (with or without compute shaders) */
+    this->streamer = new ChunkStreamer(glfwGetCurrentContext(), this->chunkSize, this->dataMargin, static_cast<int>(seed), generationPragmas);
+    if (this->streamer != nullptr && this->streamer->isRunning() == false)
+        this->stopStreaming();
+    this->computeGenerator = (ComputeGenerator::isSupported() && this->streamer == nullptr ? new ComputeGenerator(this->chunkSize, this->dataMargin, generationPragmas) : nullptr);
+    this->uploadRing = new UploadRing(8 << 20);
+    Chunk::setUploadRing(this->uploadRing);
+    this->computeMesher = (ComputeGenerator::isSupported() ? new ComputeMesher(this->chunkSize, this->dataMargin, this->uploadRing) : nullptr);
+    this->setComputeMeshing(false);
+    this->horizon = new Horizon(3, 64, 8.0f, 4096);
     this->textureAtlas = loadTextureMipmapSrgb(std::vector<std::string>{{
         "./resource/terrain.png",
         "./resource/terrain-1.png",
@@ -17,22 +72,44 @@ Terrain::Terrain( uint renderDistance, uint maxHeight ) : renderDistance(renderD
         "./resource/terrain-4.png"
     }});
     this->dataBuffer = static_cast<uint8_t*>(malloc(sizeof(uint8_t) * this->chunkGenerationFbo.width * this->chunkGenerationFbo.height));
+    this->referenceBuffer = static_cast<uint8_t*>(malloc(sizeof(uint8_t) * this->chunkGenerationFbo.width * this->chunkGenerationFbo.height));
 }
 
 Terrain::~Terrain( void ) {
+    /* save the chunks still in memory */
+    for (auto it = this->chunks.begin(); it != this->chunks.end(); ++it)
+        this->saveChunk(it->first.p, it->second);
+    delete this->chunkCache; /* saves the modified cached chunks */
+    delete this->regionStore;
     /* clean framebuffers */
-    glDeleteFramebuffers(1, &this->chunkGenerationFbo.fbo);
+    GLState::deleteFramebuffers(1, &this->chunkGenerationFbo.fbo);
+    GLState::deleteFramebuffers(1, &this->lattice.fbo);
+    GLState::deleteFramebuffers(1, &this->columnFbo.fbo);
     /* clean textures */
-    glDeleteTextures(1, &this->noiseSampler);
-    glDeleteTextures(1, &this->textureAtlas);
-    glDeleteTextures(1, &this->chunkGenerationFbo.id);
+    GLState::deleteTextures(1, &this->textureAtlas);
+    GLState::deleteTextures(1, &this->chunkGenerationFbo.id);
+    GLState::deleteTextures(2, this->lattice.fields);
+    GLState::deleteTextures(1, &this->columnFbo.id);
     /* clean buffers */
-    glDeleteVertexArrays(1, &this->chunkGenerationRenderingQuad.vao);
+    GLState::deleteVertexArrays(1, &this->chunkGenerationRenderingQuad.vao);
     glDeleteBuffers(1, &this->chunkGenerationRenderingQuad.vbo);
     glDeleteBuffers(1, &this->chunkGenerationRenderingQuad.ebo);
     delete this->chunkGenerationShader;
+    delete this->streamer;
+    delete this->computeGenerator;
+    delete this->computeMesher;
+    delete this->uploadRing;
+    delete this->worldGen;
+    delete this->governor;
+    delete this->horizon;
+    delete this->occlusionBuffer;
+    delete this->columnTree;
+    glDeleteQueries(6, &this->renderQueries[0][0]);
+    glDeleteBuffers(1, &this->frameUniformBuffer);
     free(this->dataBuffer);
     this->dataBuffer = nullptr;
+    free(this->referenceBuffer);
+    this->referenceBuffer = nullptr;
 }
 
 const std::array<glm::vec3, 6> neighboursOffsets = {
@@ -74,7 +151,7 @@ const std::array<Chunk*, 6>   Terrain::getNeighbouringChunks( const glm::vec3& p
      - - - -+---+- - - -  */
 void    Terrain::addChunksToGenerationList( const glm::vec3& cameraPosition ) {
     int height = this->maxHeight / this->chunkSize.y;
-    glm::ivec3 dist = glm::ivec3(this->renderDistance) / this->chunkSize + 3;
+    glm::ivec3 dist = glm::ivec3(this->governor->getRenderDistance()) / this->chunkSize + 3;
     const float e = 0.01;
 
     for (int y = height-1; y >= 0; y--) {
@@ -87,7 +164,7 @@ void    Terrain::addChunksToGenerationList( const glm::vec3& cameraPosition ) {
                 glm::vec3 p = glm::vec3(std::abs(std::round(x_triangleWave))-d, y, std::abs(std::round(z_triangleWave))-d);
 
                 ckey_t key = { this->getChunkPosition(cameraPosition) * glm::vec3(1, 0, 1) + p };
-                if (this->chunks.find(key) == this->chunks.end() && this->chunksToLoadSet.find(key) == this->chunksToLoadSet.end()) { /* if chunk was never generated */
+                if (this->chunks.find(key) == this->chunks.end() && this->chunksToLoadSet.find(key) == this->chunksToLoadSet.end() && this->streamingSet.find(key) == this->streamingSet.end()) { /* if chunk was never generated */
                     this->chunksToLoadQueue.push(key);
                     this->chunksToLoadSet.insert(key);
                 }
@@ -98,7 +175,11 @@ void    Terrain::addChunksToGenerationList( const glm::vec3& cameraPosition ) {
 
 void    Terrain::updateChunks( const glm::vec3& cameraPosition ) {
     tTimePoint lastTime = std::chrono::high_resolution_clock::now();
+    /* the uploads of the last frame (its updates and its draws) are fenced */
+    this->uploadRing->endFrame();
     this->addChunksToGenerationList(cameraPosition);
+    /* before the updates, so that the new chunks are meshed at their level */
+    this->updateChunkLods(cameraPosition);
 
     /* update light/water of chunk and neighbours */
     while (chunksToUpdateQueue.empty() == false) {
@@ -106,11 +187,14 @@ void    Terrain::updateChunks( const glm::vec3& cameraPosition ) {
         this->chunksToUpdateQueue.pop();
         std::array<Chunk*, 6> neighbours = this->getNeighbouringChunks(elem.chunk);
         ckey_t key = { elem.chunk };
+        if (this->chunks.find(key) == this->chunks.end()) /* evicted since */
+            continue;
         if (elem.action == updateType::water)
             this->chunks.at(key)->computeWater(neighbours);
         if (elem.action == updateType::light)
             this->chunks.at(key)->computeLight(neighbours, (neighbours[2] != nullptr ? neighbours[2]->getLightMask() : nullptr) );
-        this->chunks.at(key)->rebuildMesh();
+        this->chunks.at(key)->rebuildMesh(neighbours);
+        this->columnTree->markChunk(key.p);
 
         for (int i = 0; i < 6; i++) {
             if (neighbours[i] != nullptr && elem.chunk + neighboursOffsets[i] != elem.from) {
@@ -125,6 +209,10 @@ void    Terrain::updateChunks( const glm::vec3& cameraPosition ) {
             break;
     }
 
+    /* the chunks generated by the streaming thread since the last frame */
+    if (this->streamer != nullptr)
+        this->receiveStreamedChunks(cameraPosition, lastTime);
+
     /* generate chunks */
     while (chunksToLoadQueue.empty() == false) {
         ckey_t key = this->chunksToLoadQueue.front();
@@ -133,72 +221,565 @@ void    Terrain::updateChunks( const glm::vec3& cameraPosition ) {
         this->chunksToLoadSet.erase(key);
         /* check if element to load is still in range */
         float distHorizontal = glm::distance(key.p * glm::vec3(1,0,1),  this->getChunkPosition(cameraPosition) * glm::vec3(1,0,1));
-        if (distHorizontal > (renderDistance / chunkSize.x))
+        if (distHorizontal > (this->governor->getRenderDistance() / chunkSize.x))
             continue;
-        /* generate terrain and create chunk */
+        /* load the chunk if it was saved, or generate terrain and create chunk */
         glm::vec3 position = key.p * (glm::vec3)this->chunkSize;
-        this->renderChunkGeneration(position);
-        this->chunks.insert( { key, new Chunk(position, this->chunkSize, this->dataBuffer, this->dataMargin) } );
-        /* issue update to light and water */
-        this->chunksToUpdateQueue.push({ key.p, key.p, updateType::water });
-        this->chunksToUpdateQueue.push({ key.p, key.p, updateType::light });
+        tTimePoint start = std::chrono::high_resolution_clock::now();
+        Chunk* loaded = this->loadChunk(key.p);
+        this->stats.loadMs += (static_cast<tMilliseconds>(std::chrono::high_resolution_clock::now() - start)).count();
+        if (loaded != nullptr)
+            this->insertChunk(key, loaded);
+        else {
+            start = std::chrono::high_resolution_clock::now();
+            const double cpuKernelMs = this->worldGenReport.cpuMs; /* not part of the generation time */
+            if (this->lattice.mode == 0 && this->isChunkAboveColumn(this->getColumn(key.p), position)) { /* only air, no need to generate it (the lattice terrain is not the column one) */
+                this->stats.columnSkipped++;
+                this->insertChunk(key, this->createGeneratedChunk(position, nullptr));
+            }
+            else if (this->streamer != nullptr && this->lattice.mode == 0) { /* generated by the streaming thread */
+                if (this->streamer->request(key.p, this->getColumn(key.p).fields) == false) { /* the thread is behind, asked again next frame */
+                    this->chunksToLoadQueue.push(key);
+                    this->chunksToLoadSet.insert(key);
+                    break;
+                }
+                this->streamingSet.insert(key);
+            }
+            else if (this->computeGenerator != nullptr && this->lattice.mode == 0) { /* generated with the batch */
+                this->computeGenerator->add(position, this->getColumn(key.p).fields);
+                this->generationBatch.push_back(key);
+            }
+            else {
+                if (this->lattice.mode != 0 && this->stats.generated % this->latticeReportInterval == 0)
+                    this->compareLatticeGeneration(position);
+                else
+                    this->renderChunkGeneration(position);
+                Chunk* chunk = this->createGeneratedChunk(position, this->dataBuffer);
+                chunk->setApproximate(this->lattice.mode != 0);
+                this->insertChunk(key, chunk);
+            }
+            this->stats.generateMs += (static_cast<tMilliseconds>(std::chrono::high_resolution_clock::now() - start)).count() - (this->worldGenReport.cpuMs - cpuKernelMs);
+            if (this->computeGenerator != nullptr && this->computeGenerator->isFull())
+                this->generateBatch();
+        }
 
         double delta = (static_cast<tMilliseconds>(std::chrono::high_resolution_clock::now() - lastTime)).count();
         if (delta > this->maxAllocatedTimePerFrame)
             break;
     }
+    this->generateBatch();
+    if (this->computeMesher != nullptr) /* the meshes which did not fit the arena are redone with the lod updates */
+        this->computeMesher->update();
     // std::cout << (static_cast<tMilliseconds>(std::chrono::high_resolution_clock::now() - lastTime)).count() << std::endl;
 
-    /* Debug list sizes */
-    std::cout << ">   chunks: " << chunks.size() << "\n" << "    update: " << chunksToUpdateQueue.size() << "\n" << \
-    "load queue: " << chunksToLoadQueue.size() << "\n" << "  load set: " << chunksToLoadSet.size() << "\n" << std::endl;
+    this->updateHorizon(cameraPosition);
+
+    if (this->debugStats && (static_cast<tMilliseconds>(lastTime - this->lastStatsPrint)).count() >= this->statsInterval) {
+        this->printStats();
+        this->lastStatsPrint = lastTime;
+    }
 
-    this->deleteOutOfRangeChunks();
+    this->deleteOutOfRangeChunks(cameraPosition);
+    this->governMemory(cameraPosition);
+}
+
+/* the sizes of the lists and the stats of the subsystems, every statsInterval when the debug stats are on (H key) */
+void    Terrain::printStats( void ) const {
+    std::cout << ">   chunks: " << chunks.size() << "\n" << "    update: " << chunksToUpdateQueue.size() << "\n" << \
+    "load queue: " << chunksToLoadQueue.size() << "\n" << "  load set: " << chunksToLoadSet.size() << "\n" << \
+    "   uniform: " << stats.uniformAir << " air, " << stats.uniformSolid << " solid / " << stats.generated << " generated (" << Chunk::materializedCount << " materialized)\n" << \
+    "   columns: " << columns.size() << " cached, " << stats.columns << " evaluated, " << stats.columnSkipped << " chunks skipped\n";
+    if (this->streamer != nullptr) {
+        const streamerStats_t ss = this->streamer->getStats();
+        std::cout << "generation: streaming thread (" << (ss.compute ? "compute" : "fragment") << " shader), " << ss.received << "/" << ss.requested << " chunks received (" << this->streamingSet.size() << " in flight, " << \
+        this->stats.dropped << " dropped) in " << ss.batches << " batches (" << (ss.batches > 0 ? static_cast<double>(ss.received) / ss.batches : 0.0) << " per batch, " << \
+        (ss.batches > 0 ? ss.batchMs / ss.batches : 0.0) << "ms each, " << (ss.batches > 0 ? ss.waitMs / ss.batches : 0.0) << "ms fence wait), " << \
+        (stats.generated - (ss.received - stats.dropped) - stats.columnSkipped) << " by the fragment shader (lattice)\n";
+    }
+    else if (this->computeGenerator != nullptr) {
+        const computeGeneratorStats_t& gs = this->computeGenerator->getStats();
+        std::cout << "generation: compute shader, " << gs.chunks << " chunks in " << gs.batches << " batches (" << \
+        (gs.batches > 0 ? static_cast<double>(gs.chunks) / gs.batches : 0.0) << " per batch), " << (stats.generated - gs.chunks - stats.columnSkipped) << " by the fragment shader (lattice)\n";
+    }
+    else
+        std::cout << "generation: fragment shader (no compute shaders)\n";
+    for (auto it = Pool::getPools().begin(); it != Pool::getPools().end(); ++it) {
+        const poolStats_t& ps = it->second.getStats();
+        std::cout << "      pool: " << it->first << "B, " << ps.used << "/" << ps.capacity << " blocks in " << ps.slabs << " slabs (" << ps.hugeSlabs << " huge, " << \
+        ((ps.slabs * it->second.getSlabSize()) >> 10) << "KB), " << ps.allocations << " allocations, " << 100.0f * it->second.getFragmentation() << "% free\n";
+    }
+    const cacheStats_t& cs = this->chunkCache->getStats();
+    std::cout << "     cache: " << this->chunkCache->getEntries() << "/" << this->chunkCache->getMaxEntries() << " chunks, " << \
+    (this->chunkCache->getBytes() >> 10) << "/" << (this->chunkCache->getMaxBytes() >> 10) << "KB, " << \
+    (cs.hits + cs.misses > 0 ? 100.0 * cs.hits / (cs.hits + cs.misses) : 0.0) << "% hits (" << cs.hits << "/" << (cs.hits + cs.misses) << "), " << \
+    cs.dropped << " dropped (" << cs.written << " written)\n";
+    if (this->regionStore->isEnabled()) {
+        const regionStats_t& rs = this->regionStore->getStats();
+        const uint64_t lookups = cs.hits + rs.loaded + rs.misses;
+        std::cout << "   regions: " << this->regionStore->getOpenRegions() << " open, " << \
+        rs.loaded << " loaded (" << (lookups > 0 ? this->stats.loadMs / lookups : 0.0) << "ms/lookup) vs " << \
+        this->stats.generated << " generated (" << (this->stats.generated > 0 ? this->stats.generateMs / this->stats.generated : 0.0) << "ms/chunk), " << \
+        rs.saved << " saved (" << (rs.saved > 0 ? rs.saveMs / rs.saved : 0.0) << "ms/chunk, " << (rs.storedBytes > 0 ? (double)rs.rawBytes / rs.storedBytes : 0.0) << ":1), " << \
+        rs.failed << " failed, " << rs.outdated << " outdated regions\n";
+    }
+    if (this->worldGenReport.chunks > 0) {
+        const worldGenStats_t& wg = this->worldGen->getStats();
+        std::cout << "  worldgen: seed " << this->worldGen->getSeed() << ", " << this->worldGen->getRulesCount() << " rules, " << (float)wg.fields / wg.voxels << " fields/voxel (eager " << this->worldGen->getFieldsCount() << "), cpu kernel: " << \
+        this->worldGenReport.mismatches << "/" << this->worldGenReport.voxels << " mismatches, " << this->worldGenReport.cpuMs / this->worldGenReport.voxels * 1000.0 << "us/voxel\n";
+    }
+    if (this->lattice.mode != 0 && this->latticeReport.chunks > 0)
+        std::cout << "   lattice: " << this->lattice.step.x << "x" << this->lattice.step.y << "x" << this->lattice.step.z << ", " << \
+        (100.0 * (this->latticeReport.flips + this->latticeReport.materials) / this->latticeReport.voxels) << "% voxels differ (" << \
+        this->latticeReport.flips << " air/solid, " << this->latticeReport.materials << " bloc) over " << this->latticeReport.chunks << " chunks, " << \
+        (this->latticeReport.latticeMs / this->latticeReport.chunks) << "ms vs " << (this->latticeReport.fullMs / this->latticeReport.chunks) << "ms full\n";
+    const memoryUsage_t mu = this->getMemoryUsage();
+    const governorStats_t& gs = this->governor->getStats();
+    std::cout << "    memory: " << ((MemoryGovernor::getResident(mu) + mu.cache) >> 20) << "/" << (this->governor->getBudget() >> 20) << "MB (voxels " << (mu.voxels >> 20) << \
+    ", light " << (mu.light >> 20) << ", cpu meshes " << (mu.cpuMeshes >> 20) << ", gpu buffers " << (mu.gpuBuffers >> 20) << ", cache " << (mu.cache >> 20) << "), render distance " << \
+    this->governor->getRenderDistance() << "/" << this->governor->getMaxRenderDistance() << ", " << gs.evicted << " evicted, " << gs.shrinks << " shrinks, " << gs.grows << " grows\n";
+    uint64_t drawnPoints = 0;
+    std::cout << "       lod: mode " << this->lodMode << " (from " << this->lodDistance << " blocs), drawn";
+    for (int l = 0; l < Chunk::lodLevels; ++l) {
+        std::cout << " " << (1 << l) << "x: " << this->lodStats.chunks[l] << " chunks/" << this->lodStats.points[l] << " points,";
+        drawnPoints += this->lodStats.points[l];
+    }
+    std::cout << " total " << drawnPoints << " points (" << ((drawnPoints * sizeof(point_t)) >> 10) << "KB), " << this->lodStats.switches << " switches\n";
+    std::cout << "   culling: " << (this->caveCulling ? "on" : "off");
+    for (int c = 0; c < 2; ++c) {
+        const cullingStats_t& cs = this->cullingStats[c];
+        const uint64_t frames = std::max(cs.frames, static_cast<uint64_t>(1));
+        std::cout << (c == 0 ? ", open terrain: " : ", caves: ") << cs.frames << " frames, " << \
+        (cs.drawCalls + cs.culledDrawCalls) / frames << " -> " << cs.drawCalls / frames << " draw calls, " << \
+        (cs.points + cs.culledPoints) / frames << " -> " << cs.points / frames << " points per frame (" << \
+        (cs.points + cs.culledPoints > 0 ? 100.0 * cs.culledPoints / (cs.points + cs.culledPoints) : 0.0) << "% saved)";
+    }
+    std::cout << "\n";
+    const fustrumStats_t& fs = this->fustrumStats;
+    const columnTreeStats_t& ts = this->columnTree->getStats();
+    const uint64_t treeFrames = std::max(ts.frames, static_cast<uint64_t>(1));
+    std::cout << "   fustrum: " << (this->hierarchicalCulling ? "hierarchical" : "flat");
+    for (int m = 0; m < 2; ++m) {
+        const uint64_t frames = std::max(fs.frames[m], static_cast<uint64_t>(1));
+        std::cout << (m == 0 ? ", flat: " : ", hierarchical: ") << fs.visible[m] / frames << " chunks in view, " << fs.cullMs[m] / frames * 1000.0 << "us per frame";
+    }
+    std::cout << " (" << fs.tested / std::max(fs.frames[0], static_cast<uint64_t>(1)) << " bounds vs " << ts.nodes / treeFrames << " nodes and " << ts.chunks / treeFrames << " chunks tested, " << \
+    this->columnTree->getNodesCount() << " nodes, " << ts.refreshed / treeFrames << " refreshed per frame)\n";
+    const renderStats_t& rs = this->renderStats;
+    const uint64_t renderFrames = std::max(rs.frames, static_cast<uint64_t>(1));
+    const double pixels = static_cast<double>(std::max(rs.pixels, static_cast<uint64_t>(1)));
+    std::cout << "    passes: opaque " << (this->frontToBack ? "front to back" : "back to front") << ", " << this->renderList.size() << " chunks listed, " << this->drawList.size() << " drawn, sort " << \
+    rs.sortMs / renderFrames * 1000.0 << "us per frame (" << rs.fullSorts << " full sorts, " << rs.moves / renderFrames << " moves per frame), overdraw " << \
+    rs.opaqueSamples / pixels << " opaque and " << rs.transparentSamples / pixels << " water samples per pixel, opaque pass " << \
+    (rs.queries > rs.faceQueries ? (rs.opaqueGpuMs - rs.faceGpuMs) / (rs.queries - rs.faceQueries) : 0.0) << "ms on the gpu with the points, " << \
+    (rs.faceQueries > 0 ? rs.faceGpuMs / rs.faceQueries : 0.0) << "ms with the faces (" << (this->isFaceRendering() ? "faces" : "points") << " drawn), submission " << rs.submitMs / renderFrames * 1000.0 << "us per frame (" << \
+    (rs.draws > 0 ? rs.submitMs * 1000000.0 / rs.draws : 0.0) << "ns per draw)\n";
+    const uint64_t faceFrames = std::max(rs.faceFrames, static_cast<uint64_t>(1));
+    std::cout << "     faces: " << rs.submittedFaces / faceFrames << " of " << rs.faces / faceFrames << \
+    " submitted per frame, " << (rs.faces > 0 ? 100.0 * (rs.faces - rs.submittedFaces) / rs.faces : 0.0) << "% turned away from the camera\n";
+    if (this->computeMesher != nullptr) {
+        const computeMesherStats_t& ms = this->computeMesher->getStats();
+        std::cout << "   meshing: " << (this->computeMeshing ? "compute shader" : "cpu") << ", " << Chunk::computeMeshedCount << " chunks drawn from the gpu meshes (" << \
+        ms.meshes << " meshes, " << ms.failures << " failed), arena " << this->computeMesher->getArenaUsed() << "/" << this->computeMesher->getArenaSize() << " faces (" << \
+        ms.relocations << " relocations, " << ms.grows << " grows, " << ms.reclaimed << " faces reclaimed), " << ms.draws / renderFrames << " indirect draws per frame\n";
+    }
+    else
+        std::cout << "   meshing: cpu (no compute shaders)\n";
+    const uploadRingStats_t& us = this->uploadRing->getStats();
+    std::cout << "   uploads: " << (this->uploadRing->isPersistent() ? "persistent ring " : "driver copies (no buffer storage), ring ") << (this->uploadRing->getSize() >> 20) << "MB, " << \
+    (us.lastFrameBytes >> 10) << "KB last frame, " << (us.bytes >> 10) / std::max(us.frames, static_cast<uint64_t>(1)) << "KB per frame, " << us.uploads << " uploads (" << \
+    us.staged << " by the driver), " << us.stalls << " stalls (" << us.stallMs << "ms)\n";
+    const glStateStats_t& gls = GLState::getStats();
+    const uint64_t glFrames = std::max(gls.frames, static_cast<uint64_t>(1));
+    std::cout << "  gl state: " << gls.issued / glFrames << " calls issued, " << gls.elided / glFrames << " elided per frame (" << \
+    (gls.issued + gls.elided > 0 ? 100.0 * gls.elided / (gls.issued + gls.elided) : 0.0) << "% redundant)\n";
+    const occlusionStats_t& os = this->occlusionStats;
+    const uint64_t occlusionFrames = std::max(os.frames, static_cast<uint64_t>(1));
+    std::cout << " occlusion: " << (this->occlusionCulling ? "on" : "off") << ", " << this->occlusionBuffer->getWidth() << "x" << this->occlusionBuffer->getHeight() << ", " << \
+    os.occluders / occlusionFrames << " occluders (" << os.triangles / occlusionFrames << " triangles) in " << os.rasterizeMs / occlusionFrames << "ms per frame, " << \
+    os.culled << "/" << os.tested << " chunks hidden (" << (os.tested > 0 ? 100.0 * os.culled / os.tested : 0.0) << "%), " << os.culledPoints / occlusionFrames << " points per frame saved\n";
+    const horizonStats_t& hs = this->horizon->getStats();
+    std::cout << "   horizon: " << this->horizon->getLevelsCount() << " levels of " << this->horizon->getSize() << "x" << this->horizon->getSize() << " samples, from " << \
+    this->governor->getRenderDistance() << " to " << this->horizon->getExtent() << " blocs, " << hs.samples << " samples evaluated (" << hs.moves << " moves, " << hs.deferred << " deferred)\n";
+    std::cout << std::endl;
 }
 
-void    Terrain::deleteOutOfRangeChunks( void ) {
+void    Terrain::deleteOutOfRangeChunks( const glm::vec3& cameraPosition ) {
     std::forward_list<ckey_t> toDelete;
     int num = 0;
+    const float limit = this->governor->getRenderDistance() * 3.0f;
     for (auto it = this->chunks.begin(); it != this->chunks.end(); ++it)
-        if (it->second->isOutOfRange() == true) {
+        if (it->second->isOutOfRange() == true || glm::distance(it->second->getPosition() * glm::vec3(1,0,1), cameraPosition * glm::vec3(1,0,1)) > limit) {
             toDelete.push_front(it->first);
             num++;
         }
-    for (auto it = toDelete.begin(); it != toDelete.end(); ++it) {
-        delete this->chunks.at(*it);
-        this->chunks.erase(*it);
-    }
+    for (auto it = toDelete.begin(); it != toDelete.end(); ++it)
+        this->evictChunk(*it);
     toDelete.clear();
+    if (num > 0)
+        this->deleteUnusedColumns();
+}
+
+/* move a chunk from the resident chunks to the chunk cache */
+void    Terrain::evictChunk( const ckey_t& key ) {
+    Chunk* chunk = this->chunks.at(key);
+    this->cacheChunk(key.p, chunk);
+    this->evictedChunks.insert(chunk);
+    delete chunk;
+    this->chunks.erase(key);
+    this->removeChunkBounds(key);
+}
+
+void    Terrain::addChunkBounds( const ckey_t& key, Chunk* chunk ) {
+    const glm::vec3 center = chunk->getPosition() + glm::vec3(this->chunkSize) * 0.5f;
+    this->bounds.indices[key] = static_cast<uint32_t>(this->bounds.chunks.size());
+    this->bounds.x.push_back(center.x);
+    this->bounds.y.push_back(center.y);
+    this->bounds.z.push_back(center.z);
+    this->bounds.chunks.push_back(chunk);
+    this->columnTree->setChunk(key.p, chunk);
 }
 
-void    Terrain::renderChunks( Shader shader, Camera& camera ) {
-    /* copy values to array and sort them from far to front */
-    chunkSort_t* sortedChunks = (chunkSort_t*)malloc(sizeof(chunkSort_t) * this->chunks.size());
-    int i = 0;
-    for (std::pair<ckey_t, Chunk*> chunk : this->chunks)
-        sortedChunks[(i++)] = { chunk.second, glm::distance(chunk.first.p, getChunkPosition(camera.getPosition())) };
-    std::sort(sortedChunks, sortedChunks+this->chunks.size(), chunkRenderingCompareSort); /* O(n*log(n)) */
+/* the last bounds take the place of the removed ones */
+void    Terrain::removeChunkBounds( const ckey_t& key ) {
+    auto it = this->bounds.indices.find(key);
+    if (it == this->bounds.indices.end())
+        return;
+    this->columnTree->setChunk(key.p, nullptr);
+    const uint32_t i = it->second;
+    const uint32_t last = static_cast<uint32_t>(this->bounds.chunks.size() - 1);
+    this->bounds.indices.erase(it);
+    if (i != last) {
+        this->bounds.x[i] = this->bounds.x[last];
+        this->bounds.y[i] = this->bounds.y[last];
+        this->bounds.z[i] = this->bounds.z[last];
+        this->bounds.chunks[i] = this->bounds.chunks[last];
+        this->bounds.indices[{ this->bounds.chunks[i]->getPosition() / glm::vec3(this->chunkSize) }] = i;
+    }
+    this->bounds.x.pop_back();
+    this->bounds.y.pop_back();
+    this->bounds.z.pop_back();
+    this->bounds.chunks.pop_back();
+}
+
+/*  the chunks in the fustrum and in the render distance: by the column tree (the cost follows the area in
+    view), or by the batched test over all the bounds
+*/
+void    Terrain::cullChunks( Camera& camera ) {
+    tTimePoint start = std::chrono::high_resolution_clock::now();
+    const float renderDistance = static_cast<float>(this->governor->getRenderDistance());
+    const int mode = (this->hierarchicalCulling ? 1 : 0);
+    this->chunksInView.clear();
+    if (this->hierarchicalCulling)
+        this->columnTree->cull(camera, renderDistance, this->chunksInView);
+    else {
+        const glm::vec3 half = glm::vec3(this->chunkSize) * 0.5f;
+        const glm::vec2 camera2d = glm::vec2(camera.getPosition().x, camera.getPosition().z);
+        this->visibleBounds.clear();
+        camera.aabsInFustrum(this->bounds.x.data(), this->bounds.y.data(), this->bounds.z.data(), glm::vec3(this->chunkSize), this->bounds.chunks.size(), this->visibleBounds);
+        for (size_t i = 0; i < this->visibleBounds.size(); ++i) {
+            const uint32_t b = this->visibleBounds[i];
+            if (glm::distance(glm::vec2(this->bounds.x[b] - half.x, this->bounds.z[b] - half.z), camera2d) - 16 <= renderDistance)
+                this->chunksInView.push_back(this->bounds.chunks[b]);
+        }
+        this->fustrumStats.tested += this->bounds.chunks.size();
+    }
+    this->fustrumStats.frames[mode]++;
+    this->fustrumStats.visible[mode] += this->chunksInView.size();
+    this->fustrumStats.cullMs[mode] += (static_cast<tMilliseconds>(std::chrono::high_resolution_clock::now() - start)).count();
+}
+
+const memoryUsage_t Terrain::getMemoryUsage( void ) const {
+    memoryUsage_t usage = { 0, 0, 0, 0, this->chunkCache->getBytes() };
+    for (auto it = this->chunks.begin(); it != this->chunks.end(); ++it)
+        it->second->addMemoryUsage(usage);
+    if (this->computeMesher != nullptr)
+        usage.gpuBuffers += this->computeMesher->getBytes();
+    if (this->uploadRing->isPersistent())
+        usage.gpuBuffers += this->uploadRing->getSize();
+    return usage;
+}
+
+void    Terrain::setChunkCacheLimits( size_t maxBytes, size_t maxEntries ) {
+    this->cacheMaxBytes = maxBytes;
+    this->cacheMaxEntries = maxEntries;
+    this->chunkCache->setLimits(this->governor->getCacheBudget(this->getMemoryUsage(), maxBytes), maxEntries);
+}
+
+/*  keep the terrain under the memory budget: evict the farthest chunks outside of the render distance,
+    let the governor adapt the render distance, and give what is left of the budget to the chunk cache.
+*/
+void    Terrain::governMemory( const glm::vec3& cameraPosition ) {
+    memoryUsage_t usage = this->getMemoryUsage();
+    size_t excess = this->governor->getExcess(usage);
+    if (excess > 0) {
+        const float limit = this->governor->getRenderDistance() + this->chunkSize.x;
+        std::vector<std::pair<float, ckey_t>> candidates;
+        for (auto it = this->chunks.begin(); it != this->chunks.end(); ++it) {
+            float distHorizontal = glm::distance(it->second->getPosition() * glm::vec3(1,0,1), cameraPosition * glm::vec3(1,0,1));
+            if (distHorizontal > limit)
+                candidates.push_back({ distHorizontal, it->first });
+        }
+        std::sort(candidates.begin(), candidates.end(), []( const std::pair<float, ckey_t>& a, const std::pair<float, ckey_t>& b ) { return a.first > b.first; });
+        uint evicted = 0;
+        for (size_t i = 0; i < candidates.size() && excess > 0; ++i) {
+            memoryUsage_t chunkUsage = { 0, 0, 0, 0, 0 };
+            this->chunks.at(candidates[i].second)->addMemoryUsage(chunkUsage);
+            if (MemoryGovernor::getResident(chunkUsage) == 0) /* nothing to win */
+                continue;
+            this->evictChunk(candidates[i].second);
+            excess -= std::min(excess, MemoryGovernor::getResident(chunkUsage));
+            evicted++;
+        }
+        if (evicted > 0) {
+            this->governor->addEvicted(evicted);
+            this->deleteUnusedColumns();
+            usage = this->getMemoryUsage();
+        }
+    }
+    this->governor->update(usage);
+    this->chunkCache->setLimits(this->governor->getCacheBudget(usage, this->cacheMaxBytes), this->cacheMaxEntries);
+}
+
+/* restore a chunk from the chunk cache or the region files, nullptr if it was never evicted nor saved */
+Chunk*  Terrain::loadChunk( const glm::vec3& chunkPosition ) {
+    bool modified = false;
+    bool cached = this->chunkCache->take(chunkPosition, this->serializedBuffer, modified);
+    if (cached == false && this->regionStore->load(chunkPosition, this->serializedBuffer) == false)
+        return nullptr;
+    if (Chunk::isSerializedValid(this->serializedBuffer, this->chunkSize, this->dataMargin) == false)
+        return nullptr;
+    Chunk* chunk = new Chunk(chunkPosition * glm::vec3(this->chunkSize), this->chunkSize, this->serializedBuffer, this->dataMargin);
+    chunk->setModified(modified);
+    this->stats.cached += cached;
+    this->stats.loaded += !cached;
+    return chunk;
+}
+
+/*  write the chunk in its region file if its state changed since it was generated, loaded or saved. The chunks
+    generated from the lattice are not saved: the regions only hold full resolution chunks of their generation.
+*/
+void    Terrain::saveChunk( const glm::vec3& chunkPosition, Chunk* chunk ) {
+    if (chunk->isModified() == false || chunk->isApproximate())
+        return ;
+    chunk->serialize(this->serializedBuffer);
+    if (this->regionStore->save(chunkPosition, this->serializedBuffer))
+        chunk->setModified(false);
+}
+
+/* keep an evicted chunk in the chunk cache, it is saved when dropped from the cache if it was modified */
+void    Terrain::cacheChunk( const glm::vec3& chunkPosition, Chunk* chunk ) {
+    chunk->serialize(this->serializedBuffer);
+    this->chunkCache->insert(chunkPosition, this->serializedBuffer, chunk->isModified() && !chunk->isApproximate());
+}
+
+/* delete the cached columns which have no chunk left, loaded or waiting to be */
+void    Terrain::deleteUnusedColumns( void ) {
+    const int height = this->maxHeight / this->chunkSize.y;
+    for (auto it = this->columns.begin(); it != this->columns.end(); ) {
+        bool used = false;
+        for (int y = 0; y < height && !used; ++y) {
+            ckey_t key = { it->first.p + glm::vec3(0, y, 0) };
+            used = (this->chunks.find(key) != this->chunks.end() || this->chunksToLoadSet.find(key) != this->chunksToLoadSet.end());
+        }
+        it = (used ? std::next(it) : this->columns.erase(it));
+    }
+}
+
+void    Terrain::renderChunks( Shader& shader, Camera& camera ) {
+    /* the chunks in view, from front to back */
+    this->cullChunks(camera);
+    this->updateRenderList(camera);
     /* test, detect if we're underwater */
     glm::vec3 chunkPosition = getChunkPosition(camera.getPosition());
     glm::ivec3 positionInChunk = glm::ivec3(camera.getPosition() + glm::vec3(0,.5,0) - (chunkPosition * glm::vec3(32)) );
     int underwater = 0;
+    int underground = 0;
     int index = ((int)positionInChunk.x+2) + ((int)positionInChunk.z+2) * 36 + ((int)positionInChunk.y+2) * 1296;
-    if (this->chunks.find({chunkPosition}) != this->chunks.end() && this->chunks[{chunkPosition}]->getTexture()[index] == 15)
+    if (this->chunks.find({chunkPosition}) != this->chunks.end() && this->chunks[{chunkPosition}]->getVoxel(index) == 15)
         underwater = 1;
-    /* render chunks in order */
-    for (int i = 0; i < this->chunks.size(); ++i)
-        sortedChunks[i].chunk->render(shader, camera, this->textureAtlas, renderDistance, underwater);
-    free(sortedChunks);
-    sortedChunks = nullptr;
+    if (this->chunks.find({chunkPosition}) != this->chunks.end() && this->chunks[{chunkPosition}]->getLight(index) < 15)
+        underground = 1;
+    /* the chunks the camera can see through air or water */
+    const bool culling = (this->caveCulling == true && this->computeVisibleChunks(camera) == true);
+    cullingStats_t& cs = this->cullingStats[underground];
+    cs.frames++;
+    if (this->occlusionCulling == true)
+        this->buildOcclusionBuffer(camera);
+    /* the chunks drawn */
+    for (int l = 0; l < Chunk::lodLevels; ++l)
+        this->lodStats.chunks[l] = this->lodStats.points[l] = 0;
+    this->drawList.clear();
+    for (size_t i = 0; i < this->renderList.size(); ++i) {
+        Chunk* chunk = this->renderList[i].chunk;
+        if (culling == true && this->visibleChunks.find({ chunk->getPosition() / glm::vec3(this->chunkSize) }) == this->visibleChunks.end()) {
+            cs.culledDrawCalls += chunk->getDrawCalls();
+            cs.culledPoints += chunk->getPointsCount();
+            continue;
+        }
+        if (this->occlusionCulling == true && (chunk->getPointsCount() > 0 || chunk->isComputeMeshed())) {
+            /* the voxels are centered on their position, and the water is raised by one bloc when underwater */
+            this->occlusionStats.tested++;
+            if (this->occlusionBuffer->isVisible(chunk->getPosition() - 0.5f, chunk->getPosition() + glm::vec3(this->chunkSize) + glm::vec3(-0.5f, 0.5f, -0.5f)) == false) {
+                this->occlusionStats.culled++;
+                this->occlusionStats.culledPoints += chunk->getPointsCount();
+                continue;
+            }
+        }
+        this->drawList.push_back(chunk);
+        const uint points = (chunk->isUniform() ? 0 : chunk->getPointsCount());
+        this->lodStats.chunks[chunk->getLodLevel()] += (points > 0);
+        this->lodStats.points[chunk->getLodLevel()] += points;
+        cs.drawCalls += (points > 0 ? chunk->getDrawCalls() : 0);
+        cs.points += points;
+    }
+    /* the far terrain first, the chunks are drawn over it */
+    this->horizon->render(camera, this->textureAtlas, this->governor->getRenderDistance());
+    glClear(GL_DEPTH_BUFFER_BIT);
+    shader.use();
+    if (this->chunkUniforms.program != shader.id) {
+        shader.bindUniformBlock("frame", frameUniformBinding);
+        this->chunkUniforms.program = shader.id;
+        this->chunkUniforms.atlas = shader.getUniform<int>("atlas");
+        this->chunkUniforms.waterOffset = shader.getUniform<int>("waterOffset");
+        this->chunkUniforms.faces = shader.getUniform<int>("faces");
+    }
+    /* the state shared by every chunk, once per frame */
+    const frameUniforms_t frame = { camera.getViewProjectionMatrix(), glm::vec4(camera.getPosition(), 1.0f), underwater, { 0, 0, 0 } };
+    glBindBuffer(GL_UNIFORM_BUFFER, this->frameUniformBuffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(frameUniforms_t), &frame);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, frameUniformBinding, this->frameUniformBuffer);
+    GLState::activeTexture(GL_TEXTURE0);
+    this->chunkUniforms.atlas.set(0);
+    GLState::bindTexture(GL_TEXTURE_2D, this->textureAtlas);
+    const bool faces = this->isFaceRendering();
+    if (faces) { /* the chunks bind their faces buffer on the second unit */
+        GLState::activeTexture(GL_TEXTURE1);
+        this->chunkUniforms.faces.set(1);
+    }
+    if (this->computeMesher != nullptr && Chunk::computeMeshedCount > 0)
+        this->computeMesher->bind();
+    /* the opaque meshes from front to back (the hidden fragments fail the early depth test), then the water from back to front */
+    tTimePoint start = std::chrono::high_resolution_clock::now();
+    GLuint* queries = this->renderQueries[this->renderFrame & 1];
+    this->renderQueryFaces[this->renderFrame & 1] = faces;
+    glBeginQuery(GL_SAMPLES_PASSED, queries[0]);
+    glBeginQuery(GL_TIME_ELAPSED, queries[2]);
+    this->chunkUniforms.waterOffset.set(0);
+    const size_t count = this->drawList.size();
+    uint draws = 0;
+    uint64_t submittedFaces = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const uint drawn = this->drawList[this->frontToBack ? i : count - 1 - i]->renderOpaque(camera, faces);
+        draws += (drawn > 0);
+        submittedFaces += drawn;
+    }
+    glEndQuery(GL_TIME_ELAPSED);
+    glEndQuery(GL_SAMPLES_PASSED);
+    glBeginQuery(GL_SAMPLES_PASSED, queries[1]);
+    /* HACK: back faces are off by 1 unit down, so if we're underwater, we raise water voxels by one so that water line is at "correct" height */
+    this->chunkUniforms.waterOffset.set(underwater);
+    for (size_t i = count; i > 0; --i) {
+        const uint drawn = this->drawList[i - 1]->renderTransparent(camera, faces);
+        draws += (drawn > 0);
+        submittedFaces += drawn;
+    }
+    glEndQuery(GL_SAMPLES_PASSED);
+    GLState::bindVertexArray(0);
+    GLState::activeTexture(GL_TEXTURE0);
+    this->renderStats.submitMs += (static_cast<tMilliseconds>(std::chrono::high_resolution_clock::now() - start)).count();
+    this->renderStats.draws += draws;
+    if (faces) {
+        this->renderStats.faceFrames++;
+        for (size_t i = 0; i < count; ++i)
+            this->renderStats.faces += this->drawList[i]->getFacesCount();
+        this->renderStats.submittedFaces += submittedFaces;
+    }
+    this->readRenderQueries();
+}
+
+/*  Keep the chunks in view sorted from front to back. The list is kept between the frames: the chunks which
+    left the view are removed, the new ones appended, and the list is sorted by insertion (it is almost sorted
+    when the camera moves), or fully when many chunks entered the view.
+*/
+void    Terrain::updateRenderList( Camera& camera ) {
+    tTimePoint start = std::chrono::high_resolution_clock::now();
+    this->renderFrame++;
+    const uint64_t inView = this->renderFrame * 2;
+    const uint64_t listed = this->renderFrame * 2 + 1;
+    for (size_t i = 0; i < this->chunksInView.size(); ++i)
+        this->chunksInView[i]->setRenderFrame(inView);
+    size_t kept = 0;
+    for (size_t i = 0; i < this->renderList.size(); ++i) {
+        Chunk* chunk = this->renderList[i].chunk;
+        if (this->evictedChunks.find(chunk) != this->evictedChunks.end() || chunk->getRenderFrame() != inView)
+            continue;
+        chunk->setRenderFrame(listed);
+        this->renderList[kept++] = this->renderList[i];
+    }
+    this->renderList.resize(kept);
+    this->evictedChunks.clear();
+    for (size_t i = 0; i < this->chunksInView.size(); ++i)
+        if (this->chunksInView[i]->getRenderFrame() == inView) {
+            this->renderList.push_back({ this->chunksInView[i], 0.0f });
+            this->chunksInView[i]->setRenderFrame(listed);
+        }
+    const glm::vec3 halfSize = glm::vec3(this->chunkSize) * 0.5f;
+    for (size_t i = 0; i < this->renderList.size(); ++i)
+        this->renderList[i].comp = glm::distance(this->renderList[i].chunk->getPosition() + halfSize, camera.getPosition());
+    if (this->renderList.size() - kept > this->renderList.size() / 4) {
+        std::sort(this->renderList.begin(), this->renderList.end(), chunkRenderingCompareSort); /* O(n*log(n)) */
+        this->renderStats.fullSorts++;
+    }
+    else
+        for (size_t i = 1; i < this->renderList.size(); ++i) {
+            const chunkSort_t entry = this->renderList[i];
+            size_t j = i;
+            for (; j > 0 && chunkRenderingCompareSort(entry, this->renderList[j - 1]); --j)
+                this->renderList[j] = this->renderList[j - 1];
+            this->renderList[j] = entry;
+            this->renderStats.moves += i - j;
+        }
+    this->renderStats.frames++;
+    this->renderStats.sortMs += (static_cast<tMilliseconds>(std::chrono::high_resolution_clock::now() - start)).count();
+}
+
+/* the queries of the previous frame, when their results are there (never waits for the gpu) */
+void    Terrain::readRenderQueries( void ) {
+    if (this->renderFrame < 2)
+        return;
+    GLuint* queries = this->renderQueries[(this->renderFrame + 1) & 1];
+    GLint available = 0;
+    glGetQueryObjectiv(queries[2], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (available == 0)
+        return;
+    GLuint opaque = 0, transparent = 0;
+    GLuint64 elapsed = 0;
+    glGetQueryObjectuiv(queries[0], GL_QUERY_RESULT, &opaque);
+    glGetQueryObjectuiv(queries[1], GL_QUERY_RESULT, &transparent);
+    glGetQueryObjectui64v(queries[2], GL_QUERY_RESULT, &elapsed);
+    const glm::ivec4& viewport = GLState::getViewport();
+    this->renderStats.queries++;
+    this->renderStats.opaqueSamples += opaque;
+    this->renderStats.transparentSamples += transparent;
+    this->renderStats.pixels += static_cast<uint64_t>(viewport[2]) * viewport[3];
+    this->renderStats.opaqueGpuMs += elapsed / 1000000.0;
+    if (this->renderQueryFaces[(this->renderFrame + 1) & 1]) {
+        this->renderStats.faceQueries++;
+        this->renderStats.faceGpuMs += elapsed / 1000000.0;
+    }
 }
 
 void    Terrain::renderChunkGeneration( const glm::vec3& position ) {
-    GLint m_viewport[4];
-    glGetIntegerv(GL_VIEWPORT, m_viewport);
+    /* the column is evaluated first if needed, it has its own pass and framebuffer (the lattice evaluates its own fields) */
+    const bool useColumn = (this->lattice.mode == 0);
+    if (useColumn)
+        this->bindColumn(position / glm::vec3(this->chunkSize));
+    const glm::ivec4 m_viewport = GLState::getViewport();
     /* configure the framebuffer */
-    glDisable(GL_DEPTH_TEST);
-    glBindFramebuffer(GL_FRAMEBUFFER, this->chunkGenerationFbo.fbo);
-    glViewport(0, 0, this->chunkGenerationFbo.width, this->chunkGenerationFbo.height);
+    GLState::disable(GL_DEPTH_TEST);
+    GLState::bindFramebuffer(this->chunkGenerationFbo.fbo);
+    GLState::viewport(0, 0, this->chunkGenerationFbo.width, this->chunkGenerationFbo.height);
     glClear(GL_COLOR_BUFFER_BIT);
 
     /* use and set uniform for chunk generation shader */
@@ -207,28 +788,428 @@ void    Terrain::renderChunkGeneration( const glm::vec3& position ) {
     this->chunkGenerationShader->setVec3UniformValue("chunkPosition", position);
     this->chunkGenerationShader->setVec3UniformValue("chunkSize", glm::vec3(this->chunkSize + (int)this->dataMargin) );
     this->chunkGenerationShader->setIntUniformValue("margin", this->dataMargin );
-    glActiveTexture(GL_TEXTURE0);
-    this->chunkGenerationShader->setIntUniformValue("noiseSampler", 0);
-    glBindTexture(GL_TEXTURE_2D, this->noiseSampler);
+    this->chunkGenerationShader->setIntUniformValue("seed", static_cast<int>(this->worldGen->getSeed()));
+    this->chunkGenerationShader->setIntUniformValue("coarseLattice", (this->lattice.mode != 0));
+    this->chunkGenerationShader->setIntUniformValue("columnPass", 0);
+    this->chunkGenerationShader->setIntUniformValue("useColumn", useColumn);
+
+    if (this->lattice.mode != 0) {
+        /* first pass, evaluate the smooth fields on the lattice nodes */
+        GLState::bindFramebuffer(this->lattice.fbo);
+        GLState::viewport(0, 0, this->lattice.size.x, this->lattice.size.y * this->lattice.size.z);
+        this->chunkGenerationShader->setIntUniformValue("latticePass", 1);
+        this->chunkGenerationShader->setIvec3UniformValue("latticeStep", this->lattice.step);
+        this->chunkGenerationShader->setIvec3UniformValue("latticeSize", this->lattice.size);
+        GLState::bindVertexArray(this->chunkGenerationRenderingQuad.vao);
+        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+        GLState::bindVertexArray(0);
+        /* bind the lattice fields for the voxels pass */
+        GLState::bindFramebuffer(this->chunkGenerationFbo.fbo);
+        GLState::viewport(0, 0, this->chunkGenerationFbo.width, this->chunkGenerationFbo.height);
+        GLState::activeTexture(GL_TEXTURE1);
+        this->chunkGenerationShader->setIntUniformValue("latticeSamplerA", 1);
+        GLState::bindTexture(GL_TEXTURE_2D, this->lattice.fields[0]);
+        GLState::activeTexture(GL_TEXTURE2);
+        this->chunkGenerationShader->setIntUniformValue("latticeSamplerB", 2);
+        GLState::bindTexture(GL_TEXTURE_2D, this->lattice.fields[1]);
+        GLState::activeTexture(GL_TEXTURE0);
+    }
+    this->chunkGenerationShader->setIntUniformValue("latticePass", 0);
 
     /* render quad */
-    glBindVertexArray(this->chunkGenerationRenderingQuad.vao);
+    GLState::bindVertexArray(this->chunkGenerationRenderingQuad.vao);
     glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
+    GLState::bindVertexArray(0);
 
     /* read the pixels from the framebuffer (or texture, which seems slightly faster) */
     #if (0)
         glReadPixels(0, 0, this->chunkGenerationFbo.width, this->chunkGenerationFbo.height, GL_RED, GL_UNSIGNED_BYTE, data);
     #else
-        glBindTexture(GL_TEXTURE_2D, this->chunkGenerationFbo.id);
+        GLState::bindTexture(GL_TEXTURE_2D, this->chunkGenerationFbo.id);
         glGetTexImage(GL_TEXTURE_2D, 0, GL_RED, GL_UNSIGNED_BYTE, this->dataBuffer);
-        glBindTexture(GL_TEXTURE_2D, 0);
+        GLState::bindTexture(GL_TEXTURE_2D, 0);
     #endif
+    FragmentGenerator::decode(this->dataBuffer, this->chunkGenerationFbo.width * this->chunkGenerationFbo.height);
 
     /* reset the framebuffer target and size */
-    glEnable(GL_DEPTH_TEST);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    glViewport(m_viewport[0], m_viewport[1], m_viewport[2], m_viewport[3]);
+    GLState::enable(GL_DEPTH_TEST);
+    GLState::bindFramebuffer(0);
+    GLState::viewport(m_viewport[0], m_viewport[1], m_viewport[2], m_viewport[3]);
+}
+
+/*  create the chunks received from the streaming thread, within the frame budget. The chunks out of range
+    since their request are dropped, they are requested again if they come back in range
+*/
+void    Terrain::receiveStreamedChunks( const glm::vec3& cameraPosition, const tTimePoint& frameStart ) {
+    if (this->streamer->isRunning() == false) { /* stopped on an error, the chunks are generated here */
+        this->stopStreaming();
+        return;
+    }
+    streamResult_t result;
+    while (this->streamer->receive(result)) {
+        const ckey_t key = { result.key };
+        this->streamingSet.erase(key);
+        float distHorizontal = glm::distance(key.p * glm::vec3(1,0,1),  this->getChunkPosition(cameraPosition) * glm::vec3(1,0,1));
+        if (distHorizontal > (this->governor->getRenderDistance() / chunkSize.x)) {
+            this->stats.dropped++;
+            continue;
+        }
+        tTimePoint start = std::chrono::high_resolution_clock::now();
+        const double cpuKernelMs = this->worldGenReport.cpuMs; /* not part of the generation time */
+        this->insertChunk(key, this->createGeneratedChunk(key.p * glm::vec3(this->chunkSize), result.voxels.data()));
+        this->stats.generateMs += (static_cast<tMilliseconds>(std::chrono::high_resolution_clock::now() - start)).count() - (this->worldGenReport.cpuMs - cpuKernelMs);
+        double delta = (static_cast<tMilliseconds>(std::chrono::high_resolution_clock::now() - frameStart)).count();
+        if (delta > this->maxAllocatedTimePerFrame)
+            break;
+    }
+}
+
+/* back to the generation on this thread, the chunks in flight are queued again */
+void    Terrain::stopStreaming( void ) {
+    delete this->streamer;
+    this->streamer = nullptr;
+    for (auto it = this->streamingSet.begin(); it != this->streamingSet.end(); ++it) {
+        this->chunksToLoadQueue.push(*it);
+        this->chunksToLoadSet.insert(*it);
+    }
+    this->streamingSet.clear();
+}
+
+/* generate the chunks of the compute generator batch with a single dispatch */
+void    Terrain::generateBatch( void ) {
+    if (this->generationBatch.empty())
+        return;
+    tTimePoint start = std::chrono::high_resolution_clock::now();
+    const double cpuKernelMs = this->worldGenReport.cpuMs; /* not part of the generation time */
+    this->computeGenerator->dispatch(static_cast<int>(this->worldGen->getSeed()));
+    for (size_t i = 0; i < this->generationBatch.size(); ++i) {
+        const ckey_t& key = this->generationBatch[i];
+        this->insertChunk(key, this->createGeneratedChunk(key.p * glm::vec3(this->chunkSize), this->computeGenerator->getVoxels(i)));
+    }
+    this->generationBatch.clear();
+    this->computeGenerator->clear();
+    this->stats.generateMs += (static_cast<tMilliseconds>(std::chrono::high_resolution_clock::now() - start)).count() - (this->worldGenReport.cpuMs - cpuKernelMs);
+}
+
+/* the chunk of generated data (nullptr for a chunk only made of air, decided from its column), uniform chunks have no voxels */
+Chunk*  Terrain::createGeneratedChunk( const glm::vec3& position, const uint8_t* data ) {
+    if (data != nullptr && this->lattice.mode == 0 && this->stats.generated % this->worldGenReportInterval == 0)
+        this->compareCpuGeneration(position, data);
+    const int uniformBloc = (data != nullptr ? this->getUniformBloc(data) : 0);
+    this->stats.generated++;
+    this->stats.uniformAir += (uniformBloc == 0);
+    this->stats.uniformSolid += (uniformBloc > 0);
+    if (uniformBloc != -1)
+        return new Chunk(position, this->chunkSize, static_cast<uint8_t>(uniformBloc), this->dataMargin);
+    return new Chunk(position, this->chunkSize, data, this->dataMargin);
+}
+
+/* a new chunk (loaded or generated), its water and light are computed by the next updates */
+void    Terrain::insertChunk( const ckey_t& key, Chunk* chunk ) {
+    this->chunks.insert( { key, chunk } );
+    this->addChunkBounds(key, chunk);
+    this->chunksToUpdateQueue.push({ key.p, key.p, updateType::water });
+    this->chunksToUpdateQueue.push({ key.p, key.p, updateType::light });
+}
+
+/* return the bloc id if the generated data (chunk and its one voxel ring) is made of a single bloc type, -1 otherwise */
+const int   Terrain::getUniformBloc( const uint8_t* data ) const {
+    const int m = this->dataMargin / 2;
+    const glm::ivec3 paddedSize = this->chunkSize + static_cast<int>(this->dataMargin);
+    const uint8_t bloc = data[(m-1) + (m-1) * paddedSize.x + (m-1) * paddedSize.x * paddedSize.z];
+    for (int y = -1; y < chunkSize.y+1; ++y)
+        for (int z = -1; z < chunkSize.z+1; ++z) {
+            const uint8_t* row = data + (m-1) + (z+m) * paddedSize.x + (y+m) * paddedSize.x * paddedSize.z;
+            for (int x = 0; x < chunkSize.x+2; ++x)
+                if (row[x] != bloc)
+                    return -1;
+        }
+    return bloc;
+}
+
+/* return the column fields of a chunk, evaluated if they are not cached yet */
+const column_t&     Terrain::getColumn( const glm::vec3& chunkPosition ) {
+    ckey_t key = { chunkPosition * glm::vec3(1, 0, 1) };
+    auto it = this->columns.find(key);
+    if (it != this->columns.end())
+        return it->second;
+    column_t& column = this->columns[key];
+    this->renderColumnGeneration(key.p * glm::vec3(this->chunkSize), column);
+    this->stats.columns++;
+    return column;
+}
+
+/* a chunk is only made of air if all its generated voxels are above the column terrain top (and the bedrock and water levels) */
+const bool  Terrain::isChunkAboveColumn( const column_t& column, const glm::vec3& position ) const {
+    const float low = position.y - 1.0f;
+    const float high = position.y + this->chunkSize.y;
+    const float waterLevel = static_cast<float>(WorldGen::waterLevel);
+    return (low > column.maxTop && low > WorldGen::bedrockCeiling && (waterLevel < low || high < waterLevel));
+}
+
+/* upload the fields of the chunk column in the column texture, if not already there */
+void    Terrain::bindColumn( const glm::vec3& chunkPosition ) {
+    ckey_t key = { chunkPosition * glm::vec3(1, 0, 1) };
+    const column_t& column = this->getColumn(chunkPosition);
+    GLState::activeTexture(GL_TEXTURE3);
+    this->chunkGenerationShader->setIntUniformValue("columnSampler", 3);
+    GLState::bindTexture(GL_TEXTURE_2D, this->columnFbo.id);
+    if (!(this->boundColumn == key)) {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, this->columnFbo.width, this->columnFbo.height, GL_RGBA, GL_FLOAT, column.fields.data());
+        this->boundColumn = key;
+    }
+    GLState::activeTexture(GL_TEXTURE0);
+}
+
+void    Terrain::renderColumnGeneration( const glm::vec3& position, column_t& column ) {
+    const int m = this->dataMargin / 2;
+    const glm::ivec4 m_viewport = GLState::getViewport();
+    GLState::disable(GL_DEPTH_TEST);
+    GLState::bindFramebuffer(this->columnFbo.fbo);
+    GLState::viewport(0, 0, this->columnFbo.width, this->columnFbo.height);
+
+    this->chunkGenerationShader->use();
+    this->chunkGenerationShader->setFloatUniformValue("near", 0.1f);
+    this->chunkGenerationShader->setVec3UniformValue("chunkPosition", position);
+    this->chunkGenerationShader->setIntUniformValue("margin", this->dataMargin );
+    this->chunkGenerationShader->setIntUniformValue("seed", static_cast<int>(this->worldGen->getSeed()));
+    this->chunkGenerationShader->setIntUniformValue("latticePass", 0);
+    this->chunkGenerationShader->setIntUniformValue("columnPass", 1);
+
+    GLState::bindVertexArray(this->chunkGenerationRenderingQuad.vao);
+    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+    GLState::bindVertexArray(0);
+
+    column.fields.resize(this->columnFbo.width * this->columnFbo.height * 4);
+    GLState::bindTexture(GL_TEXTURE_2D, this->columnFbo.id);
+    glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_FLOAT, column.fields.data());
+    GLState::bindTexture(GL_TEXTURE_2D, 0);
+    this->chunkGenerationShader->setIntUniformValue("columnPass", 0);
+    this->boundColumn = { position / glm::vec3(this->chunkSize) * glm::vec3(1, 0, 1) };
+    /* bounds over the generated voxels (the chunk and its one voxel ring) */
+    column.minTop = 256.0f;
+    column.maxTop = -1.0f;
+    for (int z = m-1; z < this->chunkSize.z+m+1; ++z)
+        for (int x = m-1; x < this->chunkSize.x+m+1; ++x) {
+            float top = column.fields[(x + z * this->columnFbo.width) * 4];
+            column.minTop = std::min(column.minTop, top);
+            column.maxTop = std::max(column.maxTop, top);
+        }
+
+    GLState::enable(GL_DEPTH_TEST);
+    GLState::bindFramebuffer(0);
+    GLState::viewport(m_viewport[0], m_viewport[1], m_viewport[2], m_viewport[3]);
+}
+
+/* evaluate the samples entering the horizon levels with the generation shader */
+void    Terrain::updateHorizon( const glm::vec3& cameraPosition ) {
+    const glm::ivec4 m_viewport = GLState::getViewport();
+    GLState::disable(GL_DEPTH_TEST);
+    this->chunkGenerationShader->use();
+    this->chunkGenerationShader->setIntUniformValue("seed", static_cast<int>(this->worldGen->getSeed()));
+    this->chunkGenerationShader->setIntUniformValue("latticePass", 0);
+    this->chunkGenerationShader->setIntUniformValue("columnPass", 0);
+    this->chunkGenerationShader->setIntUniformValue("coarseLattice", 0);
+    this->chunkGenerationShader->setIntUniformValue("useColumn", 0);
+    this->chunkGenerationShader->setIntUniformValue("horizonPass", 1);
+    this->horizon->update(cameraPosition, *this->chunkGenerationShader, this->chunkGenerationRenderingQuad.vao);
+    this->chunkGenerationShader->setIntUniformValue("horizonPass", 0);
+    GLState::enable(GL_DEPTH_TEST);
+    GLState::bindFramebuffer(0);
+    GLState::viewport(m_viewport[0], m_viewport[1], m_viewport[2], m_viewport[3]);
+}
+
+/* generate the chunk at full resolution and with the lattice, and accumulate the differences (the lattice result is kept) */
+void    Terrain::compareLatticeGeneration( const glm::vec3& position ) {
+    const int m = this->dataMargin / 2;
+    const glm::ivec3 paddedSize = this->chunkSize + static_cast<int>(this->dataMargin);
+    const int mode = this->lattice.mode;
+
+    tTimePoint start = std::chrono::high_resolution_clock::now();
+    this->lattice.mode = 0;
+    this->renderChunkGeneration(position);
+    this->latticeReport.fullMs += (static_cast<tMilliseconds>(std::chrono::high_resolution_clock::now() - start)).count();
+    memcpy(this->referenceBuffer, this->dataBuffer, this->chunkGenerationFbo.width * this->chunkGenerationFbo.height);
+
+    start = std::chrono::high_resolution_clock::now();
+    this->lattice.mode = mode;
+    this->renderChunkGeneration(position);
+    this->latticeReport.latticeMs += (static_cast<tMilliseconds>(std::chrono::high_resolution_clock::now() - start)).count();
+
+    for (int y = 0; y < chunkSize.y; ++y)
+        for (int z = 0; z < chunkSize.z; ++z)
+            for (int x = 0; x < chunkSize.x; ++x) {
+                int i = (x+m) + (z+m) * paddedSize.x + (y+m) * paddedSize.x * paddedSize.z;
+                uint8_t full = this->referenceBuffer[i];
+                uint8_t approx = this->dataBuffer[i];
+                if ((full == 0 || full == 15) != (approx == 0 || approx == 15))
+                    this->latticeReport.flips++;
+                else if (full != approx)
+                    this->latticeReport.materials++;
+            }
+    this->latticeReport.voxels += chunkSize.x * chunkSize.y * chunkSize.z;
+    this->latticeReport.chunks++;
+}
+
+/* evaluate a sample of the chunk voxels (one out of 8) with the CPU kernel and compare them with the generated chunk */
+void    Terrain::compareCpuGeneration( const glm::vec3& position, const uint8_t* data ) {
+    const int m = this->dataMargin / 2;
+    const glm::ivec3 paddedSize = this->chunkSize + static_cast<int>(this->dataMargin);
+    tTimePoint start = std::chrono::high_resolution_clock::now();
+    for (int y = 0; y < chunkSize.y; y += 2)
+        for (int z = 0; z < chunkSize.z; z += 2)
+            for (int x = 0; x < chunkSize.x; x += 2) {
+                int i = (x+m) + (z+m) * paddedSize.x + (y+m) * paddedSize.x * paddedSize.z;
+                if (this->worldGen->map(position + glm::vec3(x, y, z)) != data[i])
+                    this->worldGenReport.mismatches++;
+                this->worldGenReport.voxels++;
+            }
+    this->worldGenReport.cpuMs += (static_cast<tMilliseconds>(std::chrono::high_resolution_clock::now() - start)).count();
+    this->worldGenReport.chunks++;
+}
+
+/* 0: full resolution, 1: 4x4x4 lattice, 2: 4x8x4 lattice */
+void    Terrain::setGenerationLattice( int mode ) {
+    if (mode == this->lattice.mode && this->lattice.size.x != 0)
+        return;
+    const glm::ivec3 paddedSize = this->chunkSize + static_cast<int>(this->dataMargin);
+    this->lattice.mode = mode;
+    this->lattice.step = (mode == 2 ? glm::ivec3(4, 8, 4) : glm::ivec3(4, 4, 4));
+    /* nodes enclosing all the generated voxels (the last one is at paddedSize - 2) */
+    this->lattice.size = (paddedSize - 2) / this->lattice.step + 2;
+    this->latticeReport = (latticeReport_t){ 0, 0, 0, 0, 0.0, 0.0 };
+}
+
+/* the chunks meshed by the other path are remeshed progressively, with the lod switches (see updateChunkLods) */
+void    Terrain::setComputeMeshing( bool enabled ) {
+    this->computeMeshing = (enabled && this->computeMesher != nullptr);
+    Chunk::setComputeMesher(this->computeMesher, this->computeMeshing);
+}
+
+/* 0: full resolution only, 1: up to 2x downsampled meshes, 2: up to 4x */
+void    Terrain::setLodMode( int mode ) {
+    this->lodMode = std::min(std::max(mode, 0), Chunk::lodLevels - 1);
+}
+
+/* the lod level of a chunk at this distance, it only changes once the distance is past the threshold by the hysteresis */
+const int   Terrain::getLodLevel( float distance, int current ) const {
+    int level = std::min(current, this->lodMode);
+    while (level < this->lodMode && distance > this->lodDistance * (1 << level) + this->lodHysteresis)
+        level++;
+    while (level > 0 && distance < this->lodDistance * (1 << (level - 1)) - this->lodHysteresis)
+        level--;
+    return level;
+}
+
+/*  Search the chunks visible from the camera chunk: a chunk entered by a side is only left by the sides
+    its transparent voxels connect to it, in the fustrum, and never back toward the camera. Returns false
+    when the camera chunk is not loaded (everything is drawn).
+*/
+const bool  Terrain::computeVisibleChunks( Camera& camera ) {
+    const ckey_t start = { this->getChunkPosition(camera.getPosition()) };
+    this->visibleChunks.clear();
+    if (this->chunks.find(start) == this->chunks.end())
+        return false;
+    std::queue<visibilityNode_t> queue;
+    queue.push({ start, -1, 0 });
+    this->visibleChunks.insert(start);
+    while (queue.empty() == false) {
+        const visibilityNode_t node = queue.front();
+        queue.pop();
+        const Chunk* chunk = this->chunks.at(node.key);
+        for (int side = 0; side < 6; ++side) {
+            if ((node.directions & (1 << (side ^ 1))) != 0) /* the opposite direction was already taken */
+                continue;
+            if (node.from != -1 && chunk->isConnected(node.from, side) == false)
+                continue;
+            const ckey_t next = { node.key.p + neighboursOffsets[side] };
+            auto it = this->chunks.find(next);
+            if (it == this->chunks.end() || this->visibleChunks.find(next) != this->visibleChunks.end())
+                continue;
+            if (it->second->isInView(camera, this->governor->getRenderDistance()) == false)
+                continue;
+            this->visibleChunks.insert(next);
+            queue.push({ next, side ^ 1, static_cast<uint8_t>(node.directions | (1 << side)) });
+        }
+    }
+    return true;
+}
+
+/*  Rasterize the nearest occluders: the opaque layers of the chunks, merged down the columns when they
+    continue from a chunk to the one below.
+*/
+void    Terrain::buildOcclusionBuffer( Camera& camera ) {
+    tTimePoint start = std::chrono::high_resolution_clock::now();
+    this->occlusionBuffer->clear(camera.getViewProjectionMatrix());
+    const glm::vec3 up = glm::vec3(0, 1, 0);
+    auto isOccluder = [this]( const Chunk* chunk ) { return (chunk->getOccluderLayers().y > chunk->getOccluderLayers().x); };
+    std::vector<chunkSort_t> tops;
+    for (auto it = this->chunks.begin(); it != this->chunks.end(); ++it) {
+        const Chunk* chunk = it->second;
+        if (isOccluder(chunk) == false)
+            continue;
+        if (chunk->getOccluderLayers().y == this->chunkSize.y) { /* not the top of the run if it continues in the chunk above */
+            auto above = this->chunks.find({ it->first.p + up });
+            if (above != this->chunks.end() && isOccluder(above->second) && above->second->getOccluderLayers().x == 0)
+                continue;
+        }
+        const float distance = glm::distance(chunk->getPosition() + glm::vec3(this->chunkSize) * 0.5f, camera.getPosition());
+        if (distance <= this->occluderDistance)
+            tops.push_back({ it->second, distance });
+    }
+    std::sort(tops.begin(), tops.end(), []( const chunkSort_t& a, const chunkSort_t& b ) { return a.comp < b.comp; });
+    uint occluders = 0;
+    for (size_t i = 0; i < tops.size() && occluders < this->maxOccluders; ++i) {
+        const Chunk* bottom = tops[i].chunk;
+        while (bottom->getOccluderLayers().x == 0) {
+            auto below = this->chunks.find({ bottom->getPosition() / glm::vec3(this->chunkSize) - up });
+            if (below == this->chunks.end() || isOccluder(below->second) == false || below->second->getOccluderLayers().y != this->chunkSize.y)
+                break;
+            bottom = below->second;
+        }
+        const glm::vec3 min = bottom->getPosition() + glm::vec3(-0.5f, bottom->getOccluderLayers().x - 0.5f, -0.5f);
+        const glm::vec3 max = tops[i].chunk->getPosition() + glm::vec3(this->chunkSize.x - 0.5f, tops[i].chunk->getOccluderLayers().y - 0.5f, this->chunkSize.z - 0.5f);
+        if (camera.aabInFustrum(-(min + max) * 0.5f, max - min) == false)
+            continue;
+        this->occlusionBuffer->addOccluder(min, max);
+        occluders++;
+    }
+    this->occlusionBuffer->rasterize();
+    this->occlusionStats.frames++;
+    this->occlusionStats.occluders += occluders;
+    this->occlusionStats.triangles += this->occlusionBuffer->getTrianglesCount();
+    this->occlusionStats.rasterizeMs += (static_cast<tMilliseconds>(std::chrono::high_resolution_clock::now() - start)).count();
+}
+
+/*  remesh the chunks whose distance calls for another lod level, meshed by the other meshing path (cpu or compute
+    shader), whose compute mesh did not fit the arena or whose seams changed, within a few milliseconds per frame
+*/
+void    Terrain::updateChunkLods( const glm::vec3& cameraPosition ) {
+    tTimePoint start = std::chrono::high_resolution_clock::now();
+    const glm::vec3 halfSize = glm::vec3(this->chunkSize) / 2.0f;
+    for (auto it = this->chunks.begin(); it != this->chunks.end(); ++it) {
+        Chunk* chunk = it->second;
+        const int level = this->getLodLevel(glm::distance(chunk->getPosition() + halfSize, cameraPosition), chunk->getLodLevel());
+        if (level == chunk->getLodLevel() && chunk->isRemeshNeeded() == false)
+            continue;
+        const std::array<Chunk*, 6> neighbours = this->getNeighbouringChunks(it->first.p);
+        if (level != chunk->getLodLevel()) { /* the neighbours whose seam with the chunk opens or closes are remeshed */
+            std::array<bool, 6> seams;
+            for (int i = 0; i < 6; ++i)
+                seams[i] = (neighbours[i] != nullptr && neighbours[i]->isSeamOpen(chunk));
+            chunk->setLodLevel(level);
+            for (int i = 0; i < 6; ++i)
+                if (neighbours[i] != nullptr && neighbours[i]->isSeamOpen(chunk) != seams[i])
+                    neighbours[i]->setSeamsChanged();
+            this->lodStats.switches++;
+        }
+        if (chunk->isMeshed() == false) /* meshed at this level by its first update */
+            continue;
+        chunk->rebuildMesh(neighbours);
+        this->columnTree->markChunk(it->first.p);
+        if ((static_cast<tMilliseconds>(std::chrono::high_resolution_clock::now() - start)).count() > 4.0)
+            break;
+    }
 }
 
 void    Terrain::setupChunkGenerationRenderingQuad( void ) {
@@ -253,7 +1234,7 @@ void    Terrain::setupChunkGenerationRenderingQuad( void ) {
 	glGenVertexArrays(1, &this->chunkGenerationRenderingQuad.vao);
     glGenBuffers(1, &this->chunkGenerationRenderingQuad.vbo);
 	glGenBuffers(1, &this->chunkGenerationRenderingQuad.ebo);
-	glBindVertexArray(this->chunkGenerationRenderingQuad.vao);
+	GLState::bindVertexArray(this->chunkGenerationRenderingQuad.vao);
 	glBindBuffer(GL_ARRAY_BUFFER, this->chunkGenerationRenderingQuad.vbo);
 	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(vertex_t), vertices.data(), GL_STATIC_DRAW);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->chunkGenerationRenderingQuad.ebo);
@@ -266,7 +1247,7 @@ void    Terrain::setupChunkGenerationRenderingQuad( void ) {
     glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(vertex_t), reinterpret_cast<GLvoid*>(offsetof(vertex_t, TexCoords)));
 
     glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    GLState::bindVertexArray(0);
     vertices.clear();
 }
 
@@ -275,10 +1256,10 @@ void    Terrain::setupChunkGenerationFbo( void ) {
     this->chunkGenerationFbo.height = (this->chunkSize.y + this->dataMargin) * (this->chunkSize.z + this->dataMargin);
 
     glGenFramebuffers(1, &this->chunkGenerationFbo.fbo);
-    glBindFramebuffer(GL_FRAMEBUFFER, this->chunkGenerationFbo.fbo);
+    GLState::bindFramebuffer(this->chunkGenerationFbo.fbo);
     /* create color texture */
     glGenTextures(1, &this->chunkGenerationFbo.id);
-    glBindTexture(GL_TEXTURE_2D, this->chunkGenerationFbo.id);
+    GLState::bindTexture(GL_TEXTURE_2D, this->chunkGenerationFbo.id);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, this->chunkGenerationFbo.width, this->chunkGenerationFbo.height, 0, GL_RED, GL_UNSIGNED_BYTE, NULL);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
@@ -287,5 +1268,50 @@ void    Terrain::setupChunkGenerationFbo( void ) {
     
     if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
         return;
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    GLState::bindFramebuffer(0);
+}
+
+void    Terrain::setupLatticeFbo( void ) {
+    /* allocated for the densest lattice */
+    const glm::ivec3 maxSize = (this->chunkSize + static_cast<int>(this->dataMargin) - 2) / 4 + 2;
+    const GLenum attachments[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+
+    glGenFramebuffers(1, &this->lattice.fbo);
+    GLState::bindFramebuffer(this->lattice.fbo);
+    glGenTextures(2, this->lattice.fields);
+    for (int i = 0; i < 2; ++i) {
+        GLState::bindTexture(GL_TEXTURE_2D, this->lattice.fields[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, maxSize.x, maxSize.y * maxSize.z, 0, GL_RGBA, GL_FLOAT, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, attachments[i], GL_TEXTURE_2D, this->lattice.fields[i], 0);
+    }
+    glDrawBuffers(2, attachments);
+    GLState::bindTexture(GL_TEXTURE_2D, 0);
+    this->lattice.mode = 0;
+    this->lattice.size = glm::ivec3(0);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        return;
+    GLState::bindFramebuffer(0);
+}
+
+void    Terrain::setupColumnFbo( void ) {
+    this->columnFbo.width = (this->chunkSize.x + this->dataMargin);
+    this->columnFbo.height = (this->chunkSize.z + this->dataMargin);
+    this->boundColumn = { glm::vec3(0, -1, 0) }; /* no column has this key */
+
+    glGenFramebuffers(1, &this->columnFbo.fbo);
+    GLState::bindFramebuffer(this->columnFbo.fbo);
+    glGenTextures(1, &this->columnFbo.id);
+    GLState::bindTexture(GL_TEXTURE_2D, this->columnFbo.id);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, this->columnFbo.width, this->columnFbo.height, 0, GL_RGBA, GL_FLOAT, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, this->columnFbo.id, 0);
+    GLState::bindTexture(GL_TEXTURE_2D, 0);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        return;
+    GLState::bindFramebuffer(0);
 }
@@ -0,0 +1,155 @@
+#include "UploadRing.hpp"
+
+/* the uploads start on this alignment, as the copies of the drivers prefer */
+static const size_t uploadAlignment = 256;
+
+UploadRing::UploadRing( size_t size ) : size(size) {
+    this->buffer = 0;
+    this->mapped = nullptr;
+    this->head = this->frameBegin = this->current = this->currentSize = 0;
+    this->currentStaged = false;
+    this->frameBytes = 0;
+    this->stats = (uploadRingStats_t){ 0, 0, 0, 0, 0, 0, 0.0 };
+#ifdef GL_ARB_buffer_storage
+    if (GLAD_GL_ARB_buffer_storage) {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glGenBuffers(1, &this->buffer);
+        glBindBuffer(GL_COPY_READ_BUFFER, this->buffer);
+        glBufferStorage(GL_COPY_READ_BUFFER, this->size, nullptr, flags);
+        this->mapped = static_cast<uint8_t*>(glMapBufferRange(GL_COPY_READ_BUFFER, 0, this->size, flags));
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    }
+#endif
+    if (this->mapped == nullptr) {
+        glDeleteBuffers(1, &this->buffer);
+        this->buffer = 0;
+    }
+}
+
+UploadRing::~UploadRing( void ) {
+    for (auto it = this->segments.begin(); it != this->segments.end(); ++it)
+        glDeleteSync(it->fence);
+    if (this->mapped != nullptr) {
+        glBindBuffer(GL_COPY_READ_BUFFER, this->buffer);
+        glUnmapBuffer(GL_COPY_READ_BUFFER);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    }
+    glDeleteBuffers(1, &this->buffer);
+}
+
+/* the upload goes after the previous one, or back at the start of the ring when it does not fit the end */
+uint8_t*    UploadRing::map( size_t size ) {
+    this->currentSize = size;
+    this->currentStaged = (this->mapped == nullptr || size == 0 || size > this->size);
+    if (this->currentStaged) {
+        if (this->staging.size() < size)
+            this->staging.resize(size);
+        return this->staging.data();
+    }
+    size_t begin = (this->head + uploadAlignment - 1) & ~(uploadAlignment - 1);
+    if (begin + size > this->size) {
+        this->closeSegment(); /* the bytes of this frame at the end of the ring are fenced apart */
+        begin = 0;
+    }
+    this->waitSegments(begin, begin + size);
+    if (this->frameBegin == this->head)
+        this->frameBegin = begin;
+    this->current = begin;
+    this->head = begin + size;
+    return this->mapped + begin;
+}
+
+/* the ring is coherent, the writes are seen by the copy without a flush */
+void    UploadRing::copy( GLuint buffer, GLintptr offset ) {
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    if (this->currentStaged)
+        glBufferSubData(GL_COPY_WRITE_BUFFER, offset, this->currentSize, this->staging.data());
+    else {
+        glBindBuffer(GL_COPY_READ_BUFFER, this->buffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, this->current, offset, this->currentSize);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    this->count(this->currentSize, this->currentStaged);
+}
+
+void    UploadRing::store( GLuint buffer, GLenum usage ) {
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, this->currentSize, (this->currentStaged ? this->staging.data() : nullptr), usage);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    if (this->currentStaged)
+        this->count(this->currentSize, true);
+    else
+        this->copy(buffer, 0);
+}
+
+void    UploadRing::upload( GLuint buffer, GLintptr offset, const void* data, size_t size ) {
+    if (this->mapped == nullptr || size > this->size) {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, data);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        this->count(size, true);
+        return;
+    }
+    std::memcpy(this->map(size), data, size);
+    this->copy(buffer, offset);
+}
+
+void    UploadRing::store( GLuint buffer, const void* data, size_t size, GLenum usage ) {
+    if (this->mapped == nullptr || size == 0 || size > this->size) {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, size, data, usage);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        this->count(size, true);
+        return;
+    }
+    std::memcpy(this->map(size), data, size);
+    this->store(buffer, usage);
+}
+
+void    UploadRing::count( size_t size, bool staged ) {
+    this->stats.uploads++;
+    this->stats.staged += staged;
+    this->stats.bytes += size;
+    this->frameBytes += size;
+}
+
+/* the signaled segments are released, so that the fences do not pile up while the ring does not wrap */
+void    UploadRing::endFrame( void ) {
+    this->closeSegment();
+    while (this->segments.empty() == false && glClientWaitSync(this->segments.front().fence, 0, 0) != GL_TIMEOUT_EXPIRED) {
+        glDeleteSync(this->segments.front().fence);
+        this->segments.pop_front();
+    }
+    this->stats.frames++;
+    this->stats.lastFrameBytes = this->frameBytes;
+    this->frameBytes = 0;
+}
+
+void    UploadRing::closeSegment( void ) {
+    if (this->head != this->frameBegin)
+        this->segments.push_back((segment_t){ glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), this->frameBegin, this->head });
+    this->frameBegin = this->head;
+}
+
+/* the segments are signaled in order, waiting for the newest one overlapping the range frees all the older ones */
+void    UploadRing::waitSegments( size_t begin, size_t end ) {
+    int last = -1;
+    for (size_t i = 0; i < this->segments.size(); ++i)
+        if (this->segments[i].begin < end && begin < this->segments[i].end)
+            last = i;
+    if (last < 0)
+        return;
+    GLenum status = glClientWaitSync(this->segments[last].fence, 0, 0);
+    if (status == GL_TIMEOUT_EXPIRED) {
+        tTimePoint start = std::chrono::high_resolution_clock::now();
+        while (status == GL_TIMEOUT_EXPIRED)
+            status = glClientWaitSync(this->segments[last].fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+        this->stats.stalls++;
+        this->stats.stallMs += (static_cast<tMilliseconds>(std::chrono::high_resolution_clock::now() - start)).count();
+    }
+    for (int i = 0; i <= last; ++i) {
+        glDeleteSync(this->segments.front().fence);
+        this->segments.pop_front();
+    }
+}
@@ -0,0 +1,218 @@
+#include "WorldGen.hpp"
+#include <cstdlib>
+
+static const char*  blocNames[16] = {
+    "AIR", "DIRT", "GRASS", "STONE", "BEDROCK", "COAL", "IRON", "GOLD", "LAPIS", "REDSTONE", "DIAMOND", "GRAVEL", "SAND", "OAK_WOOD", "OAK_LEAVES", "WATER"
+};
+
+WorldGen::WorldGen( const std::vector<rule_t>& rules, uint32_t seed ) : rules(rules), seed(seed) {
+    this->stats = (worldGenStats_t){ 0, 0 };
+    this->compile();
+    this->emitGlsl();
+}
+
+WorldGen::~WorldGen( void ) {
+}
+
+/* FNV-1a of the rules GLSL, which holds all their parameters, with the kernel version */
+const uint32_t  WorldGen::getGeneration( void ) const {
+    uint32_t hash = 2166136261u ^ version;
+    for (size_t i = 0; i < this->glsl.size(); ++i)
+        hash = (hash ^ static_cast<uint8_t>(this->glsl[i])) * 16777619u;
+    return hash;
+}
+
+/* the ores and underground pockets, in order of priority */
+const std::vector<rule_t>   WorldGen::defaultRules( void ) {
+    return {{
+        { "diamond",  eBloc::stone, eBloc::diamond,  { glm::vec3( 100), 0.45, 0.20, 3, 1.5, 0.38, false }, 0.1,  0.0,  0.0,  16 },
+        { "redstone", eBloc::stone, eBloc::redstone, { glm::vec3(-160), 0.45, 0.35, 3, 0.2, 0.30, false }, 0.1,  0.0,  0.0,  16 },
+        { "lapis",    eBloc::stone, eBloc::lapis,    { glm::vec3(-230), 0.55, 0.30, 3, 1.2, 0.33, false }, 0.1,  0.0,  0.0,  32 },
+        { "gold",     eBloc::stone, eBloc::gold,     { glm::vec3( 100), 0.45, 0.35, 3, 1.2, 0.33, false }, 0.1,  0.0,  0.0,  32 },
+        { "iron",     eBloc::stone, eBloc::iron,     { glm::vec3(-100), 0.45, 0.30, 3, 1.8, 0.30, false }, 0.1,  0.0,  0.0,  64 },
+        { "coal",     eBloc::stone, eBloc::coal,     { glm::vec3( 340), 0.35, 0.20, 3, 1.5, 0.37, false }, 0.1,  0.0,  0.0, 130 },
+        { "dirt",     eBloc::stone, eBloc::dirt,     { glm::vec3(  40), 0.32, 0.11, 3, 1.0, 0.50, true  }, 0.05, 0.05, 96,  256 },
+        { "gravel",   eBloc::stone, eBloc::gravel,   { glm::vec3( -70), 0.45, 0.14, 3, 1.0, 0.20, false }, 0.05, 0.05, 200, 256 },
+    }};
+}
+
+static const bool   isSameField( const field_t& a, const field_t& b ) {
+    return (a.offset == b.offset && a.amplitude == b.amplitude && a.frequency == b.frequency && a.octaves == b.octaves &&
+            a.lacunarity == b.lacunarity && a.gain == b.gain && a.ridged == b.ridged);
+}
+
+/*  build the evaluation plan: the rules are grouped by the bloc they apply to, a group is a chain of
+    exclusive rules as long as no rule of the group produces the bloc of the group.
+*/
+void    WorldGen::compile( void ) {
+    this->fields.clear();
+    this->ruleField.clear();
+    this->plan.clear();
+    for (size_t i = 0; i < this->rules.size(); ++i) {
+        const rule_t& rule = this->rules[i];
+        auto it = std::find_if(this->fields.begin(), this->fields.end(), [&rule]( const field_t& f ) { return isSameField(f, rule.field); });
+        this->ruleField.push_back(static_cast<int>(it - this->fields.begin()));
+        if (it == this->fields.end())
+            this->fields.push_back(rule.field);
+
+        bool chained = (!this->plan.empty() && this->plan.back().from == rule.from);
+        for (size_t j = 0; chained && j < this->plan.back().rules.size(); ++j)
+            chained = (this->rules[this->plan.back().rules[j]].to != rule.from);
+        if (!chained)
+            this->plan.push_back((planGroup_t){ rule.from, {} });
+        this->plan.back().rules.push_back(static_cast<int>(i));
+    }
+}
+
+/* shortest float literal that reads back to the same float value */
+static std::string  glslFloat( float f ) {
+    std::string s;
+    for (int precision = 1; precision <= 12; ++precision) {
+        std::ostringstream ss;
+        ss << std::fixed << std::setprecision(precision) << f;
+        s = ss.str();
+        if (std::strtof(s.c_str(), nullptr) == f)
+            break;
+    }
+    return s;
+}
+
+void    WorldGen::emitGlsl( void ) {
+    std::ostringstream ss;
+    ss << "/* generated from the world generation rules */\n";
+    ss << "#define WATER_LEVEL " << WorldGen::waterLevel << ".\n";
+    ss << "#define BEDROCK_CEILING " << WorldGen::bedrockCeiling << ".\n\n";
+    for (size_t i = 0; i < this->fields.size(); ++i) {
+        const field_t& f = this->fields[i];
+        std::string fbm = "fbm3d(p + vec3(" + glslFloat(f.offset.x) + ", " + glslFloat(f.offset.y) + ", " + glslFloat(f.offset.z) + "), " +
+            glslFloat(f.amplitude) + ", " + glslFloat(f.frequency) + ", " + std::to_string(f.octaves) + ", " + glslFloat(f.lacunarity) + ", " + glslFloat(f.gain) + ")";
+        ss << "float   field" << i << "( vec3 p ) {\n";
+        ss << "    return " << (f.ridged ? "ridged(" + fbm + ")" : fbm) << ";\n";
+        ss << "}\n\n";
+    }
+    ss << "float   materialRules( vec3 p, float res ) {\n";
+    for (size_t g = 0; g < this->plan.size(); ++g) {
+        ss << "    if (res == " << blocNames[static_cast<int>(this->plan[g].from)] << ") {\n";
+        for (size_t j = 0; j < this->plan[g].rules.size(); ++j) {
+            const int i = this->plan[g].rules[j];
+            const rule_t& rule = this->rules[i];
+            std::string threshold = glslFloat(rule.threshold);
+            if (rule.falloff != 0.0f)
+                threshold = "falloff(p.y, " + threshold + ", " + glslFloat(1.0f / rule.falloffHeight) + ", " + glslFloat(rule.falloff) + ")";
+            ss << "        " << (j == 0 ? "if" : "else if") << " (p.y < " << glslFloat(rule.maxHeight) << " && field" << this->ruleField[i] << "(p) < " << threshold << ")";
+            ss << " /* " << rule.name << " */\n";
+            ss << "            res = " << blocNames[static_cast<int>(rule.to)] << ";\n";
+        }
+        ss << "    }\n";
+    }
+    ss << "    return res;\n}\n";
+    this->glsl = ss.str();
+}
+
+/*  The noise functions are the same as the ones of the generation shader, and must give the same
+    floats: this file is built without fast-math nor floating-point contractions, and the operations
+    are written in the same order as in the shader.
+*/
+static uint32_t hash( uint32_t x ) {
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+const float WorldGen::hashValue( int x, int y, int z ) const {
+    uint32_t h = hash(static_cast<uint32_t>(x) ^ hash(static_cast<uint32_t>(y) ^ hash(static_cast<uint32_t>(z) ^ this->seed)));
+    return std::ldexp(static_cast<float>(h >> 8), -24);
+}
+
+static float    lerp( float a, float b, float t ) {
+    return a + (b - a) * t;
+}
+
+static float    ridged( float v ) {
+    return std::abs(v * 2.0f - 1.0f);
+}
+
+const float WorldGen::noise( const glm::vec3& x ) const {
+    glm::vec3 p = glm::vec3(std::floor(x.x), std::floor(x.y), std::floor(x.z));
+    glm::vec3 f = x - p;
+    glm::vec3 w = f * f * (3.0f - 2.0f * f);
+    const int i = static_cast<int>(p.x), j = static_cast<int>(p.y), k = static_cast<int>(p.z);
+    float x00 = lerp(this->hashValue(i, j  , k  ), this->hashValue(i+1, j  , k  ), w.x);
+    float x10 = lerp(this->hashValue(i, j+1, k  ), this->hashValue(i+1, j+1, k  ), w.x);
+    float x01 = lerp(this->hashValue(i, j  , k+1), this->hashValue(i+1, j  , k+1), w.x);
+    float x11 = lerp(this->hashValue(i, j+1, k+1), this->hashValue(i+1, j+1, k+1), w.x);
+    return lerp(lerp(x00, x10, w.y), lerp(x01, x11, w.y), w.z);
+}
+
+const float WorldGen::fbm3d( glm::vec3 st, float amplitude, float frequency, int octaves, float lacunarity, float gain ) const {
+    float value = 0.0f;
+    st *= frequency;
+    for (int i = 0; i < octaves; i++) {
+        value += amplitude * this->noise(st);
+        st *= lacunarity;
+        amplitude *= gain;
+    }
+    return value;
+}
+
+const float WorldGen::evaluate( const field_t& field, const glm::vec3& p ) const {
+    float v = this->fbm3d(p + field.offset, field.amplitude, field.frequency, field.octaves, field.lacunarity, field.gain);
+    return (field.ridged ? ridged(v) : v);
+}
+
+const bool  WorldGen::isRuleMatching( int i, const glm::vec3& p ) {
+    const rule_t& rule = this->rules[i];
+    if (!(p.y < rule.maxHeight))
+        return false;
+    float threshold = rule.threshold;
+    if (rule.falloff != 0.0f)
+        threshold = threshold + (1.0f - p.y * (1.0f / rule.falloffHeight)) * rule.falloff;
+    this->stats.fields++;
+    return (this->evaluate(this->fields[this->ruleField[i]], p) < threshold);
+}
+
+const int   WorldGen::caves( const glm::vec3& p ) const {
+    glm::vec3 q0 = glm::vec3(p.x-5, p.y*1.1f     , p.z + 21.0f);
+    glm::vec3 q1 = glm::vec3(p.z  , p.y*1.1f+4.0f, p.x - 42.0f);
+    float tunnels = (1.0f - ridged(this->fbm3d(q0, 0.45, 0.067, 5, 1.3, 0.49))) *
+                    (1.0f - ridged(this->fbm3d(q1, 0.45, 0.046, 5, 0.9, 0.49)));
+    int g2 = int(tunnels < 0.91f);
+    int g13 = int(this->fbm3d(p, 0.44, 0.04, 6, 2.0, 0.3) < 0.5f);
+    return g2 & g13;
+}
+
+const uint8_t   WorldGen::map( const glm::vec3& p ) {
+    this->stats.voxels++;
+    /* ceiling level */
+    if (p.y > 255)
+        return static_cast<uint8_t>(eBloc::air);
+    /* bedrock level */
+    if (p.y == 0 || (p.y <= WorldGen::bedrockCeiling && this->fbm3d(p, 1.0, 20.0, 2, 1.5, 0.5) * 3.0f > p.y))
+        return static_cast<uint8_t>(eBloc::bedrock);
+    /* terrain */
+    if (!(this->fbm3d(p, 0.4, 0.0075, 6, 1.7, 0.5) * 340.0f > p.y && this->fbm3d(p, 0.5, 0.0215, 4, 1.4, 0.5) * 340.0f > p.y))
+        return static_cast<uint8_t>(p.y == WorldGen::waterLevel && this->caves(p) == 1 ? eBloc::water : eBloc::air);
+    /* caves */
+    if (this->caves(p) == 0)
+        return static_cast<uint8_t>(eBloc::air);
+    /* stone */
+    glm::vec3 q = p + glm::vec3(0, 16, 0);
+    glm::vec3 r = p + glm::vec3(0, 5, 0);
+    bool stone = (this->fbm3d(q, 0.40, 0.0075, 5, 1.7, 0.5) * 340.0f > p.y && this->fbm3d(q, 0.55, 0.0215, 3, 1.4, 0.5) * 340.0f > p.y &&
+                  this->fbm3d(r, 0.40, 0.0075, 5, 1.7, 0.5) * 340.0f > p.y && this->fbm3d(r, 0.55, 0.0215, 3, 1.4, 0.5) * 340.0f > p.y);
+    eBloc res = (stone ? eBloc::stone : eBloc::dirt);
+    /* material rules */
+    for (size_t g = 0; g < this->plan.size(); ++g) {
+        if (res != this->plan[g].from)
+            continue;
+        for (size_t j = 0; j < this->plan[g].rules.size(); ++j)
+            if (this->isRuleMatching(this->plan[g].rules[j], p)) {
+                res = this->rules[this->plan[g].rules[j]].to;
+                break;
+            }
+    }
+    return static_cast<uint8_t>(res);
+}
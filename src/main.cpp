@@ -1,9 +1,18 @@
 #include "Renderer.hpp"
 #include "Env.hpp"
 
-int main( void ) {
+/* the world seed, an unsigned 32 bits integer (the values out of range are refused, not truncated) */
+static uint32_t parseSeed( const std::string& arg ) {
+    if (!std::regex_match(arg, static_cast<std::regex>("^[0-9]{1,10}$")) || std::stoull(arg) > 0xFFFFFFFFull)
+        throw Exception::InitError("invalid seed `" + arg + "`, expected an integer in [0, 4294967295]");
+    return static_cast<uint32_t>(std::stoull(arg));
+}
+
+int main( int argc, char** argv ) {
     try {
-        Env         environment;
+        /* the world seed can be given as first argument */
+        uint32_t    seed = (argc > 1 ? parseSeed(argv[1]) : 42);
+        Env         environment(seed);
         Renderer    renderer(&environment);
         renderer.loop();
     }
@@ -53,7 +53,7 @@ GLuint  loadTexture( const char* filename, GLuint textureMode ) {
             case 3: format = GL_RGB; break;
             case 4: format = GL_RGBA; break;
         };
-        glBindTexture(GL_TEXTURE_2D, textureID);
+        GLState::bindTexture(GL_TEXTURE_2D, textureID);
         glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
         glGenerateMipmap(GL_TEXTURE_2D);
 
@@ -91,7 +91,7 @@ GLuint  loadTextureSrgb( const char* filename, GLuint textureMode ) {
             case 3: format = GL_RGB; break;
             case 4: format = GL_RGBA; break;
         };
-        glBindTexture(GL_TEXTURE_2D, textureID);
+        GLState::bindTexture(GL_TEXTURE_2D, textureID);
         glTexImage2D(GL_TEXTURE_2D, 0, internal_format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
         glGenerateMipmap(GL_TEXTURE_2D);
 
@@ -113,7 +113,7 @@ GLuint  loadTextureMipmapSrgb( const std::vector<std::string>& paths ) {
     GLuint textureID;
     glGenTextures(1, &textureID);
 
-    glBindTexture(GL_TEXTURE_2D, textureID);
+    GLState::bindTexture(GL_TEXTURE_2D, textureID);
     for (int i = 0; i < paths.size(); i++) {
         int width, height, channels;
         unsigned char*  data = stbi_load(paths[i].c_str(), &width, &height, &channels, 0);
@@ -143,14 +143,14 @@ GLuint  loadTextureMipmapSrgb( const std::vector<std::string>& paths ) {
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, paths.size()-1);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    GLState::bindTexture(GL_TEXTURE_2D, 0);
     return (textureID);
 }
 
 GLuint  loadCubemap( const std::vector<std::string>& paths ) {
     GLuint textureID;
     glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+    GLState::bindTexture(GL_TEXTURE_CUBE_MAP, textureID);
 
     int width, height, channels;
     for (size_t i = 0; i < paths.size(); ++i) {
@@ -182,7 +182,7 @@ GLuint  loadCubemap( const std::vector<std::string>& paths ) {
 GLuint  loadCubemapSrgb( const std::vector<std::string>& paths ) {
     GLuint textureID;
     glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+    GLState::bindTexture(GL_TEXTURE_CUBE_MAP, textureID);
 
     int width, height, channels;
     for (size_t i = 0; i < paths.size(); ++i) {
@@ -0,0 +1,56 @@
+#include "Camera.hpp"
+#include "test.hpp"
+
+/*  The batched fustrum test (structure of arrays, see Camera::aabsInFustrum) keeps the boxes of the per chunk
+    test, over a grid of 64x4x64 chunks around the camera for a few orientations, and the time of both.
+*/
+static const int    side = 64;
+static const int    layers = 4;
+static const int    runs = 10;
+
+int main( void ) {
+    const glm::vec3 size = glm::vec3(32);
+    std::vector<float> x, y, z;
+    for (int cy = 0; cy < layers; ++cy)
+        for (int cz = 0; cz < side; ++cz)
+            for (int cx = 0; cx < side; ++cx) {
+                const glm::vec3 center = glm::vec3(cx - side / 2, cy, cz - side / 2) * size + size * 0.5f;
+                x.push_back(center.x);
+                y.push_back(center.y);
+                z.push_back(center.z);
+            }
+    Camera camera(80.0f, 16.0f / 9.0f, 0.1f, 1000.0f);
+    camera.speed = 0.0f;
+    camera.speedmod = 0.0f;
+    std::array<tKey, N_KEY> keys;
+    keys[GLFW_KEY_F].value = 1; /* the fustrum planes follow the camera */
+    tMouse mouse;
+    mouse.pos = mouse.prevPos = glm::dvec2(0);
+    double scalarMs = 0.0, batchedMs = 0.0;
+    for (int orientation = 0; orientation < 8; ++orientation) {
+        camera.handleInputs(keys, mouse);
+        std::vector<uint32_t> scalar, batched;
+        tTimePoint start = std::chrono::steady_clock::now();
+        for (int r = 0; r < runs; ++r) {
+            scalar.clear();
+            for (size_t i = 0; i < x.size(); ++i)
+                if (camera.aabInFustrum(-glm::vec3(x[i], y[i], z[i]), size))
+                    scalar.push_back(static_cast<uint32_t>(i));
+        }
+        scalarMs += static_cast<tMilliseconds>(std::chrono::steady_clock::now() - start).count() / runs;
+        start = std::chrono::steady_clock::now();
+        for (int r = 0; r < runs; ++r) {
+            batched.clear();
+            camera.aabsInFustrum(x.data(), y.data(), z.data(), size, x.size(), batched);
+        }
+        batchedMs += static_cast<tMilliseconds>(std::chrono::steady_clock::now() - start).count() / runs;
+        if (!CHECK(scalar == batched))
+            std::cerr << "orientation " << orientation << ": " << scalar.size() << " boxes in the fustrum, " << batched.size() << " batched" << std::endl;
+        CHECK(scalar.size() > 0 && scalar.size() < x.size());
+        /* turn right and look a bit down, then up */
+        mouse.prevPos = mouse.pos;
+        mouse.pos += glm::dvec2(450.0, orientation < 4 ? 60.0 : -90.0);
+    }
+    std::cout << "Fustrum: " << x.size() << " boxes, " << scalarMs / 8 * 1000.0 << "us per chunk test, " << batchedMs / 8 * 1000.0 << "us batched" << std::endl;
+    return testReport("Fustrum");
+}
@@ -0,0 +1,148 @@
+#include "FragmentGenerator.hpp"
+#include "ComputeGenerator.hpp"
+#include "WorldGen.hpp"
+#include "Shader.hpp"
+#include "glTest.hpp"
+#include "test.hpp"
+
+/*  Conformance of the GPU generation with the CPU kernel: for fixed seeds, every generated voxel of a few
+    chunks (surface, underground, bedrock, water level and sky) must be WorldGen::map at the same position,
+    with the fragment shader and, when the context has them, the compute shader.
+*/
+static const glm::ivec3 chunkSize = glm::ivec3(32);
+static const uint       margin = 4;
+
+typedef struct  screenQuad_s {
+    GLuint  vao;
+    GLuint  vbo;
+    GLuint  ebo;
+}               screenQuad_t;
+
+static screenQuad_t    createQuad( void ) {
+    const float vertices[20] = { -1,-1,0, 0,1,  1,-1,0, 1,1,  1,1,0, 1,0,  -1,1,0, 0,0 };
+    const unsigned int indices[6] = { 0, 1, 2,  2, 3, 0 };
+    screenQuad_t quad;
+    glGenVertexArrays(1, &quad.vao);
+    glGenBuffers(1, &quad.vbo);
+    glGenBuffers(1, &quad.ebo);
+    GLState::bindVertexArray(quad.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, quad.vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, quad.ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), static_cast<GLvoid*>(0));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), reinterpret_cast<GLvoid*>(3 * sizeof(float)));
+    GLState::bindVertexArray(0);
+    return quad;
+}
+
+/* the column pass of Terrain::renderColumnGeneration */
+static const std::vector<float>  evaluateColumn( Shader& shader, const screenQuad_t& quad, GLuint fbo, GLuint texture, const glm::vec3& position, int seed ) {
+    const glm::ivec3 paddedSize = chunkSize + static_cast<int>(margin);
+    std::vector<float> fields(paddedSize.x * paddedSize.z * 4);
+    GLState::bindFramebuffer(fbo);
+    GLState::viewport(0, 0, paddedSize.x, paddedSize.z);
+    shader.use();
+    shader.setFloatUniformValue("near", 0.1f);
+    shader.setVec3UniformValue("chunkPosition", position * glm::vec3(1, 0, 1));
+    shader.setIntUniformValue("margin", margin);
+    shader.setIntUniformValue("seed", seed);
+    shader.setIntUniformValue("latticePass", 0);
+    shader.setIntUniformValue("horizonPass", 0);
+    shader.setIntUniformValue("columnPass", 1);
+    GLState::bindVertexArray(quad.vao);
+    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+    GLState::bindVertexArray(0);
+    GLState::bindTexture(GL_TEXTURE_2D, texture);
+    glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_FLOAT, fields.data());
+    GLState::bindTexture(GL_TEXTURE_2D, 0);
+    GLState::bindFramebuffer(0);
+    return fields;
+}
+
+/* the voxels differing from the CPU kernel, over the chunk and its one voxel ring (the generated ones) */
+static const size_t countMismatches( WorldGen& worldGen, const glm::vec3& position, const uint8_t* voxels ) {
+    const glm::ivec3 paddedSize = chunkSize + static_cast<int>(margin);
+    const int m = margin / 2;
+    size_t mismatches = 0;
+    for (int y = -1; y < chunkSize.y + 1; ++y)
+        for (int z = -1; z < chunkSize.z + 1; ++z)
+            for (int x = -1; x < chunkSize.x + 1; ++x)
+                mismatches += (worldGen.map(position + glm::vec3(x, y, z)) != voxels[(x+m) + (z+m) * paddedSize.x + (y+m) * paddedSize.x * paddedSize.z]);
+    return mismatches;
+}
+
+int main( void ) {
+    GLFWwindow* window = testCreateContext();
+    if (window == nullptr) {
+        std::cout << "Generation: skipped (no GL context)" << std::endl;
+        return 0;
+    }
+    {
+        const glm::ivec3 paddedSize = chunkSize + static_cast<int>(margin);
+        const std::vector<glm::vec3> chunks = {
+            { 0, 64, 0 }, { 32, 96, -32 }, { -64, 64, 128 }, { 96, 32, 32 }, { 0, 0, 0 }, { 160, 64, -96 }, { -32, 224, 64 }
+        };
+        screenQuad_t quad = createQuad();
+        GLuint fbo, texture;
+        glGenFramebuffers(1, &fbo);
+        GLState::bindFramebuffer(fbo);
+        glGenTextures(1, &texture);
+        GLState::bindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, paddedSize.x, paddedSize.z, 0, GL_RGBA, GL_FLOAT, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+        GLState::bindTexture(GL_TEXTURE_2D, 0);
+        GLState::bindFramebuffer(0);
+
+        bool computeChecked = false;
+        for (uint32_t seed : { 42u, 1337u, 4000000000u }) {
+            WorldGen worldGen(WorldGen::defaultRules(), seed);
+            const std::unordered_map<std::string, std::string> pragmas = {
+                { "worldgen", Shader::getFromFile("./shader/common/worldgen.glsl") },
+                { "worldgen_rules", worldGen.getGlslSource() }
+            };
+            Shader shader("./shader/vertex/screenQuad.vert.glsl", "./shader/fragment/generateChunk.frag.glsl", pragmas);
+            std::vector<std::vector<float>> columns;
+            for (size_t i = 0; i < chunks.size(); ++i)
+                columns.push_back(evaluateColumn(shader, quad, fbo, texture, chunks[i], static_cast<int>(seed)));
+            FragmentGenerator fragment(chunkSize, margin, pragmas);
+            for (size_t i = 0; i < chunks.size(); ++i)
+                fragment.add(chunks[i], columns[i]);
+            fragment.dispatch(static_cast<int>(seed));
+            for (size_t i = 0; i < chunks.size(); ++i) {
+                const size_t mismatches = countMismatches(worldGen, chunks[i], fragment.getVoxels(i));
+                if (!CHECK(mismatches == 0))
+                    std::cerr << "seed " << seed << ", chunk " << i << ": " << mismatches << " voxels differ from the CPU kernel (fragment shader)" << std::endl;
+                CHECK(fragment.getVoxels(i)[0] == 255); /* the outer margin is border */
+            }
+            fragment.clear();
+            if (ComputeGenerator::isSupported() == false)
+                continue;
+            ComputeGenerator compute(chunkSize, margin, pragmas);
+            for (size_t i = 0; i < chunks.size(); ++i)
+                compute.add(chunks[i], columns[i]);
+            compute.dispatch(static_cast<int>(seed));
+            for (size_t i = 0; i < chunks.size(); ++i) {
+                const size_t mismatches = countMismatches(worldGen, chunks[i], compute.getVoxels(i));
+                if (!CHECK(mismatches == 0))
+                    std::cerr << "seed " << seed << ", chunk " << i << ": " << mismatches << " voxels differ from the CPU kernel (compute shader)" << std::endl;
+                CHECK(compute.getVoxels(i)[0] == 255);
+            }
+            computeChecked = true;
+        }
+        if (computeChecked == false)
+            std::cout << "Generation: compute shader skipped (no GL 4.3)" << std::endl;
+        CHECK(glGetError() == GL_NO_ERROR);
+        GLState::deleteFramebuffers(1, &fbo);
+        GLState::deleteTextures(1, &texture);
+        GLState::deleteVertexArrays(1, &quad.vao);
+        glDeleteBuffers(1, &quad.vbo);
+        glDeleteBuffers(1, &quad.ebo);
+    }
+    testDestroyContext(window);
+    return testReport("Generation");
+}
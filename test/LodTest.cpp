@@ -0,0 +1,104 @@
+#include "Chunk.hpp"
+#include "WorldGen.hpp"
+#include "glTest.hpp"
+#include "test.hpp"
+
+#include <map>
+#include <chrono>
+
+/*  The points of the meshes per lod level, over a fixed area of a fixed seed (the reference of the lod
+    reductions), and the skirts of the seams between chunks meshed at different levels.
+*/
+static const glm::ivec3 chunkSize = glm::ivec3(32);
+static const uint       margin = 4;
+static const glm::ivec3 area = glm::ivec3(5, 4, 5);
+
+/* the padded volume of Terrain::renderChunkGeneration: the chunk and its ring, the rest of the margin is border */
+static Chunk*   generateChunk( WorldGen& worldGen, const glm::vec3& position ) {
+    const glm::ivec3 paddedSize = chunkSize + static_cast<int>(margin);
+    const int m = margin / 2;
+    std::vector<uint8_t> texture(paddedSize.x * paddedSize.y * paddedSize.z, 255);
+    for (int y = -1; y < chunkSize.y + 1; ++y)
+        for (int z = -1; z < chunkSize.z + 1; ++z)
+            for (int x = -1; x < chunkSize.x + 1; ++x)
+                texture[(x+m) + (z+m) * paddedSize.x + (y+m) * paddedSize.x * paddedSize.z] = worldGen.map(position + glm::vec3(x, y, z));
+    return new Chunk(position, chunkSize, texture.data(), margin);
+}
+
+typedef std::map<std::tuple<int, int, int>, Chunk*>    chunks_t;
+
+static std::array<Chunk*, 6>    getNeighbours( chunks_t& chunks, const glm::ivec3& p ) {
+    static const std::array<glm::ivec3, 6> offsets = { glm::ivec3(1, 0, 0), glm::ivec3(-1, 0, 0), glm::ivec3(0, 1, 0), glm::ivec3(0, -1, 0), glm::ivec3(0, 0, 1), glm::ivec3(0, 0, -1) };
+    std::array<Chunk*, 6> neighbours;
+    for (int i = 0; i < 6; ++i) {
+        auto it = chunks.find(std::make_tuple(p.x + offsets[i].x, p.y + offsets[i].y, p.z + offsets[i].z));
+        neighbours[i] = (it != chunks.end() ? it->second : nullptr);
+    }
+    return neighbours;
+}
+
+int main( void ) {
+    GLFWwindow* window = testCreateContext();
+    if (window == nullptr) {
+        std::cout << "Lod: skipped (no GL context)" << std::endl;
+        return 0;
+    }
+    {
+        UploadRing ring;
+        Chunk::setUploadRing(&ring);
+        WorldGen worldGen(WorldGen::defaultRules(), 42);
+        chunks_t chunks;
+        for (int y = 0; y < area.y; ++y)
+            for (int z = 0; z < area.z; ++z)
+                for (int x = 0; x < area.x; ++x)
+                    chunks[std::make_tuple(x, y, z)] = generateChunk(worldGen, glm::vec3(glm::ivec3(x, y, z) * chunkSize));
+
+        /* the same area meshed at each level */
+        std::array<size_t, Chunk::lodLevels> points;
+        glm::ivec3 center = glm::ivec3(0);
+        uint centerPoints = 0;
+        for (int level = 0; level < Chunk::lodLevels; ++level) {
+            const auto start = std::chrono::steady_clock::now();
+            points[level] = 0;
+            for (auto& chunk : chunks)
+                chunk.second->setLodLevel(level);
+            for (auto& chunk : chunks) {
+                const glm::ivec3 p = glm::ivec3(std::get<0>(chunk.first), std::get<1>(chunk.first), std::get<2>(chunk.first));
+                chunk.second->rebuildMesh(getNeighbours(chunks, p));
+                points[level] += chunk.second->getPointsCount();
+                if (level == 0 && p.x < area.x - 1 && chunk.second->getPointsCount() > centerPoints) {
+                    center = p;
+                    centerPoints = chunk.second->getPointsCount();
+                }
+            }
+            const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            std::cout << "Lod: " << (1 << level) << "x meshes, " << points[level] << " points (" << (points[level] * 100 / points[0]) << "%), " << ms << "ms" << std::endl;
+        }
+        CHECK(points[0] > 0);
+        CHECK(points[1] < points[0] && points[2] < points[1]);
+
+        /* the seams of the surface chunk with the most points: skirts toward a neighbour at another level, none once it is back */
+        Chunk* chunk = chunks[std::make_tuple(center.x, center.y, center.z)];
+        Chunk* neighbour = chunks[std::make_tuple(center.x + 1, center.y, center.z)];
+        for (int level : { 0, 2 }) {
+            for (auto& c : chunks)
+                c.second->setLodLevel(level);
+            chunk->rebuildMesh(getNeighbours(chunks, center));
+            const uint closed = chunk->getPointsCount();
+            neighbour->setLodLevel(2 - level);
+            CHECK(chunk->isSeamOpen(neighbour) && neighbour->isSeamOpen(chunk));
+            chunk->rebuildMesh(getNeighbours(chunks, center));
+            const uint open = chunk->getPointsCount();
+            neighbour->setLodLevel(level);
+            CHECK(chunk->isSeamOpen(neighbour) == false);
+            chunk->rebuildMesh(getNeighbours(chunks, center));
+            if (!CHECK(open > closed && chunk->getPointsCount() == closed))
+                std::cerr << (1 << level) << "x chunk: " << closed << " points, " << open << " with a seam" << std::endl;
+        }
+        CHECK(glGetError() == GL_NO_ERROR);
+        for (auto& c : chunks)
+            delete c.second;
+    }
+    testDestroyContext(window);
+    return testReport("Lod");
+}
@@ -0,0 +1,43 @@
+#include "OcclusionBuffer.hpp"
+#include "test.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+/* the camera is at the origin and looks down -z, a wall of 20x20 stands between z = -11 and z = -10 */
+static void fill( OcclusionBuffer& buffer ) {
+    buffer.clear(glm::perspective(glm::radians(90.0f), 2.0f, 0.1f, 1000.0f) * glm::lookAt(glm::vec3(0), glm::vec3(0, 0, -1), glm::vec3(0, 1, 0)));
+    buffer.addOccluder(glm::vec3(-10, -10, -11), glm::vec3(10, 10, -10));
+    buffer.rasterize();
+}
+
+int main( void ) {
+    OcclusionBuffer buffer(256, 128, 1);
+    buffer.clear(glm::perspective(glm::radians(90.0f), 2.0f, 0.1f, 1000.0f) * glm::lookAt(glm::vec3(0), glm::vec3(0, 0, -1), glm::vec3(0, 1, 0)));
+    buffer.rasterize();
+    CHECK(buffer.isVisible(glm::vec3(-1, -1, -50), glm::vec3(1, 1, -48))); /* nothing occludes an empty buffer */
+
+    fill(buffer);
+    CHECK(buffer.getTrianglesCount() > 0);
+    CHECK(buffer.isVisible(glm::vec3(-1, -1, -50), glm::vec3(1, 1, -48)) == false); /* behind the wall */
+    CHECK(buffer.isVisible(glm::vec3(-4, -4, -30), glm::vec3(4, 4, -12)) == false);
+    CHECK(buffer.isVisible(glm::vec3(-1, -1, -6), glm::vec3(1, 1, -5)));            /* in front of it */
+    CHECK(buffer.isVisible(glm::vec3(-1, -1, -10.5f), glm::vec3(1, 1, -9)));        /* crosses its front face */
+    CHECK(buffer.isVisible(glm::vec3(60, -1, -50), glm::vec3(62, 1, -48)));         /* beside it */
+    CHECK(buffer.isVisible(glm::vec3(18, -1, -22), glm::vec3(24, 1, -20)));         /* partly behind its edge */
+    CHECK(buffer.isVisible(glm::vec3(-1, -1, -1), glm::vec3(1, 1, 1)));             /* crosses the near plane */
+    CHECK(buffer.isVisible(glm::vec3(-1, -1, 5), glm::vec3(1, 1, 7)));              /* behind the camera */
+    CHECK(buffer.getTileDepth(128, 64) < 1.0f && buffer.getTileDepth(0, 0) == 1.0f);
+
+    /* the bands rasterized by the workers give the same depths, frame after frame */
+    OcclusionBuffer parallel(256, 128, 4);
+    for (int frame = 0; frame < 3; ++frame) {
+        fill(parallel);
+        bool same = true;
+        for (int y = 0; y < buffer.getHeight(); ++y)
+            for (int x = 0; x < buffer.getWidth(); ++x)
+                same = same && buffer.getDepth(x, y) == parallel.getDepth(x, y) && buffer.getTileDepth(x, y) == parallel.getTileDepth(x, y);
+        CHECK(same);
+        CHECK(parallel.isVisible(glm::vec3(-1, -1, -50), glm::vec3(1, 1, -48)) == false);
+    }
+    return testReport("OcclusionBuffer");
+}
@@ -0,0 +1,59 @@
+#include "Pool.hpp"
+#include "test.hpp"
+
+#include <set>
+#include <type_traits>
+#include <cstring>
+
+/*  The pool hands out distinct cache line aligned blocks carved from its slabs, reuses the released ones
+    first, and keeps its stats in step with the blocks in use.
+*/
+int main( void ) {
+    Pool pool(100, 64 << 10);
+    CHECK(pool.getBlockSize() == 128 && pool.getSlabSize() == (64 << 10));
+    CHECK(Pool(1).getBlockSize() == 64);
+    CHECK(std::is_copy_constructible<Pool>::value == false && std::is_copy_assignable<Pool>::value == false);
+    const size_t perSlab = (64 << 10) / 128;
+
+    /* a slab and a half of blocks, each filled with its index */
+    std::vector<void*> blocks;
+    std::set<void*> distinct;
+    for (size_t i = 0; i < perSlab * 3 / 2; ++i) {
+        void* block = pool.allocate();
+        memset(block, static_cast<int>(i & 0xFF), pool.getBlockSize());
+        blocks.push_back(block);
+        distinct.insert(block);
+        CHECK(reinterpret_cast<uintptr_t>(block) % 64 == 0);
+    }
+    CHECK(distinct.size() == blocks.size());
+    size_t overwritten = 0;
+    for (size_t i = 0; i < blocks.size(); ++i)
+        for (size_t j = 0; j < pool.getBlockSize(); ++j)
+            overwritten += (static_cast<uint8_t*>(blocks[i])[j] != (i & 0xFF));
+    CHECK(overwritten == 0);
+    CHECK(pool.getStats().slabs == 2 && pool.getStats().capacity == perSlab * 2);
+    CHECK(pool.getStats().used == blocks.size() && pool.getStats().allocations == blocks.size());
+    CHECK(pool.getFragmentation() == 0.25f);
+    /* the blocks of a new slab come in address order */
+    CHECK(static_cast<uint8_t*>(blocks[1]) - static_cast<uint8_t*>(blocks[0]) == 128);
+
+    /* the last released block is the next one allocated, and no slab is added while some are free */
+    pool.release(blocks[10]);
+    pool.release(blocks[20]);
+    pool.release(nullptr);
+    CHECK(pool.getStats().releases == 2 && pool.getStats().used == blocks.size() - 2);
+    CHECK(pool.allocate() == blocks[20] && pool.allocate() == blocks[10]);
+    for (void* block : blocks)
+        pool.release(block);
+    CHECK(pool.getStats().used == 0 && pool.getFragmentation() == 1.0f);
+    for (size_t i = 0; i < perSlab * 2; ++i)
+        distinct.insert(pool.allocate());
+    CHECK(pool.getStats().slabs == 2 && distinct.size() == perSlab * 2);
+
+    /* one shared pool per size */
+    CHECK(&Pool::forSize(4096) == &Pool::forSize(4096) && &Pool::forSize(4096) != &Pool::forSize(8192));
+    void* block = Pool::forSize(4096).allocate();
+    CHECK(Pool::getPools().at(4096).getStats().used == 1 && Pool::forSize(4096).getStats().slabs == 1);
+    Pool::forSize(4096).release(block);
+    return testReport("Pool");
+}
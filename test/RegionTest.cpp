@@ -0,0 +1,132 @@
+#include "Region.hpp"
+#include "test.hpp"
+
+#include <random>
+#include <csignal>
+#include <sys/resource.h>
+
+/*  The compression and the region files give back the saved chunks: across a reopening, after smaller and
+    bigger rewrites and a compaction, not after a change of generation, and a failed write keeps the previous
+    chunk.
+*/
+static const std::string    directory = "./obj/test-regions";
+
+/* a volume of runs of blocs with some noise, as the serialized chunks */
+static std::vector<uint8_t> makeVolume( size_t size, uint32_t seed ) {
+    std::mt19937 random(seed);
+    std::vector<uint8_t> volume(size);
+    for (size_t i = 0; i < size; ) {
+        const size_t run = std::min(static_cast<size_t>(random() % 200 + 1), size - i);
+        const uint8_t bloc = static_cast<uint8_t>(random() % 16);
+        for (size_t j = 0; j < run; ++j, ++i)
+            volume[i] = (random() % 16 == 0 ? static_cast<uint8_t>(random()) : bloc);
+    }
+    return volume;
+}
+
+static const off_t   getFileSize( const std::string& path ) {
+    struct stat st;
+    return (stat(path.c_str(), &st) == 0 ? st.st_size : -1);
+}
+
+static void removeRegions( void ) {
+    for (int y = -1; y <= 0; ++y)
+        unlink((directory + "/r.0." + std::to_string(y) + ".0.vox").c_str());
+}
+
+int main( void ) {
+    /* compression */
+    for (size_t size : { 0, 1, 5, 1000, 40000 }) {
+        const std::vector<uint8_t> volume = makeVolume(size, static_cast<uint32_t>(size));
+        std::vector<uint8_t> compressed, payload, unpacked;
+        compress(volume.data(), volume.size(), compressed);
+        std::vector<uint8_t> decompressed(size);
+        CHECK(decompress(compressed.data(), compressed.size(), decompressed.data(), size) && decompressed == volume);
+        RegionStore::pack(volume, payload);
+        CHECK(RegionStore::unpack(payload.data(), payload.size(), unpacked) && unpacked == volume);
+        if (size > 0)
+            CHECK(decompress(compressed.data(), compressed.size() - 1, decompressed.data(), size) == false);
+    }
+    const std::vector<uint8_t> uniform(40000, 3);
+    std::vector<uint8_t> compressed;
+    compress(uniform.data(), uniform.size(), compressed);
+    CHECK(compressed.size() < uniform.size() / 40); /* 3 bytes per match of 131 */
+
+    /* regions */
+    removeRegions();
+    const glm::vec3 a = glm::vec3(1, 2, 3), b = glm::vec3(31, 7, 31), c = glm::vec3(4, -1, 4);
+    const std::vector<uint8_t> chunkA = makeVolume(40000, 1), chunkB = makeVolume(30000, 2), chunkC = makeVolume(20000, 3);
+    std::vector<uint8_t> data;
+    {
+        RegionStore store(directory, 42);
+        CHECK(store.isEnabled());
+        CHECK(store.load(a, data) == false);
+        CHECK(store.save(a, chunkA) && store.save(b, chunkB) && store.save(c, chunkC));
+        CHECK(store.load(a, data) && data == chunkA);
+        CHECK(store.getStats().saved == 3 && store.getOpenRegions() == 2);
+    }
+    {
+        RegionStore store(directory, 42);
+        CHECK(store.load(a, data) && data == chunkA);
+        CHECK(store.load(b, data) && data == chunkB);
+        CHECK(store.load(c, data) && data == chunkC);
+        /* smaller, then bigger */
+        const std::vector<uint8_t> smaller = makeVolume(1000, 4), bigger = makeVolume(60000, 5);
+        CHECK(store.save(a, smaller) && store.load(a, data) && data == smaller);
+        CHECK(store.save(b, bigger) && store.load(b, data) && data == bigger);
+        CHECK(store.save(a, chunkA) && store.load(a, data) && data == chunkA);
+        CHECK(store.load(b, data) && data == bigger);
+        CHECK(store.getStats().outdated == 0);
+    }
+    {
+        /* a write past the file size limit fails partway, the previous chunk stays (a smaller one too) */
+        std::signal(SIGXFSZ, SIG_IGN);
+        struct rlimit limit, previous;
+        getrlimit(RLIMIT_FSIZE, &previous);
+        limit = previous;
+        limit.rlim_cur = getFileSize(directory + "/r.0.0.0.vox") + 100;
+        setrlimit(RLIMIT_FSIZE, &limit);
+        RegionStore store(directory, 42);
+        CHECK(store.save(a, makeVolume(60000, 6)) == false);
+        CHECK(store.save(a, makeVolume(1000, 7)) == false);
+        CHECK(store.getStats().failed == 2 && store.getStats().saved == 0);
+        setrlimit(RLIMIT_FSIZE, &previous);
+        CHECK(store.load(a, data) && data == chunkA);
+        CHECK(store.save(c, chunkA) && store.load(c, data) && data == chunkA);
+    }
+    {
+        /* the replaced payloads are reclaimed when the region is opened again */
+        const std::string path = directory + "/r.0.0.0.vox";
+        {
+            RegionStore store(directory, 42);
+            for (uint32_t i = 0; i < 4; ++i)
+                CHECK(store.save(b, makeVolume(60000, 10 + i)));
+            CHECK(store.save(b, chunkB));
+        }
+        const off_t size = getFileSize(path);
+        RegionStore store(directory, 42);
+        CHECK(store.load(a, data) && data == chunkA);
+        CHECK(store.load(b, data) && data == chunkB);
+        CHECK(getFileSize(path) < size / 2 && access((path + ".tmp").c_str(), F_OK) == -1);
+        CHECK(store.save(a, chunkC) && store.load(a, data) && data == chunkC);
+    }
+    {
+        RegionStore store(directory, 42);
+        CHECK(store.load(a, data) && data == chunkC && store.load(b, data) && data == chunkB);
+    }
+    {
+        /* another generation: the regions are emptied when opened */
+        RegionStore store(directory, 43);
+        CHECK(store.load(a, data) == false && store.load(c, data) == false);
+        CHECK(store.getStats().outdated == 2);
+        CHECK(store.save(a, chunkB) && store.load(a, data) && data == chunkB);
+    }
+    {
+        RegionStore store(directory, 43);
+        CHECK(store.load(a, data) && data == chunkB);
+        CHECK(store.load(b, data) == false);
+    }
+    removeRegions();
+    rmdir(directory.c_str());
+    return testReport("Region");
+}
@@ -0,0 +1,58 @@
+#include "SpscQueue.hpp"
+#include "test.hpp"
+
+#include <thread>
+#include <memory>
+
+/*  The queue keeps the order of the pushes, refuses a push when full and a pop when empty, and hands the
+    elements over from a producer thread to a consumer thread without losing or repeating one.
+*/
+static const size_t transfers = 1 << 20;
+
+int main( void ) {
+    /* one thread */
+    SpscQueue<int> queue(5); /* rounded up to 8 */
+    int value = -1;
+    CHECK(queue.size() == 0 && queue.pop(value) == false && value == -1);
+    for (int i = 0; i < 8; ++i)
+        CHECK(queue.push(int(i)));
+    CHECK(queue.size() == 8 && queue.push(8) == false);
+    for (int i = 0; i < 8; ++i)
+        CHECK(queue.pop(value) && value == i);
+    CHECK(queue.pop(value) == false);
+    /* across the end of the slots */
+    for (int i = 0; i < 20; ++i) {
+        CHECK(queue.push(int(i)) && queue.push(int(i + 100)));
+        CHECK(queue.pop(value) && value == i && queue.pop(value) && value == i + 100);
+    }
+    CHECK(queue.size() == 0);
+
+    /* a move-only element, left untouched by a refused push */
+    SpscQueue<std::unique_ptr<int>> owners(1);
+    std::unique_ptr<int> a(new int(1)), b(new int(2)), out;
+    CHECK(owners.push(std::move(a)) && a == nullptr);
+    CHECK(owners.push(std::move(b)) == false && b != nullptr && *b == 2);
+    CHECK(owners.pop(out) && out != nullptr && *out == 1);
+
+    /* a producer and a consumer, through a small queue so that both sides wait on the other */
+    SpscQueue<size_t> transfer(64);
+    size_t received = 0, outOfOrder = 0;
+    std::thread consumer([&]() {
+        size_t v;
+        while (received < transfers) {
+            if (transfer.pop(v) == false) {
+                std::this_thread::yield();
+                continue;
+            }
+            outOfOrder += (v != received);
+            received++;
+        }
+    });
+    for (size_t i = 0; i < transfers; ++i)
+        while (transfer.push(size_t(i)) == false)
+            std::this_thread::yield();
+    consumer.join();
+    CHECK(received == transfers && outOfOrder == 0);
+    CHECK(transfer.size() == 0);
+    return testReport("SpscQueue");
+}
@@ -0,0 +1,33 @@
+#include "WorldGen.hpp"
+#include "test.hpp"
+
+/* the CPU kernel only depends on the seed and the position: same seed, same world (and same rules shader) */
+int main( void ) {
+    WorldGen a(WorldGen::defaultRules(), 42);
+    WorldGen b(WorldGen::defaultRules(), 42);
+    WorldGen c(WorldGen::defaultRules(), 43);
+    CHECK(a.getGlslSource() == b.getGlslSource());
+    size_t same = 0, differ = 0, solid = 0, samples = 0;
+    for (int y = 0; y < 160; y += 3)
+        for (int z = -96; z < 96; z += 5)
+            for (int x = -96; x < 96; x += 5) {
+                const glm::vec3 p = glm::vec3(x, y, z);
+                const uint8_t bloc = a.map(p);
+                same += (bloc == b.map(p));
+                differ += (bloc != c.map(p));
+                solid += (bloc != static_cast<uint8_t>(eBloc::air));
+                samples++;
+            }
+    CHECK(same == samples);
+    CHECK(differ > 0);
+    CHECK(solid > 0 && solid < samples);
+    CHECK(a.getStats().voxels == samples);
+    /* the repeated evaluation of a position gives the same bloc */
+    for (int i = 0; i < 64; ++i) {
+        const glm::vec3 p = glm::vec3(i * 7 - 200, 40 + i, 13 - i * 11);
+        CHECK(a.map(p) == a.map(p));
+    }
+    CHECK(a.map(glm::vec3(5, 0, -3)) == static_cast<uint8_t>(eBloc::bedrock));
+    CHECK(a.map(glm::vec3(5, 300, -3)) == static_cast<uint8_t>(eBloc::air));
+    return testReport("WorldGen");
+}
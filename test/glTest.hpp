@@ -0,0 +1,38 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <iostream>
+
+/*  The context of the GL tests: a hidden window with the hints of Env. Headless, they run on a software
+    renderer (e.g. `LIBGL_ALWAYS_SOFTWARE=1 xvfb-run make test` on Linux). Without a context a test is
+    skipped, not failed.
+*/
+static GLFWwindow*  testCreateContext( void ) {
+    if (!glfwInit())
+        return nullptr;
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 0);
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+    GLFWwindow* window = glfwCreateWindow(64, 64, "ft_vox test", NULL, NULL);
+    if (window == nullptr) {
+        glfwTerminate();
+        return nullptr;
+    }
+    glfwMakeContextCurrent(window);
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return nullptr;
+    }
+    std::cout << "context: " << glGetString(GL_RENDERER) << ", " << glGetString(GL_VERSION) << std::endl;
+    return window;
+}
+
+static void testDestroyContext( GLFWwindow* window ) {
+    glfwDestroyWindow(window);
+    glfwTerminate();
+}
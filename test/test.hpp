@@ -0,0 +1,23 @@
+#pragma once
+
+#include <iostream>
+
+/*  The tests are plain executables (see the test rule of the Makefile), a failed check is printed and the
+    executable returns 1. They link the objects of the classes they test, the CPU ones need no context.
+*/
+static int  testFailures = 0;
+
+#define CHECK(condition) testCheck((condition), #condition, __FILE__, __LINE__)
+
+static inline const bool    testCheck( const bool passed, const char* condition, const char* file, int line ) {
+    if (passed == false) {
+        std::cerr << file << ":" << line << ": check failed: " << condition << std::endl;
+        testFailures++;
+    }
+    return passed;
+}
+
+static inline int   testReport( const char* name ) {
+    std::cout << name << ": " << (testFailures == 0 ? "ok" : "FAILED") << std::endl;
+    return (testFailures == 0 ? 0 : 1);
+}